@@ -0,0 +1,63 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstdint>
+
+namespace ns3
+{
+
+// Read/write a 16 bit field in network byte order
+inline uint16_t ReadNet16(const uint8_t* p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline void WriteNet16(uint8_t* p, uint16_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value & 0xff);
+}
+
+// Incrementally update a ones-complement checksum after a 16 bit field
+// changed from oldValue to newValue (RFC 1624, eqn. 3): HC' = ~(~HC + ~m + m')
+inline uint16_t ChecksumAdjust(uint16_t checksum, uint16_t oldValue, uint16_t newValue)
+{
+    uint32_t sum = static_cast<uint16_t>(~checksum);
+    sum += static_cast<uint16_t>(~oldValue);
+    sum += newValue;
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return static_cast<uint16_t>(~sum);
+}
+
+// Overwrite the 16 bit field at offset and patch the checksum at csumOffset to match
+inline void PatchNet16(uint8_t* bytes, uint32_t offset, uint16_t value, uint32_t csumOffset)
+{
+    uint16_t old = ReadNet16(bytes + offset);
+    if (old == value)
+    {
+        return;
+    }
+    WriteNet16(bytes + offset, value);
+    WriteNet16(bytes + csumOffset, ChecksumAdjust(ReadNet16(bytes + csumOffset), old, value));
+}
+
+// Ones-complement sum of size bytes (RFC 1071), folded to 16 bits, continuing from sum
+inline uint16_t ChecksumSum(const uint8_t* data, uint32_t size, uint32_t sum = 0)
+{
+    for (uint32_t i = 0; i + 1 < size; i += 2)
+    {
+        sum += ReadNet16(data + i);
+    }
+    if (size & 1)
+    {
+        sum += data[size - 1] << 8;
+    }
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return static_cast<uint16_t>(sum);
+}
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef COLUMN_FILE_H
+#define COLUMN_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// On-disk format of columnar result tables (hop-stats.col): an 8 byte magic, the column
+// and row counts, one descriptor per column, then each column's values back to back.
+// Every value is 8 bytes in host byte order, so a column loads with a single read, e.g.
+// numpy.frombuffer(data, dtype, rows, offset). Kept free of ns-3 headers so offline tools
+// can read it.
+
+namespace ns3
+{
+
+static const char COLUMN_FILE_MAGIC[8] = {'R', 'A', 'W', 'C', 'O', 'L', 'S', '1'};
+
+enum ColumnType : uint8_t
+{
+    COLUMN_U64 = 0,
+    COLUMN_I64 = 1,
+    COLUMN_F64 = 2,
+};
+
+struct ColumnFileHeader
+{
+    char magic[8];      // COLUMN_FILE_MAGIC
+    uint32_t columns;   // Descriptors following the header
+    uint32_t rows;      // Values per column
+};
+
+struct ColumnDescriptor
+{
+    char name[23];      // NUL padded
+    uint8_t type;       // ColumnType
+    uint64_t offset;    // File offset of the column's first value
+};
+
+static_assert(sizeof(ColumnFileHeader) == 16, "ColumnFileHeader must stay 16 bytes");
+static_assert(sizeof(ColumnDescriptor) == 32, "ColumnDescriptor must stay 32 bytes");
+
+// Builds a table column by column, values are stored as their 8 byte patterns
+class ColumnWriter {
+    public:
+        explicit ColumnWriter(uint32_t rows) : m_rows(rows) {}
+
+        // Append a zero filled column, returns its index
+        uint32_t AddColumn(const char* name, ColumnType type)
+        {
+            ColumnDescriptor desc{};
+            std::strncpy(desc.name, name, sizeof(desc.name) - 1);
+            desc.type = type;
+            m_descs.push_back(desc);
+            m_data.resize(m_data.size() + m_rows);
+            return m_descs.size() - 1;
+        }
+
+        // Values of a column, valid until the next AddColumn
+        uint64_t* Column(uint32_t column)
+        {
+            return m_data.data() + static_cast<std::size_t>(column) * m_rows;
+        }
+
+        bool Write(const std::string& path)
+        {
+            FILE* out = std::fopen(path.c_str(), "wb");
+            if (!out)
+            {
+                return false;
+            }
+            ColumnFileHeader header{};
+            std::memcpy(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic));
+            header.columns = m_descs.size();
+            header.rows = m_rows;
+            uint64_t offset = sizeof(header) + m_descs.size() * sizeof(ColumnDescriptor);
+            for (ColumnDescriptor& desc : m_descs)
+            {
+                desc.offset = offset;
+                offset += m_rows * sizeof(uint64_t);
+            }
+            bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+            ok = ok && std::fwrite(m_descs.data(), sizeof(ColumnDescriptor), m_descs.size(), out) == m_descs.size();
+            ok = ok && std::fwrite(m_data.data(), sizeof(uint64_t), m_data.size(), out) == m_data.size();
+            return std::fclose(out) == 0 && ok;
+        }
+
+        static uint64_t Bits(double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+    private:
+        uint32_t m_rows;                        // Values per column
+        std::vector<ColumnDescriptor> m_descs;  // Column names and types
+        std::vector<uint64_t> m_data;           // Columns back to back
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "Distributed.h"
+#include "FlowStats.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+
+#include <mpi.h>
+#endif
+
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Distributed");
+
+Distributed& Distributed::Get()
+{
+    static Distributed instance;
+    return instance;
+}
+
+Distributed::Distributed()
+{
+    m_enabled = false;
+    m_rank = 0;
+    m_size = 1;
+}
+
+bool Distributed::Enable(int* argc, char*** argv, std::string& error)
+{
+#ifdef NS3_MPI
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(argc, argv);
+    m_enabled = true;
+    m_rank = MpiInterface::GetSystemId();
+    m_size = MpiInterface::GetSize();
+    return true;
+#else
+    error = "this build has no MPI support, configure with -DENABLE_MPI=ON against an ns-3 built with MPI";
+    return false;
+#endif
+}
+
+void Distributed::Disable()
+{
+#ifdef NS3_MPI
+    if (m_enabled)
+    {
+        MpiInterface::Disable();
+        m_enabled = false;
+    }
+#endif
+}
+
+bool Distributed::IsEnabled() const
+{
+    return m_enabled;
+}
+
+uint32_t Distributed::GetRank() const
+{
+    return m_rank;
+}
+
+uint32_t Distributed::GetSize() const
+{
+    return m_size;
+}
+
+bool Distributed::IsRoot() const
+{
+    return m_rank == 0;
+}
+
+uint64_t Distributed::Sum(uint64_t value) const
+{
+#ifdef NS3_MPI
+    if (m_enabled)
+    {
+        unsigned long long local = value;
+        unsigned long long total = 0;
+        MPI_Reduce(&local, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MpiInterface::GetCommunicator());
+        return total;
+    }
+#endif
+    return value;
+}
+
+double Distributed::Max(double value) const
+{
+#ifdef NS3_MPI
+    if (m_enabled)
+    {
+        double total = 0;
+        MPI_Reduce(&value, &total, 1, MPI_DOUBLE, MPI_MAX, 0, MpiInterface::GetCommunicator());
+        return total;
+    }
+#endif
+    return value;
+}
+
+// Flows are sparse per rank (a rank only holds the senders and receivers on its own nodes),
+// so ranks send what they have to rank 0 rather than reducing a table of every flow
+void Distributed::GatherFlowStats() const
+{
+#ifdef NS3_MPI
+    if (!m_enabled || m_size < 2)
+    {
+        return;
+    }
+    MPI_Comm comm = MpiInterface::GetCommunicator();
+    if (!IsRoot())
+    {
+        std::vector<uint64_t> words;
+        FlowStats::Get().Save(words);
+        unsigned long long count = words.size();
+        MPI_Send(&count, 1, MPI_UNSIGNED_LONG_LONG, 0, 0, comm);
+        MPI_Send(words.data(), static_cast<int>(words.size()), MPI_UINT64_T, 0, 1, comm);
+        return;
+    }
+    std::vector<uint64_t> words;
+    for (uint32_t rank = 1; rank < m_size; rank++)
+    {
+        unsigned long long count = 0;
+        MPI_Recv(&count, 1, MPI_UNSIGNED_LONG_LONG, rank, 0, comm, MPI_STATUS_IGNORE);
+        words.resize(count);
+        MPI_Recv(words.data(), static_cast<int>(count), MPI_UINT64_T, rank, 1, comm, MPI_STATUS_IGNORE);
+        FlowStats::Get().Merge(words.data(), words.size());
+    }
+#endif
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "ns3/core-module.h"
+
+#include <string>
+
+namespace ns3
+{
+
+// Distributed runs over MPI: every rank builds the whole network but only simulates the
+// nodes assigned to it (see Topology::SetRanks), exchanging frames over the point to point
+// links between ranks. The delay of those links is the lookahead that lets ranks run ahead
+// of each other. Needs ns-3 and this program built with MPI (NS3_MPI), otherwise Enable fails.
+class Distributed {
+    public:
+        static Distributed& Get();
+
+        // Initialize MPI and select the distributed simulator, before anything touches the simulator.
+        // Returns false with a reason in error if this build or ns-3 lacks MPI.
+        bool Enable(int* argc, char*** argv, std::string& error);
+        // Shut MPI down, after Simulator::Destroy
+        void Disable();
+
+        bool IsEnabled() const;
+        uint32_t GetRank() const;
+        uint32_t GetSize() const;
+        bool IsRoot() const;
+
+        // Totals over all ranks, valid on rank 0 only
+        uint64_t Sum(uint64_t value) const;
+        double Max(double value) const;
+        // Merge every rank's flow statistics into rank 0's
+        void GatherFlowStats() const;
+
+    private:
+        Distributed();
+
+        bool m_enabled;     // MPI is initialized
+        uint32_t m_rank;    // This process' rank, 0 when not distributed
+        uint32_t m_size;    // Number of ranks, 1 when not distributed
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef DROP_RECORD_H
+#define DROP_RECORD_H
+
+#include <cstdint>
+
+// On-disk format of the binary drop log (node-drops.bin): an 8 byte magic followed by
+// fixed size records in host byte order. Kept free of ns-3 headers so offline tools can
+// read it.
+
+namespace ns3
+{
+
+static const char DROP_LOG_MAGIC[8] = {'R', 'A', 'W', 'D', 'R', 'O', 'P', '1'};
+
+// Where in the device a packet was dropped
+enum DropReason : uint8_t
+{
+    DROP_MAC_TX = 0,    // Refused by the device on send, includes full transmit queues
+    DROP_PHY_TX = 1,    // Dropped by the transmitter, e.g. backoff attempts exhausted
+    DROP_PHY_RX = 2,    // Dropped by the receiver
+    DROP_QUEUE = 3,     // Dropped by the device's DropTailQueue (also counted as DROP_MAC_TX)
+    DROP_REASON_COUNT = 4,
+};
+
+// Record flags
+enum DropFlags : uint8_t
+{
+    DROP_FLAG_BRIDGE_PORT = 1,  // Device is a port of a bridge (switch) device
+};
+
+struct DropRecord
+{
+    uint64_t timeNs;    // Simulation time of the drop
+    uint32_t nodeId;    // Node id
+    uint16_t device;    // Device index on the node
+    uint8_t reason;     // DropReason
+    uint8_t flags;      // DropFlags
+};
+
+static_assert(sizeof(DropRecord) == 16, "DropRecord must stay 16 bytes");
+
+inline const char* DropReasonName(uint8_t reason)
+{
+    switch (reason)
+    {
+    case DROP_MAC_TX:
+        return "MacTxDrop";
+    case DROP_PHY_TX:
+        return "PhyTxDrop";
+    case DROP_PHY_RX:
+        return "PhyRxDrop";
+    case DROP_QUEUE:
+        return "QueueDrop";
+    default:
+        return "Unknown";
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,187 @@
+#include "DropStats.h"
+#include "FastSwitchNetDevice.h"
+
+#include "ns3/csma-module.h"
+#include "ns3/bridge-module.h"
+
+#include <set>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("DropStats");
+
+DropStats& DropStats::Get()
+{
+    static DropStats instance;
+    return instance;
+}
+
+DropStats::DropStats()
+{
+    m_file = nullptr;
+}
+
+void DropStats::Open(const std::string& path)
+{
+    Close();
+    m_buffer.reserve(CHUNK_RECORDS);
+    if (path.empty())
+    {
+        return;
+    }
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+    {
+        NS_LOG_UNCOND("Could not open drop log " << path);
+        return;
+    }
+    std::fwrite(DROP_LOG_MAGIC, 1, sizeof(DROP_LOG_MAGIC), m_file);
+    // Whatever is still buffered goes out when the simulator is torn down
+    Simulator::ScheduleDestroy(&DropStats::Close, this);
+}
+
+void DropStats::Attach(NodeContainer nodes)
+{
+    for (uint32_t n = 0; n < nodes.GetN(); n++)
+    {
+        Ptr<Node> node = nodes.Get(n);
+
+        // Ports of a bridge are flagged so switch drops can be told apart from endpoint drops
+        std::set<Ptr<NetDevice>> bridgePorts;
+        for (uint32_t i = 0; i < node->GetNDevices(); i++)
+        {
+            Ptr<BridgeNetDevice> bridge = DynamicCast<BridgeNetDevice>(node->GetDevice(i));
+            if (bridge)
+            {
+                for (uint32_t p = 0; p < bridge->GetNBridgePorts(); p++)
+                {
+                    bridgePorts.insert(bridge->GetBridgePort(p));
+                }
+            }
+            Ptr<FastSwitchNetDevice> fastSwitch = DynamicCast<FastSwitchNetDevice>(node->GetDevice(i));
+            if (fastSwitch)
+            {
+                for (uint32_t p = 0; p < fastSwitch->GetNPorts(); p++)
+                {
+                    bridgePorts.insert(fastSwitch->GetPort(p));
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < node->GetNDevices(); i++)
+        {
+            Ptr<CsmaNetDevice> csma = DynamicCast<CsmaNetDevice>(node->GetDevice(i));
+            if (!csma)
+            {
+                continue;
+            }
+            uint32_t slot = m_slots.size();
+            uint8_t flags = bridgePorts.count(csma) ? DROP_FLAG_BRIDGE_PORT : 0;
+            m_slots.push_back(DeviceSlot{node->GetId(), static_cast<uint16_t>(i), flags});
+            m_counts.resize(m_slots.size() * DROP_REASON_COUNT, 0);
+
+            uint32_t key = slot * DROP_REASON_COUNT;
+            csma->TraceConnectWithoutContext("MacTxDrop", MakeBoundCallback(&DropStats::OnDrop, key + DROP_MAC_TX));
+            csma->TraceConnectWithoutContext("PhyTxDrop", MakeBoundCallback(&DropStats::OnDrop, key + DROP_PHY_TX));
+            csma->TraceConnectWithoutContext("PhyRxDrop", MakeBoundCallback(&DropStats::OnDrop, key + DROP_PHY_RX));
+            csma->GetQueue()->TraceConnectWithoutContext("Drop", MakeBoundCallback(&DropStats::OnDrop, key + DROP_QUEUE));
+        }
+    }
+}
+
+void DropStats::OnDrop(uint32_t key, Ptr<const Packet> pkt)
+{
+    Get().Record(key / DROP_REASON_COUNT, key % DROP_REASON_COUNT);
+}
+
+void DropStats::Record(uint32_t slot, uint8_t reason)
+{
+    m_counts[slot * DROP_REASON_COUNT + reason]++;
+    if (!m_file)
+    {
+        return;
+    }
+    const DeviceSlot& dev = m_slots[slot];
+    m_buffer.push_back(DropRecord{static_cast<uint64_t>(Simulator::Now().GetNanoSeconds()), dev.nodeId, dev.device, reason, dev.flags});
+    if (m_buffer.size() == CHUNK_RECORDS)
+    {
+        Flush();
+    }
+}
+
+void DropStats::Flush()
+{
+    if (m_file && !m_buffer.empty())
+    {
+        std::fwrite(m_buffer.data(), sizeof(DropRecord), m_buffer.size(), m_file);
+    }
+    m_buffer.clear();
+}
+
+void DropStats::Close()
+{
+    if (m_file)
+    {
+        Flush();
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+uint64_t DropStats::GetCount(uint32_t nodeId, uint32_t device, DropReason reason) const
+{
+    for (uint32_t slot = 0; slot < m_slots.size(); slot++)
+    {
+        if (m_slots[slot].nodeId == nodeId && m_slots[slot].device == device)
+        {
+            return m_counts[slot * DROP_REASON_COUNT + reason];
+        }
+    }
+    return 0;
+}
+
+uint64_t DropStats::GetNodeTotal(uint32_t nodeId) const
+{
+    uint64_t total = 0;
+    for (uint32_t slot = 0; slot < m_slots.size(); slot++)
+    {
+        if (m_slots[slot].nodeId == nodeId)
+        {
+            total += m_counts[slot * DROP_REASON_COUNT + DROP_MAC_TX] + m_counts[slot * DROP_REASON_COUNT + DROP_PHY_TX] +
+                     m_counts[slot * DROP_REASON_COUNT + DROP_PHY_RX];
+        }
+    }
+    return total;
+}
+
+uint64_t DropStats::GetTotal() const
+{
+    uint64_t total = 0;
+    for (uint32_t slot = 0; slot < m_slots.size(); slot++)
+    {
+        total += m_counts[slot * DROP_REASON_COUNT + DROP_MAC_TX] + m_counts[slot * DROP_REASON_COUNT + DROP_PHY_TX] +
+                 m_counts[slot * DROP_REASON_COUNT + DROP_PHY_RX];
+    }
+    return total;
+}
+
+void DropStats::Print(std::ostream& os) const
+{
+    for (uint32_t slot = 0; slot < m_slots.size(); slot++)
+    {
+        const uint64_t* counts = &m_counts[slot * DROP_REASON_COUNT];
+        if (counts[DROP_MAC_TX] + counts[DROP_PHY_TX] + counts[DROP_PHY_RX] == 0)
+        {
+            continue;
+        }
+        os << "Node " << m_slots[slot].nodeId << " device " << m_slots[slot].device
+           << (m_slots[slot].flags & DROP_FLAG_BRIDGE_PORT ? " (bridge port)" : "") << " drops:";
+        for (uint32_t reason = 0; reason < DROP_REASON_COUNT; reason++)
+        {
+            os << " " << DropReasonName(reason) << " " << counts[reason];
+        }
+        os << std::endl;
+    }
+}
+
+}
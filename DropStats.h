@@ -0,0 +1,65 @@
+#ifndef DROP_STATS_H
+#define DROP_STATS_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "DropRecord.h"
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+// Drop accounting for every CSMA device, bridge port and device queue. Trace sinks are
+// bound to a dense device slot, so a drop is one counter increment plus one record
+// appended to an in-memory buffer. The buffer is written out in large chunks and at
+// Simulator::Destroy, never per drop.
+class DropStats {
+    public:
+        static DropStats& Get();
+
+        // Start the binary drop log, an empty path keeps counters only
+        void Open(const std::string& path);
+        // Hook the drop traces of all CSMA devices (and their queues) on nodes
+        void Attach(NodeContainer nodes);
+
+        // Drops of one reason at one device, and all drops at a node (queue drops are part of MacTxDrop)
+        uint64_t GetCount(uint32_t nodeId, uint32_t device, DropReason reason) const;
+        uint64_t GetNodeTotal(uint32_t nodeId) const;
+        uint64_t GetTotal() const;
+
+        // Per device counters for every device that dropped anything
+        void Print(std::ostream& os) const;
+
+        // Write out buffered records and close the log
+        void Close();
+
+    private:
+        struct DeviceSlot
+        {
+            uint32_t nodeId;
+            uint16_t device;
+            uint8_t flags;
+        };
+
+        DropStats();
+
+        // Trace sink, key packs the device slot and the drop reason
+        static void OnDrop(uint32_t key, Ptr<const Packet> pkt);
+        void Record(uint32_t slot, uint8_t reason);
+        void Flush();
+
+        static const uint32_t CHUNK_RECORDS = 65536;    // Records buffered per write (1 MiB)
+
+        std::vector<DeviceSlot> m_slots;    // Hooked devices
+        std::vector<uint64_t> m_counts;     // slot * DROP_REASON_COUNT + reason
+        std::vector<DropRecord> m_buffer;   // Records not yet written
+        FILE* m_file;                       // Binary log, null when not logging
+};
+
+}
+
+#endif
@@ -0,0 +1,420 @@
+#include "Emulation.h"
+#include "Checksum.h"
+#include "Topology.h"
+
+#include "ns3/fd-net-device-module.h"
+#include "ns3/internet-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Emulation");
+
+namespace {
+
+const uint32_t EMU_MAGIC = 0x454d5531;     // "EMU1"
+const uint32_t PAYLOAD_OFFSET = 14 + 20 + 8;
+
+// Payload of a generated frame, after the Ethernet, IPv4 and UDP headers
+struct EmuPayload
+{
+    uint32_t magic;     // EMU_MAGIC
+    uint32_t port;      // Sending port
+    uint32_t step;      // Rate step it was sent in
+    uint32_t reserved;
+    uint64_t seq;       // Per generator sequence number
+    int64_t sentNs;     // Steady clock send time
+};
+
+int64_t WallNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Ipv4Address EndpointAddress(Ptr<NetDevice> device)
+{
+    Ptr<Ipv4> ipv4 = device->GetNode()->GetObject<Ipv4>();
+    return ipv4->GetAddress(ipv4->GetInterfaceForDevice(device), 0).GetLocal();
+}
+
+}
+
+Emulation& Emulation::Get()
+{
+    static Emulation instance;
+    return instance;
+}
+
+Emulation::Emulation()
+    : m_enabled(false),
+      m_wallStartNs(0),
+      m_missed(0),
+      m_stepMissed(),
+      m_stepLagMax(),
+      m_goNs(0),
+      m_halt(false)
+{
+}
+
+Emulation::~Emulation()
+{
+    Stop();
+}
+
+void Emulation::Enable(const EmulationConfig& config)
+{
+    m_enabled = true;
+    m_config = config;
+    m_config.steps = std::min(std::max<uint32_t>(m_config.steps, 1), MAX_STEPS);
+    m_config.frameSize = std::max<uint32_t>(m_config.frameSize, PAYLOAD_OFFSET + sizeof(EmuPayload));
+    // In its default best effort mode a simulation that falls behind keeps going, the probes measure by how much
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+}
+
+bool Emulation::IsEnabled() const
+{
+    return m_enabled;
+}
+
+Mac48Address Emulation::GeneratorMac(uint32_t node)
+{
+    uint8_t bytes[6] = {0x02, 0x45, 0, 0, static_cast<uint8_t>(node >> 8), static_cast<uint8_t>(node)};
+    Mac48Address mac;
+    mac.CopyFrom(bytes);
+    return mac;
+}
+
+bool Emulation::Attach(Ptr<Node> endpoint, const std::string& ifname, std::string& error)
+{
+    NS_ABORT_MSG_IF(!m_enabled, "Emulation::Attach before Enable");
+    auto port = std::make_unique<Port>();
+    port->node = endpoint->GetId();
+    port->ifname = ifname;
+    port->endpoint = Topology::GetEndpointDevice(endpoint);
+    if (ifname.empty())
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) < 0)
+        {
+            error = std::string("socketpair: ") + std::strerror(errno);
+            return false;
+        }
+        FdNetDeviceHelper helper;
+        port->fd = helper.Install(endpoint).Get(0);
+        DynamicCast<FdNetDevice>(port->fd)->SetFileDescriptor(fds[0]);
+        port->socket = fds[1];
+    }
+    else
+    {
+        // Opens a raw socket on the interface, which needs root or CAP_NET_RAW
+        EmuFdNetDeviceHelper helper;
+        helper.SetDeviceName(ifname);
+        port->fd = helper.Install(endpoint).Get(0);
+    }
+    uint32_t index = m_ports.size();
+    port->endpoint->SetPromiscReceiveCallback(MakeBoundCallback(&Emulation::FromNetwork, index));
+    port->fd->SetPromiscReceiveCallback(MakeBoundCallback(&Emulation::FromOutside, index));
+    m_ports.push_back(std::move(port));
+    return true;
+}
+
+bool Emulation::FromNetwork(uint32_t port, Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol,
+                            const Address& from, const Address& to, NetDevice::PacketType type)
+{
+    // Only what the switch sent this way for someone else, the endpoint's own frames stay with it
+    if (type != NetDevice::PACKET_OTHERHOST && type != NetDevice::PACKET_BROADCAST)
+    {
+        return true;
+    }
+    Port& p = *Get().m_ports[port];
+    p.toOutside++;
+    p.fd->SendFrom(pkt->Copy(), from, to, protocol);
+    return true;
+}
+
+bool Emulation::FromOutside(uint32_t port, Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol,
+                            const Address& from, const Address& to, NetDevice::PacketType type)
+{
+    Port& p = *Get().m_ports[port];
+    p.fromOutside++;
+    p.endpoint->SendFrom(pkt->Copy(), from, to, protocol);
+    return true;
+}
+
+void Emulation::Start(Time stop)
+{
+    m_stop = stop;
+    // Socketpair generators send round robin to the next socketpair endpoint
+    std::vector<uint32_t> generators;
+    for (uint32_t i = 0; i < m_ports.size(); i++)
+    {
+        if (m_ports[i]->socket >= 0)
+        {
+            generators.push_back(i);
+        }
+    }
+    for (size_t g = 0; generators.size() > 1 && g < generators.size(); g++)
+    {
+        Port& port = *m_ports[generators[g]];
+        Port& peer = *m_ports[generators[(g + 1) % generators.size()]];
+        port.peer = generators[(g + 1) % generators.size()];
+
+        // Ethernet, IPv4 and UDP headers, the UDP checksum is left out
+        std::vector<uint8_t>& frame = port.frame;
+        frame.assign(m_config.frameSize, 0);
+        GeneratorMac(peer.node).CopyTo(frame.data());
+        GeneratorMac(port.node).CopyTo(frame.data() + 6);
+        WriteNet16(frame.data() + 12, 0x0800);
+        uint8_t* ip = frame.data() + 14;
+        ip[0] = 0x45;
+        WriteNet16(ip + 2, m_config.frameSize - 14);
+        ip[8] = 64;
+        ip[9] = 17;
+        EndpointAddress(port.endpoint).Serialize(ip + 12);
+        EndpointAddress(peer.endpoint).Serialize(ip + 16);
+        WriteNet16(ip + 10, static_cast<uint16_t>(~ChecksumSum(ip, 20)));
+        uint8_t* udp = ip + 20;
+        WriteNet16(udp, 9000);
+        WriteNet16(udp + 2, 9000);
+        WriteNet16(udp + 4, m_config.frameSize - 34);
+    }
+
+    m_halt.store(false);
+    m_goNs.store(0);
+    for (uint32_t i = 0; i < m_ports.size(); i++)
+    {
+        if (m_ports[i]->socket >= 0)
+        {
+            m_ports[i]->thread = std::thread(&Emulation::Generate, this, i);
+        }
+    }
+    Simulator::ScheduleNow(&Emulation::Probe, this);
+    if (generators.size() > 1)
+    {
+        Simulator::Schedule(m_config.start, &Emulation::Go, this);
+    }
+    Simulator::Stop(stop);
+}
+
+void Emulation::Stop()
+{
+    m_halt.store(true);
+    for (auto& port : m_ports)
+    {
+        if (port->thread.joinable())
+        {
+            port->thread.join();
+        }
+        if (port->socket >= 0)
+        {
+            close(port->socket);
+            port->socket = -1;
+        }
+    }
+}
+
+int32_t Emulation::StepAt(Time t) const
+{
+    if (t < m_config.start)
+    {
+        return -1;
+    }
+    return static_cast<int32_t>((t - m_config.start).GetNanoSeconds() / m_config.step.GetNanoSeconds());
+}
+
+void Emulation::Probe()
+{
+    int64_t now = WallNs();
+    int64_t sim = Simulator::Now().GetNanoSeconds();
+    if (m_wallStartNs == 0)
+    {
+        m_wallStartNs = now - sim;
+    }
+    uint64_t lag = static_cast<uint64_t>(std::max<int64_t>(now - m_wallStartNs - sim, 0));
+    m_lag.Record(lag);
+    int32_t step = StepAt(Simulator::Now());
+    bool missed = lag > static_cast<uint64_t>(m_config.deadline.GetNanoSeconds());
+    m_missed += missed;
+    if (step >= 0 && static_cast<uint32_t>(step) < m_config.steps)
+    {
+        m_stepMissed[step] += missed;
+        m_stepLagMax[step] = std::max(m_stepLagMax[step], lag);
+    }
+    if (Simulator::Now() + m_config.probe < m_stop)
+    {
+        Simulator::Schedule(m_config.probe, &Emulation::Probe, this);
+    }
+}
+
+void Emulation::Go()
+{
+    m_goNs.store(WallNs(), std::memory_order_release);
+}
+
+void Emulation::Generate(uint32_t index)
+{
+    Port& port = *m_ports[index];
+    bool sending = port.frame.size() > 0;
+    std::vector<uint8_t> rx(65536);
+    int64_t stepNs = m_config.step.GetNanoSeconds();
+    uint32_t step = 0;
+    uint64_t stepSent = 0;
+    uint64_t seq = 0;
+    double rate = m_config.rate;
+    while (!m_halt.load(std::memory_order_relaxed))
+    {
+        // Send every frame due by now, a full socket means the simulation is not reading fast enough
+        int64_t now = WallNs();
+        int64_t go = m_goNs.load(std::memory_order_acquire);
+        int64_t wait = 1000000;
+        if (sending && go && step < m_config.steps)
+        {
+            int64_t stepStart = go + step * stepNs;
+            if (now >= stepStart + stepNs)
+            {
+                step++;
+                stepSent = 0;
+                rate *= m_config.ramp;
+                continue;
+            }
+            uint64_t due = static_cast<uint64_t>(rate * (now - stepStart) / 1e9);
+            for (; stepSent < due; stepSent++)
+            {
+                EmuPayload payload{EMU_MAGIC, index, step, 0, seq++, WallNs()};
+                std::memcpy(port.frame.data() + PAYLOAD_OFFSET, &payload, sizeof(payload));
+                port.offered[step]++;
+                if (send(port.socket, port.frame.data(), port.frame.size(), MSG_DONTWAIT) < 0)
+                {
+                    port.refused[step]++;
+                }
+            }
+            int64_t next = stepStart + static_cast<int64_t>((stepSent + 1) * 1e9 / rate);
+            wait = std::min(wait, std::max<int64_t>(next - WallNs(), 0));
+        }
+
+        // Receive what the simulation delivered
+        ssize_t size;
+        while ((size = recv(port.socket, rx.data(), rx.size(), MSG_DONTWAIT)) > 0)
+        {
+            EmuPayload payload;
+            if (static_cast<size_t>(size) < PAYLOAD_OFFSET + sizeof(payload))
+            {
+                port.invalid++;
+                continue;
+            }
+            std::memcpy(&payload, rx.data() + PAYLOAD_OFFSET, sizeof(payload));
+            if (payload.magic != EMU_MAGIC || payload.port >= m_ports.size() || payload.step >= MAX_STEPS)
+            {
+                port.invalid++;
+                continue;
+            }
+            m_ports[payload.port]->received[payload.step].fetch_add(1, std::memory_order_relaxed);
+            port.delay.Record(static_cast<uint64_t>(std::max<int64_t>(WallNs() - payload.sentNs, 0)));
+        }
+
+        struct pollfd pfd = {port.socket, POLLIN, 0};
+        struct timespec timeout = {static_cast<time_t>(wait / 1000000000), static_cast<long>(wait % 1000000000)};
+        ppoll(&pfd, 1, &timeout, nullptr);
+    }
+}
+
+Emulation::StepTotals Emulation::Totals(uint32_t step) const
+{
+    StepTotals totals;
+    for (const auto& port : m_ports)
+    {
+        if (port->frame.empty())
+        {
+            continue;
+        }
+        totals.generators++;
+        totals.offered += port->offered[step];
+        totals.refused += port->refused[step];
+        totals.received += port->received[step].load();
+    }
+    totals.rate = m_config.rate * std::pow(m_config.ramp, step) * totals.generators;
+    totals.sustained = totals.offered && totals.received >= totals.offered && m_stepMissed[step] == 0;
+    return totals;
+}
+
+double Emulation::SustainedRate() const
+{
+    double rate = 0;
+    for (uint32_t s = 0; s < m_config.steps && Totals(s).sustained; s++)
+    {
+        rate = Totals(s).rate;
+    }
+    return rate;
+}
+
+void Emulation::Print(std::ostream& os) const
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    os << std::fixed << std::setprecision(3);
+    os << "Realtime: " << m_lag.GetCount() << " lag probes every " << m_config.probe.GetMicroSeconds() / 1e3
+       << " ms, lag ms mean " << m_lag.GetMean() / 1e6 << " p99 " << m_lag.Percentile(0.99) / 1e6 << " max "
+       << m_lag.GetMax() / 1e6 << ", " << m_missed << " missed deadlines (lag over "
+       << m_config.deadline.GetMicroSeconds() / 1e3 << " ms)" << std::endl;
+
+    for (const auto& port : m_ports)
+    {
+        os << "Emulated n" << port->node << " on " << (port->ifname.empty() ? "socketpair" : port->ifname) << ": "
+           << port->fromOutside << " frames in, " << port->toOutside << " frames out";
+        if (port->delay.GetCount())
+        {
+            os << ", " << port->invalid << " not generated, delay ms p50 " << port->delay.Percentile(0.5) / 1e6
+               << " p99 " << port->delay.Percentile(0.99) / 1e6 << " max " << port->delay.GetMax() / 1e6;
+        }
+        os << std::endl;
+    }
+
+    // Steps add up over all generators
+    bool all = true;
+    for (uint32_t s = 0; s < m_config.steps; s++)
+    {
+        StepTotals totals = Totals(s);
+        if (!totals.offered)
+        {
+            continue;
+        }
+        all = all && totals.sustained;
+        double loss = 100.0 * (totals.offered - std::min(totals.received, totals.offered)) / totals.offered;
+        os << "    step " << s << ": " << totals.rate << " frames/s offered, " << totals.offered << " sent, " << totals.received
+           << " delivered, " << totals.refused << " refused, " << loss << "% loss, lag max " << m_stepLagMax[s] / 1e6
+           << " ms, " << m_stepMissed[s] << " missed deadlines" << std::endl;
+    }
+    if (Totals(0).offered)
+    {
+        os << "Max sustainable rate: " << SustainedRate() << " frames/s of " << m_config.frameSize << " bytes"
+           << (all ? ", every step was sustained, raise --emuRate or --emuRamp" : "") << std::endl;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+void Emulation::WriteSummary(std::ostream& os) const
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    os << "rt_lag_mean_ms " << m_lag.GetMean() / 1e6 << "\n"
+       << "rt_lag_p99_ms " << m_lag.Percentile(0.99) / 1e6 << "\n"
+       << "rt_lag_max_ms " << m_lag.GetMax() / 1e6 << "\n"
+       << "rt_missed_deadlines " << m_missed << "\n"
+       << "emu_max_fps " << SustainedRate() << "\n";
+}
+
+}
@@ -0,0 +1,133 @@
+#ifndef EMULATION_H
+#define EMULATION_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+// Real time runs and traffic from outside the simulator
+struct EmulationConfig
+{
+    Time probe = MilliSeconds(1);       // Period of the lag probe
+    Time deadline = MilliSeconds(1);    // Lag beyond which a probe counts as a missed deadline
+    Time start = Seconds(1);            // Generators start sending at this simulation time
+    Time step = Seconds(1);             // Generators keep each rate this long
+    double rate = 1000;                 // Frames/s each generator sends in the first step
+    double ramp = 2;                    // Rate factor from one step to the next, 1 keeps the rate
+    uint32_t steps = 1;                 // Rate steps, at most MAX_STEPS
+    uint32_t frameSize = 128;           // Generated Ethernet frame size without FCS
+};
+
+// Runs the simulation against the wall clock (RealtimeSimulatorImpl, best effort) and measures
+// how far it falls behind: a probe event every config.probe compares the wall clock time since
+// the start with the simulation time, a probe running more than config.deadline late is a
+// missed deadline. Endpoints can additionally be bridged to a file descriptor device. An
+// endpoint on a socketpair gets a generator thread that sends timestamped UDP frames in
+// steps of increasing rate to the next such endpoint and receives the frames sent to it. A
+// step is sustained if nothing was lost and no deadline was missed. An endpoint on a local
+// interface (tap or veth) exchanges frames with whatever runs on it. The endpoint keeps its
+// own apps, the bridge only carries frames addressed to the outside.
+class Emulation {
+    public:
+        static const uint32_t MAX_STEPS = 64;
+
+        static Emulation& Get();
+
+        // Select the real time simulator, before anything touches the simulator
+        void Enable(const EmulationConfig& config);
+        bool IsEnabled() const;
+
+        // Bridge endpoint to a new socketpair driven by a generator, or to the local interface
+        // ifname if it is not empty. Returns false with a reason in error.
+        bool Attach(Ptr<Node> endpoint, const std::string& ifname, std::string& error);
+        // Schedule the probes and the generator start, end the run at stop. Generators stop
+        // after their last step, the caller leaves time between that and stop for the frames in flight.
+        void Start(Time stop);
+        // Stop and join the generator threads, after Simulator::Run
+        void Stop();
+
+        // Lag, missed deadlines and the rate steps of the generators
+        void Print(std::ostream& os) const;
+        // Totals as key value lines, nothing if disabled
+        void WriteSummary(std::ostream& os) const;
+
+    private:
+        // One bridged endpoint. Counters of the sending generator are only written by its thread,
+        // received is written by the thread of the receiving endpoint.
+        struct Port
+        {
+            uint32_t node = 0;                                  // Endpoint node id
+            std::string ifname;                                 // Local interface, empty for a socketpair
+            Ptr<NetDevice> endpoint;                            // The endpoint's CSMA device
+            Ptr<NetDevice> fd;                                  // File descriptor device on the endpoint
+            int socket = -1;                                    // Generator end of the socketpair
+            uint32_t peer = 0;                                  // Port the generator sends to
+            std::vector<uint8_t> frame;                         // Frame template towards the peer
+            uint64_t offered[MAX_STEPS] = {};                   // Frames due per step
+            uint64_t refused[MAX_STEPS] = {};                   // Frames the full socket refused per step
+            std::atomic<uint64_t> received[MAX_STEPS] = {};     // Frames of this generator received by its peer per step
+            LatencyHistogram delay;                             // Wall clock one way delay of frames received here, in ns
+            uint64_t invalid = 0;                               // Frames received here that were not generated
+            uint64_t toOutside = 0;                             // Frames bridged from the network to the fd device
+            uint64_t fromOutside = 0;                           // Frames bridged from the fd device to the network
+            std::thread thread;                                 // Generator and receiver
+        };
+
+        // Generator totals of one rate step
+        struct StepTotals
+        {
+            uint32_t generators = 0;
+            double rate = 0;            // Frames/s offered by all generators
+            uint64_t offered = 0;
+            uint64_t refused = 0;
+            uint64_t received = 0;
+            bool sustained = false;     // Nothing lost, no deadline missed
+        };
+
+        Emulation();
+        ~Emulation();
+
+        // A frame for the outside arrived at the endpoint, or a frame from the outside at the fd device
+        static bool FromNetwork(uint32_t port, Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol,
+                                const Address& from, const Address& to, NetDevice::PacketType type);
+        static bool FromOutside(uint32_t port, Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol,
+                                const Address& from, const Address& to, NetDevice::PacketType type);
+        void Probe();
+        // Record the wall clock start and release the generators
+        void Go();
+        // Generator thread body
+        void Generate(uint32_t port);
+        // Generator MAC of an endpoint, locally administered
+        static Mac48Address GeneratorMac(uint32_t node);
+        // Step a simulation time falls in, -1 before the generators start
+        int32_t StepAt(Time t) const;
+        StepTotals Totals(uint32_t step) const;
+        // Offered rate of the last step before the first one that was not sustained
+        double SustainedRate() const;
+
+        bool m_enabled;                             // Running in real time
+        EmulationConfig m_config;                   // Probe and generator settings
+        std::vector<std::unique_ptr<Port>> m_ports; // Bridged endpoints
+        Time m_stop;                                // End of the run
+        int64_t m_wallStartNs;                      // Wall clock at simulation time 0, steady clock ns
+        LatencyHistogram m_lag;                     // Lag of every probe, in ns
+        uint64_t m_missed;                          // Probes later than the deadline
+        uint64_t m_stepMissed[MAX_STEPS];           // Missed deadlines per step
+        uint64_t m_stepLagMax[MAX_STEPS];           // Largest lag per step, in ns
+        std::atomic<int64_t> m_goNs;                // Wall clock of the generator start, 0 until then
+        std::atomic<bool> m_halt;                   // Set by Stop, the generator threads exit
+};
+
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include "EventLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("EventLog");
+
+EventLog& EventLog::Get()
+{
+    static EventLog instance;
+    return instance;
+}
+
+EventLog::EventLog()
+    : m_mode(EVENTS_TEXT),
+      m_counts(),
+      m_mask(0),
+      m_wakeMask(0),
+      m_head(0),
+      m_tail(0),
+      m_stop(false),
+      m_file(nullptr),
+      m_stalls(0),
+      m_written(0)
+{
+}
+
+EventLog::~EventLog()
+{
+    Close();
+}
+
+bool EventLog::Open(EventLogMode mode, const std::string& path, uint32_t ringRecords)
+{
+    Close();
+    m_mode = mode;
+    m_path.clear();
+    if (mode != EVENTS_BINARY)
+    {
+        return true;
+    }
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+    {
+        m_mode = EVENTS_QUIET;
+        return false;
+    }
+    m_path = path;
+    std::fwrite(EVENT_LOG_MAGIC, 1, sizeof(EVENT_LOG_MAGIC), m_file);
+
+    uint64_t size = 1024;
+    while (size < ringRecords)
+    {
+        size *= 2;
+    }
+    m_ring.assign(size, EventRecord());
+    m_mask = size - 1;
+    // Wake the writer each quarter ring, it has the other three quarters of slack
+    m_wakeMask = size / 4 - 1;
+    m_head.store(0);
+    m_tail.store(0);
+    m_stop.store(false);
+    m_writer = std::thread(&EventLog::Drain, this);
+    // Whatever is still in the ring goes out when the simulator is torn down
+    Simulator::ScheduleDestroy(&EventLog::Close, this);
+    return true;
+}
+
+void EventLog::Close()
+{
+    if (!m_writer.joinable())
+    {
+        return;
+    }
+    m_stop.store(true, std::memory_order_release);
+    m_wake.notify_one();
+    m_writer.join();
+    std::fclose(m_file);
+    m_file = nullptr;
+    // Nothing drains the ring any more
+    m_mode = EVENTS_QUIET;
+}
+
+uint64_t EventLog::GetCount(EventType type) const
+{
+    return m_counts[type];
+}
+
+void EventLog::WriteText(const EventRecord& record) const
+{
+    double time = record.timeNs / 1e9;
+    switch (record.type)
+    {
+    case EVENT_TX:
+        NS_LOG_UNCOND("Node " << record.nodeId << " sent Packet " << record.seq << " at time " << time << "s");
+        break;
+    case EVENT_RX:
+        NS_LOG_UNCOND("Node " << record.nodeId << " received packet " << record.seq << " of size " << record.size << " at time " << time << "s");
+        break;
+    case EVENT_TX_FAIL:
+        NS_LOG_UNCOND("Error in Sending");
+        break;
+    case EVENT_MSG_TX:
+        NS_LOG_UNCOND("Node " << record.nodeId << " sent message " << record.seq << " of " << record.size << " bytes at time " << time << "s");
+        break;
+    case EVENT_MSG_RX:
+        NS_LOG_UNCOND("Node " << record.nodeId << " reassembled message " << record.seq << " of " << record.size << " bytes at time " << time << "s");
+        break;
+    }
+}
+
+void EventLog::WaitForSpace(uint64_t head)
+{
+    m_stalls++;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake.notify_one();
+    // Notifications are sent without the lock and can be missed, so recheck periodically
+    while (head - m_tail.load(std::memory_order_acquire) > m_mask)
+    {
+        m_space.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
+
+void EventLog::Drain()
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        if (head == tail)
+        {
+            if (m_stop.load(std::memory_order_acquire))
+            {
+                // Records published before stop was set are visible now, take them too
+                if (m_head.load(std::memory_order_acquire) == tail)
+                {
+                    break;
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(20));
+            continue;
+        }
+        // Up to the end of the buffer in one write, a wrapped remainder goes in the next round
+        uint64_t start = tail & m_mask;
+        uint64_t count = std::min(head - tail, m_ring.size() - start);
+        std::fwrite(&m_ring[start], sizeof(EventRecord), count, m_file);
+        tail += count;
+        m_written += count;
+        m_tail.store(tail, std::memory_order_release);
+        m_space.notify_one();
+    }
+    std::fflush(m_file);
+}
+
+void EventLog::Print(std::ostream& os) const
+{
+    os << "Events:";
+    for (uint8_t type = 0; type < EVENT_TYPE_COUNT; type++)
+    {
+        os << " " << EventTypeName(type) << " " << m_counts[type];
+    }
+    if (!m_path.empty())
+    {
+        os << ", " << m_written << " records written to " << m_path << ", " << m_stalls << " stalls waiting for the writer";
+    }
+    os << std::endl;
+}
+
+}
@@ -0,0 +1,101 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "ns3/core-module.h"
+#include "EventRecord.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+enum EventLogMode
+{
+    EVENTS_QUIET,       // Per type counters only
+    EVENTS_TEXT,        // Counters plus one formatted log line per event
+    EVENTS_BINARY,      // Counters plus fixed size records written by a background thread
+};
+
+// Per frame send/receive events. The counters are always kept. In binary mode, records go into
+// a preallocated single producer / single consumer ring that a writer thread drains to a file
+// in large writes, so the simulation thread never formats or writes anything. If the writer
+// falls a whole ring behind, the simulation waits for it rather than losing records.
+class EventLog {
+    public:
+        static EventLog& Get();
+
+        // Select the mode, path and ring size (records, rounded up to a power of two) are used in binary mode
+        bool Open(EventLogMode mode, const std::string& path, uint32_t ringRecords);
+        // Stop the writer after it drained the ring and close the file, later events are only counted
+        void Close();
+
+        void Record(EventType type, uint32_t nodeId, uint32_t flowId, uint32_t seq, uint32_t size);
+
+        uint64_t GetCount(EventType type) const;
+        // Counters, plus what the writer did in binary mode
+        void Print(std::ostream& os) const;
+
+    private:
+        EventLog();
+        ~EventLog();
+
+        void WriteText(const EventRecord& record) const;
+        // Block until the writer made room for one record
+        void WaitForSpace(uint64_t head);
+        // Writer thread body
+        void Drain();
+
+        EventLogMode m_mode;                    // What Record does beyond counting
+        uint64_t m_counts[EVENT_TYPE_COUNT];    // Events by type
+        std::vector<EventRecord> m_ring;        // Power of two sized record ring
+        uint64_t m_mask;                        // m_ring.size() - 1
+        uint64_t m_wakeMask;                    // The writer is woken whenever the record count is a multiple of m_wakeMask + 1
+        std::atomic<uint64_t> m_head;           // Records produced, written only by the simulation thread
+        std::atomic<uint64_t> m_tail;           // Records written out, written only by the writer
+        std::atomic<bool> m_stop;               // Set by Close, the writer exits once the ring is empty
+        std::mutex m_mutex;                     // Only guards the condition variable waits
+        std::condition_variable m_wake;         // Records are waiting for the writer
+        std::condition_variable m_space;        // The writer freed ring slots
+        std::thread m_writer;                   // Drains the ring to m_file
+        FILE* m_file;                           // Binary log, null unless in binary mode
+        std::string m_path;                     // Where the binary log goes, empty if not in binary mode
+        uint64_t m_stalls;                      // Records that had to wait for the writer
+        uint64_t m_written;                     // Records written by the writer, valid after Close
+};
+
+inline void EventLog::Record(EventType type, uint32_t nodeId, uint32_t flowId, uint32_t seq, uint32_t size)
+{
+    m_counts[type]++;
+    if (m_mode == EVENTS_QUIET)
+    {
+        return;
+    }
+    EventRecord record{static_cast<uint64_t>(Simulator::Now().GetNanoSeconds()), nodeId, flowId, seq, size, type, {}};
+    if (m_mode == EVENTS_TEXT)
+    {
+        WriteText(record);
+        return;
+    }
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) > m_mask)
+    {
+        WaitForSpace(head);
+    }
+    m_ring[head & m_mask] = record;
+    m_head.store(head + 1, std::memory_order_release);
+    if (((head + 1) & m_wakeMask) == 0)
+    {
+        m_wake.notify_one();
+    }
+}
+
+}
+
+#endif
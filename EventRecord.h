@@ -0,0 +1,60 @@
+#ifndef EVENT_RECORD_H
+#define EVENT_RECORD_H
+
+#include <cstdint>
+
+// On-disk format of the binary event log (events.bin): an 8 byte magic followed by
+// fixed size records in host byte order. Kept free of ns-3 headers so offline tools can
+// read it.
+
+namespace ns3
+{
+
+static const char EVENT_LOG_MAGIC[8] = {'R', 'A', 'W', 'E', 'V', 'T', '0', '1'};
+
+// What happened to a frame or message
+enum EventType : uint8_t
+{
+    EVENT_TX = 0,           // Frame handed to the device
+    EVENT_RX = 1,           // Frame delivered to its receiver
+    EVENT_TX_FAIL = 2,      // Frame refused by the device
+    EVENT_MSG_TX = 3,       // All frames of a segmented message handed to the device
+    EVENT_MSG_RX = 4,       // Segmented message reassembled
+    EVENT_TYPE_COUNT = 5,
+};
+
+struct EventRecord
+{
+    uint64_t timeNs;    // Simulation time of the event
+    uint32_t nodeId;    // Node the event happened on
+    uint32_t flowId;    // Flow id, UINT32_MAX for frames without a probe
+    uint32_t seq;       // Frame or message sequence number within the flow
+    uint32_t size;      // Frame or message bytes
+    uint8_t type;       // EventType
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(EventRecord) == 32, "EventRecord must stay 32 bytes");
+
+inline const char* EventTypeName(uint8_t type)
+{
+    switch (type)
+    {
+    case EVENT_TX:
+        return "tx";
+    case EVENT_RX:
+        return "rx";
+    case EVENT_TX_FAIL:
+        return "tx_fail";
+    case EVENT_MSG_TX:
+        return "msg_tx";
+    case EVENT_MSG_RX:
+        return "msg_rx";
+    default:
+        return "unknown";
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,488 @@
+#include "FastSwitchNetDevice.h"
+
+#include "ns3/csma-module.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("FastSwitchNetDevice");
+NS_OBJECT_ENSURE_REGISTERED(FastSwitchNetDevice);
+
+TypeId FastSwitchNetDevice::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FastSwitchNetDevice")
+                        .SetParent<NetDevice>()
+                        .AddConstructor<FastSwitchNetDevice>()
+                        ;
+    return tid;
+}
+
+FastSwitchNetDevice::FastSwitchNetDevice()
+{
+    m_ifIndex = 0;
+    m_mtu = 1500;
+    m_cutThrough = false;
+    m_cutThroughBytes = 64;
+    m_expiration = Seconds(300);
+    m_queueSize = 1000;
+    m_table.assign(64, Entry{EMPTY, NO_PORT, 0});
+    m_used = 0;
+    m_forwarded = 0;
+    m_flooded = 0;
+    m_filtered = 0;
+}
+
+FastSwitchNetDevice::~FastSwitchNetDevice()
+{
+}
+
+void FastSwitchNetDevice::DoDispose()
+{
+    for (Port& port : m_ports)
+    {
+        Simulator::Cancel(port.drain);
+    }
+    m_ports.clear();
+    m_portByIfIndex.clear();
+    m_node = nullptr;
+    m_rxCallback = NetDevice::ReceiveCallback();
+    m_promiscRxCallback = NetDevice::PromiscReceiveCallback();
+    NetDevice::DoDispose();
+}
+
+void FastSwitchNetDevice::SetLatency(Time latency)
+{
+    m_latency = latency;
+}
+
+void FastSwitchNetDevice::SetCutThrough(bool cutThrough, uint32_t cutThroughBytes)
+{
+    m_cutThrough = cutThrough;
+    m_cutThroughBytes = cutThroughBytes;
+}
+
+void FastSwitchNetDevice::SetExpirationTime(Time expiration)
+{
+    m_expiration = expiration;
+}
+
+void FastSwitchNetDevice::SetQueueSize(uint32_t frames)
+{
+    m_queueSize = std::max<uint32_t>(frames, 1);
+}
+
+void FastSwitchNetDevice::AddPort(Ptr<NetDevice> port)
+{
+    NS_ABORT_MSG_IF(!port->SupportsSendFrom(), "Switch ports must support SendFrom");
+    Attach(port, false);
+}
+
+void FastSwitchNetDevice::AddTrunk(Ptr<NetDevice> trunk)
+{
+    Attach(trunk, true);
+}
+
+void FastSwitchNetDevice::Attach(Ptr<NetDevice> port, bool trunk)
+{
+    NS_ABORT_MSG_IF(port->GetNode() != m_node, "Switch ports must be devices of the switch's node");
+    if (m_ports.empty())
+    {
+        // Like a bridge, the switch takes the address of its first port
+        m_address = Mac48Address::ConvertFrom(port->GetAddress());
+    }
+
+    Port entry;
+    entry.device = port;
+    entry.trunk = trunk;
+    Ptr<CsmaChannel> channel = DynamicCast<CsmaChannel>(port->GetChannel());
+    DataRateValue rate;
+    if (channel)
+    {
+        entry.bitRate = channel->GetDataRate().GetBitRate();
+    }
+    else if (port->GetAttributeFailSafe("DataRate", rate))
+    {
+        entry.bitRate = rate.Get().GetBitRate();
+    }
+    if (port->GetIfIndex() >= m_portByIfIndex.size())
+    {
+        m_portByIfIndex.resize(port->GetIfIndex() + 1, NO_PORT);
+    }
+    m_portByIfIndex[port->GetIfIndex()] = m_ports.size();
+    m_ports.push_back(entry);
+
+    m_node->RegisterProtocolHandler(MakeCallback(&FastSwitchNetDevice::ReceiveFromPort, this), 0, port, true);
+}
+
+uint32_t FastSwitchNetDevice::GetNPorts() const
+{
+    return m_ports.size();
+}
+
+Ptr<NetDevice> FastSwitchNetDevice::GetPort(uint32_t n) const
+{
+    return m_ports[n].device;
+}
+
+void FastSwitchNetDevice::ReceiveFromPort(Ptr<NetDevice> incoming, Ptr<const Packet> pkt, uint16_t protocol,
+                                          const Address& src, const Address& dst, PacketType packetType)
+{
+    uint32_t inPort = m_portByIfIndex[incoming->GetIfIndex()];
+    if (m_ports[inPort].trunk)
+    {
+        // The link's addresses mean nothing, the frame's own header follows
+        Ptr<Packet> frame = pkt->Copy();
+        EthernetHeader eth(false);
+        frame->RemoveHeader(eth);
+        Learn(eth.GetSource(), inPort);
+        Forward(inPort, frame, eth.GetLengthType(), eth.GetSource(), eth.GetDestination());
+        return;
+    }
+    Mac48Address src48 = Mac48Address::ConvertFrom(src);
+    Mac48Address dst48 = Mac48Address::ConvertFrom(dst);
+
+    if (!m_promiscRxCallback.IsNull())
+    {
+        m_promiscRxCallback(this, pkt, protocol, src, dst, packetType);
+    }
+    Learn(src48, inPort);
+
+    if (dst48 == m_address)
+    {
+        if (!m_rxCallback.IsNull())
+        {
+            m_rxCallback(this, pkt, protocol, src);
+        }
+        return;
+    }
+    if (dst48.IsGroup() && !m_rxCallback.IsNull())
+    {
+        m_rxCallback(this, pkt, protocol, src);
+    }
+    Forward(inPort, pkt, protocol, src48, dst48);
+}
+
+void FastSwitchNetDevice::Forward(uint32_t inPort, Ptr<const Packet> pkt, uint16_t protocol, Mac48Address src, Mac48Address dst)
+{
+    Time hold = Hold(inPort, pkt->GetSize());
+    if (!dst.IsGroup())
+    {
+        uint32_t out = Lookup(dst);
+        if (out != NO_PORT)
+        {
+            if (out == inPort)
+            {
+                m_filtered++;
+                return;
+            }
+            m_forwarded++;
+            Output(out, pkt, protocol, src, dst, hold);
+            return;
+        }
+    }
+    m_flooded++;
+    for (uint32_t port = 0; port < m_ports.size(); port++)
+    {
+        if (port != inPort)
+        {
+            Output(port, pkt, protocol, src, dst, hold);
+        }
+    }
+}
+
+Time FastSwitchNetDevice::Hold(uint32_t inPort, uint32_t bytes) const
+{
+    if (!m_cutThrough || inPort >= m_ports.size() || m_ports[inPort].bitRate == 0)
+    {
+        return m_latency;
+    }
+    // The ingress port already spent the time to receive the frame's tail (Ethernet header
+    // and trailer included), which a cut-through switch overlaps with forwarding
+    uint64_t wireBytes = bytes + 18;
+    if (wireBytes <= m_cutThroughBytes)
+    {
+        return m_latency;
+    }
+    Time credit = NanoSeconds((wireBytes - m_cutThroughBytes) * 8 * 1000000000ULL / m_ports[inPort].bitRate);
+    return Max(m_latency - credit, Seconds(0));
+}
+
+void FastSwitchNetDevice::Output(uint32_t port, Ptr<const Packet> pkt, uint16_t protocol, Mac48Address src, Mac48Address dst, Time hold)
+{
+    Port& p = m_ports[port];
+    if (p.count == 0 && !hold.IsStrictlyPositive())
+    {
+        Transmit(p, pkt->Copy(), src, dst, protocol);
+        return;
+    }
+    if (p.fifo.empty())
+    {
+        p.fifo.resize(m_queueSize);
+    }
+    if (p.count == p.fifo.size())
+    {
+        p.fifoDrops++;
+        return;
+    }
+
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    p.lastReadyNs = std::max(now + hold.GetNanoSeconds(), p.lastReadyNs);
+    p.fifo[(p.head + p.count) % p.fifo.size()] = Pending{pkt->Copy(), src, dst, protocol, p.lastReadyNs};
+    p.count++;
+    if (!p.drain.IsPending())
+    {
+        p.drain = Simulator::Schedule(NanoSeconds(p.lastReadyNs - now), &FastSwitchNetDevice::Drain, this, port);
+    }
+}
+
+void FastSwitchNetDevice::Drain(uint32_t port)
+{
+    Port& p = m_ports[port];
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    while (p.count && p.fifo[p.head].readyNs <= now)
+    {
+        Pending& frame = p.fifo[p.head];
+        Transmit(p, frame.pkt, frame.src, frame.dst, frame.protocol);
+        frame.pkt = nullptr;
+        p.head = (p.head + 1) % p.fifo.size();
+        p.count--;
+    }
+    if (p.count)
+    {
+        p.drain = Simulator::Schedule(NanoSeconds(p.fifo[p.head].readyNs - now), &FastSwitchNetDevice::Drain, this, port);
+    }
+}
+
+void FastSwitchNetDevice::Transmit(Port& port, Ptr<Packet> pkt, Mac48Address src, Mac48Address dst, uint16_t protocol)
+{
+    bool sent;
+    if (port.trunk)
+    {
+        EthernetHeader eth(false);
+        eth.SetSource(src);
+        eth.SetDestination(dst);
+        eth.SetLengthType(protocol);
+        pkt->AddHeader(eth);
+        // Point to point links only frame IP protocol numbers, the real one is in the header
+        sent = port.device->Send(pkt, port.device->GetBroadcast(), 0x0800);
+    }
+    else
+    {
+        sent = port.device->SendFrom(pkt, src, dst, protocol);
+    }
+    if (sent)
+    {
+        port.txFrames++;
+    }
+    else
+    {
+        port.deviceDrops++;
+    }
+}
+
+uint64_t FastSwitchNetDevice::MacKey(Mac48Address mac)
+{
+    uint8_t bytes[6];
+    mac.CopyTo(bytes);
+    uint64_t key = 0;
+    for (uint8_t b : bytes)
+    {
+        key = (key << 8) | b;
+    }
+    return key;
+}
+
+// Linear probing from a Fibonacci hash of the key
+uint32_t FastSwitchNetDevice::FindSlot(uint64_t key) const
+{
+    uint32_t mask = m_table.size() - 1;
+    uint32_t i = static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (m_table[i].mac != EMPTY && m_table[i].mac != key)
+    {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void FastSwitchNetDevice::Grow()
+{
+    std::vector<Entry> old;
+    old.swap(m_table);
+    m_table.assign(old.size() * 2, Entry{EMPTY, NO_PORT, 0});
+    for (const Entry& entry : old)
+    {
+        if (entry.mac != EMPTY)
+        {
+            m_table[FindSlot(entry.mac)] = entry;
+        }
+    }
+}
+
+void FastSwitchNetDevice::Learn(Mac48Address mac, uint32_t port)
+{
+    if (mac.IsGroup() || port == NO_PORT)
+    {
+        return;
+    }
+    if ((m_used + 1) * 2 > m_table.size())
+    {
+        Grow();
+    }
+    uint64_t key = MacKey(mac);
+    Entry& entry = m_table[FindSlot(key)];
+    if (entry.mac == EMPTY)
+    {
+        m_used++;
+    }
+    entry = Entry{key, port, (Simulator::Now() + m_expiration).GetNanoSeconds()};
+}
+
+uint32_t FastSwitchNetDevice::Lookup(Mac48Address mac) const
+{
+    const Entry& entry = m_table[FindSlot(MacKey(mac))];
+    if (entry.mac == EMPTY || entry.expireNs <= Simulator::Now().GetNanoSeconds())
+    {
+        return NO_PORT;
+    }
+    return entry.port;
+}
+
+void FastSwitchNetDevice::Print(std::ostream& os) const
+{
+    uint64_t fifoDrops = 0;
+    uint64_t deviceDrops = 0;
+    for (const Port& port : m_ports)
+    {
+        fifoDrops += port.fifoDrops;
+        deviceDrops += port.deviceDrops;
+    }
+    os << "Switch n" << m_node->GetId() << ": forwarded " << m_forwarded << ", flooded " << m_flooded
+       << ", filtered " << m_filtered << ", " << m_used << " MACs in " << m_table.size() << " slots, "
+       << fifoDrops << " output FIFO drops, " << deviceDrops << " device drops" << std::endl;
+}
+
+// NetDevice boilerplate, the switch itself has no channel and sends by forwarding
+
+void FastSwitchNetDevice::SetIfIndex(const uint32_t index)
+{
+    m_ifIndex = index;
+}
+
+uint32_t FastSwitchNetDevice::GetIfIndex() const
+{
+    return m_ifIndex;
+}
+
+Ptr<Channel> FastSwitchNetDevice::GetChannel() const
+{
+    return nullptr;
+}
+
+void FastSwitchNetDevice::SetAddress(Address address)
+{
+    m_address = Mac48Address::ConvertFrom(address);
+}
+
+Address FastSwitchNetDevice::GetAddress() const
+{
+    return m_address;
+}
+
+bool FastSwitchNetDevice::SetMtu(const uint16_t mtu)
+{
+    m_mtu = mtu;
+    return true;
+}
+
+uint16_t FastSwitchNetDevice::GetMtu() const
+{
+    return m_mtu;
+}
+
+bool FastSwitchNetDevice::IsLinkUp() const
+{
+    return true;
+}
+
+void FastSwitchNetDevice::AddLinkChangeCallback(Callback<void> callback)
+{
+}
+
+bool FastSwitchNetDevice::IsBroadcast() const
+{
+    return true;
+}
+
+Address FastSwitchNetDevice::GetBroadcast() const
+{
+    return Mac48Address::GetBroadcast();
+}
+
+bool FastSwitchNetDevice::IsMulticast() const
+{
+    return true;
+}
+
+Address FastSwitchNetDevice::GetMulticast(Ipv4Address multicastGroup) const
+{
+    return Mac48Address::GetMulticast(multicastGroup);
+}
+
+Address FastSwitchNetDevice::GetMulticast(Ipv6Address addr) const
+{
+    return Mac48Address::GetMulticast(addr);
+}
+
+bool FastSwitchNetDevice::IsPointToPoint() const
+{
+    return false;
+}
+
+bool FastSwitchNetDevice::IsBridge() const
+{
+    return true;
+}
+
+bool FastSwitchNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+    return SendFrom(packet, m_address, dest, protocolNumber);
+}
+
+bool FastSwitchNetDevice::SendFrom(Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber)
+{
+    Forward(NO_PORT, packet, protocolNumber, Mac48Address::ConvertFrom(source), Mac48Address::ConvertFrom(dest));
+    return true;
+}
+
+Ptr<Node> FastSwitchNetDevice::GetNode() const
+{
+    return m_node;
+}
+
+void FastSwitchNetDevice::SetNode(Ptr<Node> node)
+{
+    m_node = node;
+}
+
+bool FastSwitchNetDevice::NeedsArp() const
+{
+    return true;
+}
+
+void FastSwitchNetDevice::SetReceiveCallback(NetDevice::ReceiveCallback cb)
+{
+    m_rxCallback = cb;
+}
+
+void FastSwitchNetDevice::SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb)
+{
+    m_promiscRxCallback = cb;
+}
+
+bool FastSwitchNetDevice::SupportsSendFrom() const
+{
+    return true;
+}
+
+}
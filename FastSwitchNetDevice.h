@@ -0,0 +1,162 @@
+#ifndef FAST_SWITCH_NET_DEVICE_H
+#define FAST_SWITCH_NET_DEVICE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+// Learning L2 switch over a set of port devices, a leaner stand-in for BridgeNetDevice.
+// The MAC table is a flat open addressing table, a lookup is a hash and a short linear
+// probe with no allocation. Entries age out lazily: an expired entry counts as a miss
+// and is refreshed in place when the host is seen again.
+//
+// Each port has a bounded output FIFO in front of its device. It holds frames for the
+// forwarding latency, one pending event per port however many frames wait. The device's
+// own transmit queue buffers them after that. A CSMA port only delivers a frame once it
+// has been received in full, so every hop already pays for store-and-forward.
+// Cut-through forwarding is modelled by crediting the part of the frame after the first
+// cutThroughBytes, at the ingress port's rate, against the switch latency.
+//
+// Trunk ports connect two switches over a point to point link, e.g. between MPI ranks.
+// Point to point devices carry no MAC addresses, so frames cross a trunk with their
+// Ethernet header inside the payload.
+class FastSwitchNetDevice : public NetDevice {
+    public:
+        static TypeId GetTypeId(void);
+
+        FastSwitchNetDevice();
+        ~FastSwitchNetDevice() override;
+
+        // Forwarding latency of the switch pipeline, applied to every frame
+        void SetLatency(Time latency);
+        // Start forwarding once cutThroughBytes of a frame arrived instead of all of it
+        void SetCutThrough(bool cutThrough, uint32_t cutThroughBytes = 64);
+        // MAC table entries older than this are ignored
+        void SetExpirationTime(Time expiration);
+        // Frames each port's output FIFO holds while they wait out the latency
+        void SetQueueSize(uint32_t frames);
+
+        // Add a port, a device of the switch's node that supports SendFrom. The switch must already be
+        // added to the node. Ports receive promiscuously from now on.
+        void AddPort(Ptr<NetDevice> port);
+        // Add a point to point link to another switch as a port, it needs no SendFrom
+        void AddTrunk(Ptr<NetDevice> trunk);
+        uint32_t GetNPorts() const;
+        Ptr<NetDevice> GetPort(uint32_t n) const;
+
+        // Forwarding counters and MAC table occupancy
+        void Print(std::ostream& os) const;
+
+        // NetDevice
+        void SetIfIndex(const uint32_t index) override;
+        uint32_t GetIfIndex() const override;
+        Ptr<Channel> GetChannel() const override;
+        void SetAddress(Address address) override;
+        Address GetAddress() const override;
+        bool SetMtu(const uint16_t mtu) override;
+        uint16_t GetMtu() const override;
+        bool IsLinkUp() const override;
+        void AddLinkChangeCallback(Callback<void> callback) override;
+        bool IsBroadcast() const override;
+        Address GetBroadcast() const override;
+        bool IsMulticast() const override;
+        Address GetMulticast(Ipv4Address multicastGroup) const override;
+        Address GetMulticast(Ipv6Address addr) const override;
+        bool IsPointToPoint() const override;
+        bool IsBridge() const override;
+        bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+        bool SendFrom(Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) override;
+        Ptr<Node> GetNode() const override;
+        void SetNode(Ptr<Node> node) override;
+        bool NeedsArp() const override;
+        void SetReceiveCallback(NetDevice::ReceiveCallback cb) override;
+        void SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb) override;
+        bool SupportsSendFrom() const override;
+
+    protected:
+        void DoDispose() override;
+
+    private:
+        static const uint32_t NO_PORT = UINT32_MAX;
+        static const uint64_t EMPTY = ~0ULL;        // Never a valid key, MACs use only 48 bits
+
+        struct Entry
+        {
+            uint64_t mac;       // MAC as a 48 bit integer, EMPTY if unused
+            uint32_t port;      // Port the MAC was last seen on
+            int64_t expireNs;   // Entry is ignored from this time on
+        };
+
+        struct Pending
+        {
+            Ptr<Packet> pkt;
+            Mac48Address src;
+            Mac48Address dst;
+            uint16_t protocol;
+            int64_t readyNs;    // When the frame may go to the port device
+        };
+
+        struct Port
+        {
+            Ptr<NetDevice> device;
+            bool trunk = false;             // Frames carry their Ethernet header inside
+            uint64_t bitRate = 0;           // Ingress rate for the cut-through credit, 0 if unknown
+            std::vector<Pending> fifo;      // Output FIFO ring, allocated on first use
+            uint32_t head = 0;              // Oldest waiting frame
+            uint32_t count = 0;             // Waiting frames
+            int64_t lastReadyNs = 0;        // Frames leave in arrival order
+            EventId drain;                  // Pending release of the head frame
+            uint64_t txFrames = 0;          // Frames handed to the device
+            uint64_t fifoDrops = 0;         // Arrivals to a full output FIFO
+            uint64_t deviceDrops = 0;       // Frames refused by the device, e.g. a full transmit queue
+        };
+
+        void Attach(Ptr<NetDevice> port, bool trunk);
+        void ReceiveFromPort(Ptr<NetDevice> incoming, Ptr<const Packet> pkt, uint16_t protocol,
+                             const Address& src, const Address& dst, PacketType packetType);
+        // Send to the learned port, or flood to all ports but inPort
+        void Forward(uint32_t inPort, Ptr<const Packet> pkt, uint16_t protocol, Mac48Address src, Mac48Address dst);
+        void Output(uint32_t port, Ptr<const Packet> pkt, uint16_t protocol, Mac48Address src, Mac48Address dst, Time hold);
+        void Transmit(Port& port, Ptr<Packet> pkt, Mac48Address src, Mac48Address dst, uint16_t protocol);
+        // Release every frame at the head of port's FIFO that is ready
+        void Drain(uint32_t port);
+        // Time a frame received on inPort spends in the switch
+        Time Hold(uint32_t inPort, uint32_t bytes) const;
+
+        static uint64_t MacKey(Mac48Address mac);
+        void Learn(Mac48Address mac, uint32_t port);
+        uint32_t Lookup(Mac48Address mac) const;
+        // Slot holding key, or the free slot ending its probe sequence
+        uint32_t FindSlot(uint64_t key) const;
+        void Grow();
+
+        Ptr<Node> m_node;
+        Mac48Address m_address;
+        uint32_t m_ifIndex;
+        uint16_t m_mtu;
+        NetDevice::ReceiveCallback m_rxCallback;
+        NetDevice::PromiscReceiveCallback m_promiscRxCallback;
+
+        Time m_latency;                 // Pipeline latency per frame
+        bool m_cutThrough;              // Credit the frame tail against the latency
+        uint32_t m_cutThroughBytes;     // Bytes received before a cut-through switch forwards
+        Time m_expiration;              // MAC table entry lifetime
+        uint32_t m_queueSize;           // Output FIFO size per port
+
+        std::vector<Port> m_ports;
+        std::vector<uint32_t> m_portByIfIndex;  // Port number by the port device's index on the node
+        std::vector<Entry> m_table;     // Power of two sized, at most half full
+        uint32_t m_used;                // Slots holding a MAC
+        uint64_t m_forwarded;           // Frames sent to a learned port
+        uint64_t m_flooded;             // Frames flooded, unknown or group destination
+        uint64_t m_filtered;            // Frames whose destination is on the port they came from
+};
+
+}
+
+#endif
@@ -0,0 +1,413 @@
+#include "FlowStats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("FlowStats");
+
+FlowStats& FlowStats::Get()
+{
+    static FlowStats instance;
+    return instance;
+}
+
+FlowStats::FlowStats()
+{
+    m_kept = UINT32_MAX;
+    m_numFlows = 0;
+}
+
+void FlowStats::SetKept(uint32_t maxFlows)
+{
+    m_kept = maxFlows;
+}
+
+FlowRecord* FlowStats::Find(uint32_t flowId)
+{
+    auto it = m_flows.find(flowId);
+    return it != m_flows.end() ? &it->second : nullptr;
+}
+
+void FlowStats::Register(uint32_t flowId, const std::string& label)
+{
+    FlowRecord& flow = m_flows[flowId];
+    flow.label = label;
+    flow.registered = true;
+    m_numFlows = std::max(m_numFlows, flowId + 1);
+}
+
+void FlowStats::Retire(uint32_t flowId)
+{
+    auto it = m_flows.find(flowId);
+    if (it == m_flows.end() || it->second.retired)
+    {
+        return;
+    }
+    Add(m_totals, it->second);
+    if (flowId < m_kept)
+    {
+        it->second.retired = true;
+    }
+    else
+    {
+        m_flows.erase(it);
+    }
+}
+
+void FlowStats::SetSent(uint32_t flowId, uint64_t sent, uint64_t refused)
+{
+    if (FlowRecord* flow = Find(flowId))
+    {
+        flow->sent = sent;
+        flow->refused = refused;
+    }
+}
+
+// Updates for flows without a record (never registered, or retired) are ignored
+void FlowStats::RecordRx(uint32_t flowId, uint32_t seq, Time txTime, uint32_t payloadBytes)
+{
+    FlowRecord* record = Find(flowId);
+    if (!record)
+    {
+        return;
+    }
+    FlowRecord& flow = *record;
+    Time now = Simulator::Now();
+
+    if (flow.received == 0)
+    {
+        flow.firstRx = now;
+    }
+    flow.lastRx = now;
+    flow.received++;
+    flow.bytes += payloadBytes;
+
+    if (seq < flow.nextSeq)
+    {
+        flow.reordered++;
+    }
+    else
+    {
+        flow.nextSeq = seq + 1;
+    }
+
+    int64_t transit = (now - txTime).GetNanoSeconds();
+    if (flow.received > 1)
+    {
+        double d = static_cast<double>(std::llabs(transit - flow.lastTransitNs));
+        flow.jitterNs += (d - flow.jitterNs) / 16.0;
+    }
+    flow.lastTransitNs = transit;
+    flow.delay.Record(transit > 0 ? static_cast<uint64_t>(transit) : 0);
+}
+
+void FlowStats::RecordRtt(uint32_t flowId, Time rtt)
+{
+    FlowRecord* flow = Find(flowId);
+    if (!flow)
+    {
+        return;
+    }
+    flow->replies++;
+    flow->rtt.Record(rtt.IsPositive() ? static_cast<uint64_t>(rtt.GetNanoSeconds()) : 0);
+}
+
+void FlowStats::RecordMessage(uint32_t flowId, Time txTime, uint32_t bytes)
+{
+    FlowRecord* record = Find(flowId);
+    if (!record)
+    {
+        return;
+    }
+    FlowRecord& flow = *record;
+    Time now = Simulator::Now();
+    if (flow.messages == 0)
+    {
+        flow.firstMsg = now;
+    }
+    flow.lastMsg = now;
+    flow.messages++;
+    flow.msgBytes += bytes;
+    int64_t delay = (now - txTime).GetNanoSeconds();
+    flow.msgDelay.Record(delay > 0 ? static_cast<uint64_t>(delay) : 0);
+}
+
+void FlowStats::RecordIncompleteMessages(uint32_t flowId, uint32_t count)
+{
+    if (FlowRecord* flow = Find(flowId))
+    {
+        flow->msgIncomplete += count;
+    }
+}
+
+void FlowStats::RecordRefusedMessages(uint32_t flowId, uint32_t count)
+{
+    if (FlowRecord* flow = Find(flowId))
+    {
+        flow->msgRefused += count;
+    }
+}
+
+const FlowRecord* FlowStats::GetFlow(uint32_t flowId) const
+{
+    auto it = m_flows.find(flowId);
+    return it != m_flows.end() ? &it->second : nullptr;
+}
+
+uint32_t FlowStats::GetNumFlows() const
+{
+    return m_numFlows;
+}
+
+void FlowStats::Print(std::ostream& os) const
+{
+    os << std::fixed << std::setprecision(3);
+    for (uint32_t i = 0; i < m_numFlows; i++)
+    {
+        if (i == m_kept)
+        {
+            os << "... " << m_numFlows - i << " more flows, see --statsOut for totals over all flows" << std::endl;
+            break;
+        }
+        auto it = m_flows.find(i);
+        if (it == m_flows.end() || !it->second.registered)
+        {
+            continue;
+        }
+        const FlowRecord& flow = it->second;
+        uint64_t lost;
+        double lossPct;
+        GetLoss(flow.sent, flow.refused, flow.nextSeq, flow.received, lost, lossPct);
+        double span = (flow.lastRx - flow.firstRx).GetSeconds();
+        double goodput = span > 0 ? flow.bytes * 8.0 / span / 1e6 : 0.0;
+
+        os << "Flow " << i << " (" << flow.label << "): sent " << flow.sent;
+        if (flow.refused)
+        {
+            os << ", refused " << flow.refused;
+        }
+        os << ", received " << flow.received
+           << ", lost " << lost << " (" << lossPct << "%)"
+           << ", reordered " << flow.reordered << std::endl;
+        if (flow.received)
+        {
+            os << "    one-way delay ms: min " << flow.delay.GetMin() / 1e6
+               << " p50 " << flow.delay.Percentile(0.5) / 1e6
+               << " p99 " << flow.delay.Percentile(0.99) / 1e6
+               << " p99.9 " << flow.delay.Percentile(0.999) / 1e6
+               << " max " << flow.delay.GetMax() / 1e6
+               << ", jitter " << flow.jitterNs / 1e6
+               << " ms, goodput " << goodput << " Mbps" << std::endl;
+        }
+        if (flow.replies)
+        {
+            os << "    round-trip ms: replies " << flow.replies
+               << " (unanswered " << (flow.sent > flow.replies ? flow.sent - flow.replies : 0) << ")"
+               << " min " << flow.rtt.GetMin() / 1e6
+               << " p50 " << flow.rtt.Percentile(0.5) / 1e6
+               << " p99 " << flow.rtt.Percentile(0.99) / 1e6
+               << " p99.9 " << flow.rtt.Percentile(0.999) / 1e6
+               << " max " << flow.rtt.GetMax() / 1e6 << std::endl;
+        }
+        if (flow.messages || flow.msgIncomplete || flow.msgRefused)
+        {
+            double msgSpan = (flow.lastMsg - flow.firstMsg).GetSeconds();
+            os << "    messages: reassembled " << flow.messages << ", incomplete " << flow.msgIncomplete
+               << ", refused " << flow.msgRefused
+               << ", latency ms p50 " << flow.msgDelay.Percentile(0.5) / 1e6
+               << " p99 " << flow.msgDelay.Percentile(0.99) / 1e6
+               << " max " << flow.msgDelay.GetMax() / 1e6
+               << ", goodput " << (msgSpan > 0 ? flow.msgBytes * 8.0 / msgSpan / 1e6 : 0.0) << " Mbps" << std::endl;
+        }
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+void FlowStats::GetLoss(uint64_t sent, uint64_t refused, uint64_t seqs, uint64_t received, uint64_t& lost, double& lossPct)
+{
+    uint64_t expected = std::max(sent + refused, seqs);
+    lost = expected > received ? expected - received : 0;
+    lossPct = expected ? 100.0 * lost / expected : 0.0;
+}
+
+void FlowStats::Add(Totals& totals, const FlowRecord& flow)
+{
+    if (!flow.registered)
+    {
+        return;
+    }
+    totals.sent += flow.sent;
+    totals.refused += flow.refused;
+    totals.seqs += flow.nextSeq;
+    totals.received += flow.received;
+    totals.reordered += flow.reordered;
+    double span = (flow.lastRx - flow.firstRx).GetSeconds();
+    totals.goodput += span > 0 ? flow.bytes * 8.0 / span / 1e6 : 0.0;
+    totals.delay.Merge(flow.delay);
+    totals.rtt.Merge(flow.rtt);
+    totals.messages += flow.messages;
+    totals.msgIncomplete += flow.msgIncomplete;
+    totals.msgRefused += flow.msgRefused;
+    double msgSpan = (flow.lastMsg - flow.firstMsg).GetSeconds();
+    totals.msgGoodput += msgSpan > 0 ? flow.msgBytes * 8.0 / msgSpan / 1e6 : 0.0;
+    totals.msgDelay.Merge(flow.msgDelay);
+}
+
+FlowStats::Totals FlowStats::GetTotals() const
+{
+    Totals totals = m_totals;
+    for (const auto& entry : m_flows)
+    {
+        if (!entry.second.retired)
+        {
+            Add(totals, entry.second);
+        }
+    }
+    return totals;
+}
+
+void FlowStats::Save(std::vector<uint64_t>& out) const
+{
+    Totals totals = GetTotals();
+    uint64_t goodput;
+    uint64_t msgGoodput;
+    std::memcpy(&goodput, &totals.goodput, sizeof(goodput));
+    std::memcpy(&msgGoodput, &totals.msgGoodput, sizeof(msgGoodput));
+    uint64_t sums[] = {totals.sent, totals.seqs, totals.received, totals.reordered, goodput,
+                       totals.messages, totals.msgIncomplete, msgGoodput, totals.refused, totals.msgRefused};
+    out.insert(out.end(), std::begin(sums), std::end(sums));
+    totals.delay.Save(out);
+    totals.rtt.Save(out);
+    totals.msgDelay.Save(out);
+
+    // Only the kept flows, the rest is in the totals
+    for (const auto& entry : m_flows)
+    {
+        const FlowRecord& flow = entry.second;
+        if (entry.first >= m_kept || (!flow.sent && !flow.refused && !flow.received && !flow.replies && !flow.messages && !flow.msgIncomplete && !flow.msgRefused))
+        {
+            continue;
+        }
+        uint64_t jitter;
+        std::memcpy(&jitter, &flow.jitterNs, sizeof(jitter));
+        uint64_t words[] = {entry.first, flow.sent, flow.received, flow.bytes, flow.reordered, flow.nextSeq,
+                            static_cast<uint64_t>(flow.firstRx.GetNanoSeconds()), static_cast<uint64_t>(flow.lastRx.GetNanoSeconds()),
+                            jitter, flow.replies, flow.messages, flow.msgBytes, flow.msgIncomplete,
+                            static_cast<uint64_t>(flow.firstMsg.GetNanoSeconds()), static_cast<uint64_t>(flow.lastMsg.GetNanoSeconds()),
+                            flow.refused, flow.msgRefused};
+        out.insert(out.end(), std::begin(words), std::end(words));
+        flow.delay.Save(out);
+        flow.rtt.Save(out);
+        flow.msgDelay.Save(out);
+    }
+}
+
+void FlowStats::Merge(const uint64_t* in, size_t words)
+{
+    const uint64_t* end = in + words;
+    if (in == end)
+    {
+        return;
+    }
+    LatencyHistogram histogram;
+
+    m_totals.sent += in[0];
+    m_totals.seqs += in[1];
+    m_totals.received += in[2];
+    m_totals.reordered += in[3];
+    double goodput;
+    std::memcpy(&goodput, &in[4], sizeof(goodput));
+    m_totals.goodput += goodput;
+    m_totals.messages += in[5];
+    m_totals.msgIncomplete += in[6];
+    std::memcpy(&goodput, &in[7], sizeof(goodput));
+    m_totals.msgGoodput += goodput;
+    m_totals.refused += in[8];
+    m_totals.msgRefused += in[9];
+    in += 10;
+    in = histogram.Load(in);
+    m_totals.delay.Merge(histogram);
+    in = histogram.Load(in);
+    m_totals.rtt.Merge(histogram);
+    in = histogram.Load(in);
+    m_totals.msgDelay.Merge(histogram);
+
+    while (in < end)
+    {
+        // Already in the other rank's totals, the record is only for the report
+        FlowRecord& flow = m_flows[static_cast<uint32_t>(in[0])];
+        flow.retired = true;
+        flow.sent += in[1];
+        // The receiving rank holds all of a flow's receive side, take its view whole
+        if (in[2])
+        {
+            flow.firstRx = flow.received ? Min(flow.firstRx, NanoSeconds(in[6])) : NanoSeconds(in[6]);
+            flow.lastRx = Max(flow.lastRx, NanoSeconds(in[7]));
+            std::memcpy(&flow.jitterNs, &in[8], sizeof(flow.jitterNs));
+        }
+        flow.received += in[2];
+        flow.bytes += in[3];
+        flow.reordered += in[4];
+        flow.nextSeq = std::max<uint64_t>(flow.nextSeq, in[5]);
+        flow.replies += in[9];
+        if (in[10])
+        {
+            flow.firstMsg = flow.messages ? Min(flow.firstMsg, NanoSeconds(in[13])) : NanoSeconds(in[13]);
+            flow.lastMsg = Max(flow.lastMsg, NanoSeconds(in[14]));
+        }
+        flow.messages += in[10];
+        flow.msgBytes += in[11];
+        flow.msgIncomplete += in[12];
+        flow.refused += in[15];
+        flow.msgRefused += in[16];
+        in += 17;
+
+        in = histogram.Load(in);
+        flow.delay.Merge(histogram);
+        in = histogram.Load(in);
+        flow.rtt.Merge(histogram);
+        in = histogram.Load(in);
+        flow.msgDelay.Merge(histogram);
+    }
+}
+
+void FlowStats::WriteSummary(std::ostream& os) const
+{
+    Totals totals = GetTotals();
+    uint64_t lost;
+    double lossPct;
+    GetLoss(totals.sent, totals.refused, totals.seqs, totals.received, lost, lossPct);
+
+    os << "flows_sent " << totals.sent << "\n"
+       << "flows_refused " << totals.refused << "\n"
+       << "flows_received " << totals.received << "\n"
+       << "flows_lost " << lost << "\n"
+       << "loss_pct " << lossPct << "\n"
+       << "reordered " << totals.reordered << "\n"
+       << "goodput_mbps " << totals.goodput << "\n"
+       << "delay_p50_ms " << totals.delay.Percentile(0.5) / 1e6 << "\n"
+       << "delay_p99_ms " << totals.delay.Percentile(0.99) / 1e6 << "\n"
+       << "delay_p999_ms " << totals.delay.Percentile(0.999) / 1e6 << "\n"
+       << "delay_mean_ms " << totals.delay.GetMean() / 1e6 << "\n";
+    if (totals.rtt.GetCount())
+    {
+        os << "rtt_p50_ms " << totals.rtt.Percentile(0.5) / 1e6 << "\n"
+           << "rtt_p99_ms " << totals.rtt.Percentile(0.99) / 1e6 << "\n"
+           << "rtt_p999_ms " << totals.rtt.Percentile(0.999) / 1e6 << "\n";
+    }
+    if (totals.messages || totals.msgIncomplete || totals.msgRefused)
+    {
+        os << "messages " << totals.messages << "\n"
+           << "messages_incomplete " << totals.msgIncomplete << "\n"
+           << "messages_refused " << totals.msgRefused << "\n"
+           << "msg_goodput_mbps " << totals.msgGoodput << "\n"
+           << "msg_p50_ms " << totals.msgDelay.Percentile(0.5) / 1e6 << "\n"
+           << "msg_p99_ms " << totals.msgDelay.Percentile(0.99) / 1e6 << "\n";
+    }
+}
+
+}
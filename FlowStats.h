@@ -0,0 +1,120 @@
+#ifndef FLOW_STATS_H
+#define FLOW_STATS_H
+
+#include "ns3/core-module.h"
+#include "LatencyHistogram.h"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+// Per flow receive statistics, all updates are O(1)
+struct FlowRecord
+{
+    std::string label;          // Human readable description, e.g. "n0->n4"
+    bool registered = false;    // Flow id has been registered
+    bool retired = false;       // Already counted in the totals, kept for the report
+    uint64_t sent = 0;          // Frames the sender handed to its device
+    uint64_t refused = 0;       // Frames the sender's device refused on enqueue, lost
+    uint64_t received = 0;      // Frames that arrived carrying a probe
+    uint64_t bytes = 0;         // UDP payload bytes received
+    uint64_t reordered = 0;     // Frames that arrived after a higher sequence number
+    uint32_t nextSeq = 0;       // Highest sequence number seen + 1
+    Time firstRx;               // First arrival
+    Time lastRx;                // Last arrival
+    int64_t lastTransitNs = 0;  // Previous one-way delay, for jitter
+    double jitterNs = 0;        // RFC 3550 interarrival jitter estimate
+    LatencyHistogram delay;     // One-way delay distribution in ns
+    uint64_t replies = 0;       // Echo replies matched to an outstanding request
+    LatencyHistogram rtt;       // Round-trip time distribution in ns (echo mode)
+    uint64_t messages = 0;      // Segmented messages reassembled
+    uint64_t msgBytes = 0;      // Bytes of the reassembled messages
+    uint64_t msgIncomplete = 0; // Messages given up on with segments missing
+    uint64_t msgRefused = 0;    // Messages the sender gave up on after a segment was refused
+    Time firstMsg;              // First reassembled message
+    Time lastMsg;               // Last reassembled message
+    LatencyHistogram msgDelay;  // First segment sent to last segment received, in ns
+};
+
+// Global registry of flow statistics. Unlike the per app counters this sees every flow in
+// the simulation. A flow has a record while it is active. When it retires its record is
+// added to the totals and released, except for the first few flows the report lists, so
+// memory follows the number of active flows.
+class FlowStats {
+    public:
+        static FlowStats& Get();
+
+        // Keep the records of flows below maxFlows after they retire, for Print
+        void SetKept(uint32_t maxFlows);
+
+        void Register(uint32_t flowId, const std::string& label);
+        // Add the flow to the totals, no more updates are expected for it
+        void Retire(uint32_t flowId);
+        // Sender side counts, refused frames used up sequence numbers and count as lost
+        void SetSent(uint32_t flowId, uint64_t sent, uint64_t refused);
+        // Account one probe carrying frame of flowId that was sent at txTime
+        void RecordRx(uint32_t flowId, uint32_t seq, Time txTime, uint32_t payloadBytes);
+        // Account one echo reply matched by the original sender
+        void RecordRtt(uint32_t flowId, Time rtt);
+        // Account one message reassembled by the receiver, sent at txTime
+        void RecordMessage(uint32_t flowId, Time txTime, uint32_t bytes);
+        void RecordIncompleteMessages(uint32_t flowId, uint32_t count);
+        void RecordRefusedMessages(uint32_t flowId, uint32_t count);
+
+        const FlowRecord* GetFlow(uint32_t flowId) const;
+        uint32_t GetNumFlows() const;
+
+        // Per flow loss, reordering, delay percentiles, jitter and goodput for the kept flows
+        void Print(std::ostream& os) const;
+        // Totals over all flows as "key value" lines, for scripts merging many runs
+        void WriteSummary(std::ostream& os) const;
+
+        // Distributed runs see each flow's sender and receiver on their own rank. Save appends the
+        // totals and the kept flows with data to out as 64 bit words, Merge adds what another rank saved.
+        void Save(std::vector<uint64_t>& out) const;
+        void Merge(const uint64_t* in, size_t words);
+
+    private:
+        // Sums over retired flows. Loss is worked out from the sums, so the halves of a flow
+        // retired on different ranks add up: max(sent + refused, seqs) - received.
+        struct Totals
+        {
+            uint64_t sent = 0;          // Frames handed to the device
+            uint64_t refused = 0;       // Frames refused by the device
+            uint64_t seqs = 0;          // Highest sequence number + 1, summed
+            uint64_t received = 0;
+            uint64_t reordered = 0;
+            double goodput = 0;         // Sum of per flow goodput (Mbps)
+            LatencyHistogram delay;
+            LatencyHistogram rtt;
+            uint64_t messages = 0;
+            uint64_t msgIncomplete = 0;
+            uint64_t msgRefused = 0;
+            double msgGoodput = 0;      // Sum of per flow message goodput (Mbps)
+            LatencyHistogram msgDelay;
+        };
+
+        FlowStats();
+
+        // Record of an active or kept flow, null if there is none
+        FlowRecord* Find(uint32_t flowId);
+        static void Add(Totals& totals, const FlowRecord& flow);
+        // Loss against the frames the receiver should have seen, max(sent + refused, seqs).
+        // Refused frames and frames still in flight at the end of the run count as lost.
+        static void GetLoss(uint64_t sent, uint64_t refused, uint64_t seqs, uint64_t received, uint64_t& lost, double& lossPct);
+        // Retired totals plus the flows still active
+        Totals GetTotals() const;
+
+        std::unordered_map<uint32_t, FlowRecord> m_flows;   // Active and kept flows by id
+        uint32_t m_kept;                                    // Flows below this id keep their record
+        uint32_t m_numFlows;                                // Highest registered flow id + 1
+        Totals m_totals;                                    // Retired flows
+};
+
+}
+
+#endif
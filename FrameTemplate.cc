@@ -0,0 +1,351 @@
+#include "FrameTemplate.h"
+#include "Checksum.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("FrameTemplate");
+
+static const uint32_t ETH_HEADER_SIZE = 14;
+
+static int HexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    c = std::tolower(static_cast<unsigned char>(c));
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static bool ParseHex(const std::string& hex, std::vector<uint8_t>& bytes)
+{
+    std::istringstream stream(hex);
+    std::string token;
+    while (stream >> token)
+    {
+        size_t i = token.compare(0, 2, "0x") == 0 || token.compare(0, 2, "0X") == 0 ? 2 : 0;
+        if (i == token.size() || (token.size() - i) % 2)
+        {
+            return false;
+        }
+        for (; i < token.size(); i += 2)
+        {
+            int hi = HexValue(token[i]);
+            int lo = HexValue(token[i + 1]);
+            if (hi < 0 || lo < 0)
+            {
+                return false;
+            }
+            bytes.push_back(static_cast<uint8_t>(hi << 4 | lo));
+        }
+    }
+    return true;
+}
+
+Ptr<FrameTemplate> FrameTemplate::FromHex(const std::string& hex)
+{
+    std::vector<uint8_t> frame;
+    if (!ParseHex(hex, frame))
+    {
+        NS_FATAL_ERROR("Frame is not a sequence of hex bytes: " << hex);
+    }
+    return Ptr<FrameTemplate>(new FrameTemplate(frame), false);
+}
+
+Ptr<FrameTemplate> FrameTemplate::FromFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        NS_FATAL_ERROR("Could not open frame file " << path);
+    }
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<uint8_t> frame;
+    // Hex text if it parses as such, raw bytes otherwise
+    if (contents.empty() || !ParseHex(contents, frame))
+    {
+        frame.assign(contents.begin(), contents.end());
+    }
+    return Ptr<FrameTemplate>(new FrameTemplate(frame), false);
+}
+
+Ptr<FrameTemplate> FrameTemplate::TestFrame()
+{
+    static const std::vector<uint8_t> frame = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x08, 0x00, 0x45, 0x00, 0x00, 0x4E, 0x00, 0x00, 0x00, 0x00, 0x40, 0x11, 0x66,
+        0x9C, 0x0A, 0x00, 0x00, 0x01, 0x0A, 0x00, 0x00, 0x03, 0x1F, 0x90, 0x1F, 0x90, 0x00, 0x3A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    return Ptr<FrameTemplate>(new FrameTemplate(frame), false);
+}
+
+FrameTemplate::FrameTemplate(const std::vector<uint8_t>& frame)
+    : m_protocol(0),
+      m_ipHeaderLen(0)
+{
+    if (frame.size() < ETH_HEADER_SIZE)
+    {
+        NS_FATAL_ERROR("Frame of " << frame.size() << " bytes is shorter than an Ethernet header");
+    }
+    // Ethernet header: destination, source, EtherType
+    m_dst.CopyFrom(frame.data());
+    m_src.CopyFrom(frame.data() + 6);
+    m_protocol = ReadNet16(frame.data() + 12);
+    m_l3.assign(frame.begin() + ETH_HEADER_SIZE, frame.end());
+
+    if (m_protocol == 0x0800 && m_l3.size() >= 20 && (m_l3[0] >> 4) == 4)
+    {
+        m_ipHeaderLen = (m_l3[0] & 0x0f) * 4u;
+        if (m_ipHeaderLen < 20 || m_ipHeaderLen > m_l3.size())
+        {
+            m_ipHeaderLen = 0;
+        }
+    }
+    Split();
+}
+
+int32_t FrameTemplate::CoveringChecksum(uint32_t offset) const
+{
+    if (!m_ipHeaderLen)
+    {
+        return -1;
+    }
+    if (offset < m_ipHeaderLen)
+    {
+        return 10;
+    }
+    uint8_t proto = m_l3[9];
+    if (proto == 17 && m_l3.size() >= m_ipHeaderLen + 8 && ReadNet16(&m_l3[m_ipHeaderLen + 6]) != 0)
+    {
+        return m_ipHeaderLen + 6;
+    }
+    if (proto == 6 && m_l3.size() >= m_ipHeaderLen + 20)
+    {
+        return m_ipHeaderLen + 16;
+    }
+    return -1;
+}
+
+void FrameTemplate::FixLengths()
+{
+    if (!m_ipHeaderLen)
+    {
+        NS_FATAL_ERROR("Frame patch len needs an IPv4 frame");
+    }
+    WriteNet16(&m_l3[2], static_cast<uint16_t>(m_l3.size()));
+    if (m_l3[9] == 17 && m_l3.size() >= m_ipHeaderLen + 8)
+    {
+        WriteNet16(&m_l3[m_ipHeaderLen + 4], static_cast<uint16_t>(m_l3.size() - m_ipHeaderLen));
+    }
+}
+
+void FrameTemplate::FixChecksums()
+{
+    if (!m_ipHeaderLen)
+    {
+        NS_FATAL_ERROR("Frame patch csum needs an IPv4 frame");
+    }
+    WriteNet16(&m_l3[10], 0);
+    WriteNet16(&m_l3[10], static_cast<uint16_t>(~ChecksumSum(m_l3.data(), m_ipHeaderLen)));
+
+    uint8_t proto = m_l3[9];
+    uint32_t csumOffset = proto == 17 ? 6 : proto == 6 ? 16 : 0;
+    uint32_t l4Size = m_l3.size() - m_ipHeaderLen;
+    if (!csumOffset || l4Size < csumOffset + 2)
+    {
+        return;
+    }
+    uint8_t* l4 = &m_l3[m_ipHeaderLen];
+    WriteNet16(l4 + csumOffset, 0);
+    // Pseudo header: source, destination, protocol and L4 length
+    uint32_t sum = ChecksumSum(&m_l3[12], 8);
+    sum += proto;
+    sum += l4Size;
+    uint16_t csum = static_cast<uint16_t>(~ChecksumSum(l4, l4Size, sum));
+    // A zero UDP checksum means none, send all ones instead
+    WriteNet16(l4 + csumOffset, csum == 0 && proto == 17 ? 0xffff : csum);
+}
+
+void FrameTemplate::SetPatches(const std::string& spec)
+{
+    m_patches.clear();
+    bool fixLengths = false;
+    bool fixChecksums = false;
+    std::istringstream stream(spec);
+    std::string field;
+    while (std::getline(stream, field, ','))
+    {
+        if (field.empty())
+        {
+            continue;
+        }
+        if (field == "len")
+        {
+            fixLengths = true;
+        }
+        else if (field == "csum")
+        {
+            fixChecksums = true;
+        }
+        else if (field == "ipid")
+        {
+            if (!m_ipHeaderLen)
+            {
+                NS_FATAL_ERROR("Frame patch ipid needs an IPv4 frame");
+            }
+            m_patches.push_back({4, 2, true, 10});
+        }
+        else if (field.compare(0, 4, "seq@") == 0)
+        {
+            uint32_t offset = 0;
+            uint32_t width = 4;
+            char colon = 0;
+            std::istringstream args(field.substr(4));
+            args >> offset;
+            if (!args || (args >> colon && (colon != ':' || !(args >> width))) || (width != 2 && width != 4))
+            {
+                NS_FATAL_ERROR("Frame patch " << field << " must look like seq@OFFSET, seq@OFFSET:2 or seq@OFFSET:4");
+            }
+            if (offset < ETH_HEADER_SIZE || offset + width > ETH_HEADER_SIZE + m_l3.size())
+            {
+                NS_FATAL_ERROR("Frame patch " << field << " is outside the frame's " << ETH_HEADER_SIZE + m_l3.size()
+                                              << " bytes after the Ethernet header");
+            }
+            // The covering checksum is resolved below, once len and csum have been applied
+            m_patches.push_back({static_cast<uint16_t>(offset - ETH_HEADER_SIZE), static_cast<uint8_t>(width), false, -1});
+        }
+        else
+        {
+            NS_FATAL_ERROR("Unknown frame patch " << field << ", expected seq@OFFSET[:2|4], ipid, len or csum");
+        }
+    }
+    if (fixLengths)
+    {
+        FixLengths();
+    }
+    if (fixChecksums || fixLengths)
+    {
+        FixChecksums();
+    }
+    // A UDP checksum only covers the sequence fields if it is in use after the fixes above
+    for (Patch& patch : m_patches)
+    {
+        if (patch.ipId)
+        {
+            continue;
+        }
+        patch.csum = CoveringChecksum(patch.offset);
+        // Checksums sum 16 bit words, fields must be word aligned within the covered header
+        uint32_t base = patch.offset < m_ipHeaderLen ? 0 : m_ipHeaderLen;
+        if (patch.csum >= 0 && (patch.offset - base) % 2)
+        {
+            NS_FATAL_ERROR("Frame patch seq@" << patch.offset + ETH_HEADER_SIZE
+                           << " covered by a checksum must start at an even offset in its header");
+        }
+    }
+    Split();
+}
+
+void FrameTemplate::Split()
+{
+    // The prefix has to hold every per packet field and the checksums they update
+    uint32_t needed = 0;
+    for (const Patch& patch : m_patches)
+    {
+        needed = std::max<uint32_t>(needed, patch.offset + patch.width);
+        if (patch.csum >= 0)
+        {
+            needed = std::max<uint32_t>(needed, patch.csum + 2);
+        }
+    }
+    if (needed > PrebuiltHeader::MAX_SIZE)
+    {
+        NS_FATAL_ERROR("Per packet frame fields must lie within the first " << PrebuiltHeader::MAX_SIZE
+                       << " bytes after the Ethernet header");
+    }
+    // If the remainder is all zeros it can stay a virtual zero area that copies never touch,
+    // so move the last non-zero byte into the prefix when it fits
+    uint32_t nonZero = m_l3.size();
+    while (nonZero > 0 && m_l3[nonZero - 1] == 0)
+    {
+        nonZero--;
+    }
+    uint32_t prefix = nonZero <= PrebuiltHeader::MAX_SIZE ? std::max(needed, nonZero) : needed;
+    m_hdr.Set(m_l3.data(), prefix);
+    if (prefix >= nonZero)
+    {
+        m_payload = Create<Packet>(m_l3.size() - prefix);
+    }
+    else
+    {
+        m_payload = Create<Packet>(m_l3.data() + prefix, m_l3.size() - prefix);
+    }
+}
+
+Mac48Address FrameTemplate::GetDestination() const
+{
+    return m_dst;
+}
+
+Mac48Address FrameTemplate::GetSource() const
+{
+    return m_src;
+}
+
+uint16_t FrameTemplate::GetProtocol() const
+{
+    return m_protocol;
+}
+
+uint32_t FrameTemplate::GetFrameSize() const
+{
+    return ETH_HEADER_SIZE + m_l3.size();
+}
+
+const PrebuiltHeader& FrameTemplate::GetHeader() const
+{
+    return m_hdr;
+}
+
+Ptr<const Packet> FrameTemplate::GetPayload() const
+{
+    return m_payload;
+}
+
+void FrameTemplate::Stamp(uint8_t* hdr, uint32_t seq) const
+{
+    for (const Patch& patch : m_patches)
+    {
+        uint32_t value = patch.ipId ? (seq & 0xffff) : seq;
+        if (patch.width == 4)
+        {
+            if (patch.csum >= 0)
+            {
+                PatchNet16(hdr, patch.offset, static_cast<uint16_t>(value >> 16), patch.csum);
+                PatchNet16(hdr, patch.offset + 2, static_cast<uint16_t>(value), patch.csum);
+            }
+            else
+            {
+                WriteNet16(hdr + patch.offset, static_cast<uint16_t>(value >> 16));
+                WriteNet16(hdr + patch.offset + 2, static_cast<uint16_t>(value));
+            }
+        }
+        else if (patch.csum >= 0)
+        {
+            PatchNet16(hdr, patch.offset, static_cast<uint16_t>(value), patch.csum);
+        }
+        else
+        {
+            WriteNet16(hdr + patch.offset, static_cast<uint16_t>(value));
+        }
+    }
+}
+
+}
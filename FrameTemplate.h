@@ -0,0 +1,81 @@
+#ifndef FRAME_TEMPLATE_H
+#define FRAME_TEMPLATE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "PrebuiltHeader.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+// A user supplied Ethernet frame, parsed once and shared read-only by every sender.
+// Senders keep their own copy of the patchable prefix (see GetHeader), stamp the declared
+// fields into it per packet with incremental checksum updates, and prepend it to the
+// shared payload. The payload itself is never copied or modified.
+class FrameTemplate : public SimpleRefCount<FrameTemplate> {
+    public:
+        // Whitespace separated hex bytes or runs of bytes, optionally 0x prefixed, e.g. "ffffffffffff 00 00 ..."
+        static Ptr<FrameTemplate> FromHex(const std::string& hex);
+        // Raw frame bytes, or hex text as accepted by FromHex
+        static Ptr<FrameTemplate> FromFile(const std::string& path);
+        // The original 92 byte IPv4/UDP test frame
+        static Ptr<FrameTemplate> TestFrame();
+
+        // Comma separated fields to write, offsets count from the start of the Ethernet header:
+        //   seq@OFFSET[:2|4]  per packet sequence counter, big endian, 4 bytes by default
+        //   ipid              per packet IPv4 identification
+        //   len               set the IPv4 total length and UDP length from the frame size, once
+        //   csum              recompute the IPv4 header and UDP/TCP checksums, once
+        // Per packet fields inside the IPv4 header or a UDP (non-zero checksum)/TCP segment are
+        // followed by an incremental checksum update. Malformed specs are fatal.
+        void SetPatches(const std::string& spec);
+
+        // Destination and source MAC, the all zero address means the flow's peer / own device
+        Mac48Address GetDestination() const;
+        Mac48Address GetSource() const;
+        uint16_t GetProtocol() const;
+        // Frame size including the Ethernet header, excluding the trailer
+        uint32_t GetFrameSize() const;
+
+        // Patchable prefix of the frame after the Ethernet header, copied by each sender
+        const PrebuiltHeader& GetHeader() const;
+        // Rest of the frame, shared by all sends
+        Ptr<const Packet> GetPayload() const;
+        // Write the per packet fields for packet number seq into a sender's copy of the prefix
+        void Stamp(uint8_t* hdr, uint32_t seq) const;
+
+    private:
+        explicit FrameTemplate(const std::vector<uint8_t>& frame);
+
+        // Per packet field
+        struct Patch
+        {
+            uint16_t offset;    // Offset in the prefix
+            uint8_t width;      // 2 or 4 bytes
+            bool ipId;          // IPv4 identification instead of the full sequence number
+            int32_t csum;       // Offset of the checksum covering the field, -1 for none
+        };
+
+        // Checksum covering the field at L3 offset, -1 for none
+        int32_t CoveringChecksum(uint32_t offset) const;
+        void FixLengths();
+        void FixChecksums();
+        // Rebuild the prefix and payload from m_l3 and m_patches
+        void Split();
+
+        Mac48Address m_dst;             // Destination MAC from the frame
+        Mac48Address m_src;             // Source MAC from the frame
+        uint16_t m_protocol;            // EtherType
+        std::vector<uint8_t> m_l3;      // Everything after the Ethernet header
+        uint32_t m_ipHeaderLen;         // IPv4 header length, 0 if the frame is not IPv4
+        std::vector<Patch> m_patches;   // Per packet fields
+        PrebuiltHeader m_hdr;           // Patchable prefix
+        Ptr<Packet> m_payload;          // Shared remainder
+};
+
+}
+
+#endif
@@ -0,0 +1,289 @@
+#include "HopMonitor.h"
+#include "ColumnFile.h"
+
+#include "ns3/csma-module.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("HopMonitor");
+
+HopMonitor& HopMonitor::Get()
+{
+    static HopMonitor instance;
+    return instance;
+}
+
+HopMonitor::HopMonitor()
+{
+    m_enabled = false;
+}
+
+void HopMonitor::Enable()
+{
+    m_enabled = true;
+}
+
+void HopMonitor::Attach(NodeContainer nodes)
+{
+    for (uint32_t n = 0; n < nodes.GetN(); n++)
+    {
+        Ptr<Node> node = nodes.Get(n);
+        for (uint32_t i = 0; i < node->GetNDevices(); i++)
+        {
+            Ptr<CsmaNetDevice> csma = DynamicCast<CsmaNetDevice>(node->GetDevice(i));
+            if (!csma)
+            {
+                continue;
+            }
+
+            Device device;
+            device.nodeId = node->GetId();
+            device.ifIndex = csma->GetIfIndex();
+            device.peer = UINT32_MAX;
+            Ptr<Channel> channel = csma->GetChannel();
+            for (std::size_t d = 0; d < channel->GetNDevices(); d++)
+            {
+                if (channel->GetDevice(d) != csma)
+                {
+                    device.peer = channel->GetDevice(d)->GetNode()->GetId();
+                    break;
+                }
+            }
+            device.label = "n" + std::to_string(device.nodeId) + "->n" + std::to_string(device.peer);
+            device.fifo.resize(64);
+
+            uint32_t index = m_devices.size();
+            m_devices.push_back(std::move(device));
+            csma->TraceConnectWithoutContext("MacTx", MakeBoundCallback(&HopMonitor::OnMacTx, index));
+            csma->TraceConnectWithoutContext("MacTxDrop", MakeBoundCallback(&HopMonitor::OnMacTxDrop, index));
+            csma->TraceConnectWithoutContext("PhyTxBegin", MakeBoundCallback(&HopMonitor::OnTxBegin, index));
+            csma->TraceConnectWithoutContext("PhyTxEnd", MakeBoundCallback(&HopMonitor::OnTxEnd, index));
+            csma->TraceConnectWithoutContext("PhyTxDrop", MakeBoundCallback(&HopMonitor::OnPhyTxDrop, index));
+        }
+    }
+}
+
+HopMonitor::Cell& HopMonitor::GetCell(Device& device, uint32_t flowId)
+{
+    return device.flows[flowId];
+}
+
+// MacTx fires before the frame is offered to the queue, a refused frame is taken back by OnMacTxDrop
+void HopMonitor::OnMacTx(uint32_t device, Ptr<const Packet> pkt)
+{
+    HopTag tag;
+    if (!pkt->PeekPacketTag(tag))
+    {
+        return;
+    }
+    Device& dev = Get().m_devices[device];
+    uint32_t mask = dev.fifo.size() - 1;
+    if (dev.count > mask)
+    {
+        // Unroll the ring into one twice the size
+        std::vector<Waiting> grown(dev.fifo.size() * 2);
+        for (uint32_t i = 0; i < dev.count; i++)
+        {
+            grown[i] = dev.fifo[(dev.head + i) & mask];
+        }
+        dev.fifo.swap(grown);
+        dev.head = 0;
+        mask = dev.fifo.size() - 1;
+    }
+    dev.fifo[(dev.head + dev.count) & mask] = Waiting{tag.GetFlowId(), tag.GetSeq(), tag.GetTxNs(), Simulator::Now().GetNanoSeconds()};
+    dev.count++;
+}
+
+void HopMonitor::OnMacTxDrop(uint32_t device, Ptr<const Packet> pkt)
+{
+    HopTag tag;
+    if (!pkt->PeekPacketTag(tag))
+    {
+        return;
+    }
+    Device& dev = Get().m_devices[device];
+    GetCell(dev, tag.GetFlowId()).drops++;
+    if (dev.count)
+    {
+        const Waiting& last = dev.fifo[(dev.head + dev.count - 1) & (dev.fifo.size() - 1)];
+        if (last.flowId == tag.GetFlowId() && last.seq == tag.GetSeq())
+        {
+            dev.count--;
+        }
+    }
+}
+
+void HopMonitor::OnTxBegin(uint32_t device, Ptr<const Packet> pkt)
+{
+    Device& dev = Get().m_devices[device];
+    dev.current = UINT32_MAX;
+    HopTag tag;
+    if (!pkt->PeekPacketTag(tag))
+    {
+        return;
+    }
+    // Frames ahead of this one that never started were dropped on the way, e.g. by the transmitter
+    uint32_t mask = dev.fifo.size() - 1;
+    while (dev.count)
+    {
+        Waiting frame = dev.fifo[dev.head];
+        dev.head = (dev.head + 1) & mask;
+        dev.count--;
+        if (frame.flowId != tag.GetFlowId() || frame.seq != tag.GetSeq())
+        {
+            continue;
+        }
+        int64_t now = Simulator::Now().GetNanoSeconds();
+        Cell& cell = GetCell(dev, frame.flowId);
+        cell.frames++;
+        cell.arriveNs += frame.enqueueNs - frame.txNs;
+        cell.queueNs += now - frame.enqueueNs;
+        cell.queueMaxNs = std::max(cell.queueMaxNs, now - frame.enqueueNs);
+        dev.current = frame.flowId;
+        dev.beginNs = now;
+        return;
+    }
+}
+
+void HopMonitor::OnTxEnd(uint32_t device, Ptr<const Packet> pkt)
+{
+    Device& dev = Get().m_devices[device];
+    if (dev.current != UINT32_MAX)
+    {
+        GetCell(dev, dev.current).txNs += Simulator::Now().GetNanoSeconds() - dev.beginNs;
+        dev.current = UINT32_MAX;
+    }
+}
+
+void HopMonitor::OnPhyTxDrop(uint32_t device, Ptr<const Packet> pkt)
+{
+    HopTag tag;
+    if (!pkt->PeekPacketTag(tag))
+    {
+        return;
+    }
+    Device& dev = Get().m_devices[device];
+    GetCell(dev, tag.GetFlowId()).drops++;
+    if (dev.count)
+    {
+        const Waiting& first = dev.fifo[dev.head];
+        if (first.flowId == tag.GetFlowId() && first.seq == tag.GetSeq())
+        {
+            dev.head = (dev.head + 1) & (dev.fifo.size() - 1);
+            dev.count--;
+        }
+    }
+}
+
+std::vector<HopMonitor::Row> HopMonitor::Rows() const
+{
+    std::vector<Row> rows;
+    for (uint32_t d = 0; d < m_devices.size(); d++)
+    {
+        for (const auto& entry : m_devices[d].flows)
+        {
+            rows.push_back(Row{entry.first, d, &entry.second});
+        }
+    }
+    // Later hops have a larger mean delay up to their queue, devices that only dropped go last.
+    // Ties keep device order, the maps hand out flows in no particular order.
+    auto arrive = [](const Cell* cell) {
+        return cell->frames ? static_cast<double>(cell->arriveNs) / cell->frames : 1e300;
+    };
+    std::sort(rows.begin(), rows.end(), [&](const Row& a, const Row& b) {
+        if (a.flowId != b.flowId)
+        {
+            return a.flowId < b.flowId;
+        }
+        if (arrive(a.cell) != arrive(b.cell))
+        {
+            return arrive(a.cell) < arrive(b.cell);
+        }
+        return a.device < b.device;
+    });
+    return rows;
+}
+
+void HopMonitor::Print(std::ostream& os, uint32_t maxFlows) const
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    std::vector<Row> rows = Rows();
+    os << std::fixed << std::setprecision(3);
+    uint32_t printed = 0;
+    uint32_t flow = UINT32_MAX;
+    for (const Row& row : rows)
+    {
+        if (row.flowId != flow)
+        {
+            if (printed == maxFlows)
+            {
+                break;
+            }
+            flow = row.flowId;
+            printed++;
+            os << "Flow " << flow << " hops (ms):" << std::endl;
+        }
+        const Cell& cell = *row.cell;
+        double frames = cell.frames ? static_cast<double>(cell.frames) : 1.0;
+        os << "    " << m_devices[row.device].label << ": " << cell.frames << " frames, arrive "
+           << cell.arriveNs / frames / 1e6 << ", queue avg " << cell.queueNs / frames / 1e6 << " max "
+           << cell.queueMaxNs / 1e6 << ", tx " << cell.txNs / frames / 1e6 << ", " << cell.drops << " drops" << std::endl;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+bool HopMonitor::Write(const std::string& path) const
+{
+    std::vector<Row> rows = Rows();
+    ColumnWriter table(rows.size());
+    table.AddColumn("flow", COLUMN_U64);
+    table.AddColumn("hop", COLUMN_U64);
+    table.AddColumn("node", COLUMN_U64);
+    table.AddColumn("device", COLUMN_U64);
+    table.AddColumn("peer", COLUMN_U64);
+    table.AddColumn("frames", COLUMN_U64);
+    table.AddColumn("drops", COLUMN_U64);
+    table.AddColumn("arrive_mean_ns", COLUMN_F64);
+    table.AddColumn("queue_mean_ns", COLUMN_F64);
+    table.AddColumn("queue_max_ns", COLUMN_I64);
+    table.AddColumn("tx_mean_ns", COLUMN_F64);
+    uint64_t* flow = table.Column(0);
+    uint64_t* hop = table.Column(1);
+    uint64_t* node = table.Column(2);
+    uint64_t* device = table.Column(3);
+    uint64_t* peer = table.Column(4);
+    uint64_t* frames = table.Column(5);
+    uint64_t* drops = table.Column(6);
+    uint64_t* arrive = table.Column(7);
+    uint64_t* queue = table.Column(8);
+    uint64_t* queueMax = table.Column(9);
+    uint64_t* tx = table.Column(10);
+
+    for (uint32_t r = 0; r < rows.size(); r++)
+    {
+        const Row& row = rows[r];
+        const Device& dev = m_devices[row.device];
+        const Cell& cell = *row.cell;
+        double n = cell.frames ? static_cast<double>(cell.frames) : 1.0;
+        flow[r] = row.flowId;
+        hop[r] = r > 0 && rows[r - 1].flowId == row.flowId ? hop[r - 1] + 1 : 0;
+        node[r] = dev.nodeId;
+        device[r] = dev.ifIndex;
+        peer[r] = dev.peer;
+        frames[r] = cell.frames;
+        drops[r] = cell.drops;
+        arrive[r] = ColumnWriter::Bits(cell.arriveNs / n);
+        queue[r] = ColumnWriter::Bits(cell.queueNs / n);
+        queueMax[r] = static_cast<uint64_t>(cell.queueMaxNs);
+        tx[r] = ColumnWriter::Bits(cell.txNs / n);
+    }
+    return table.Write(path);
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef HOP_MONITOR_H
+#define HOP_MONITOR_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "HopTag.h"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+// Per flow, per hop delay breakdown for raw L2 traffic, which never passes the IP hooks
+// FlowMonitor relies on. Senders tag each frame with its flow, sequence number and send
+// time. Every CSMA device, endpoint or switch port, matches tagged frames between
+// accepting them (MacTx), starting to send them (PhyTxBegin) and finishing (PhyTxEnd):
+//   arrive  send time to entering the device queue, everything upstream of this hop
+//   queue   waiting in the device queue
+//   tx      serialization onto the link
+// The gap between one hop's arrive + queue + tx and the next hop's arrive is propagation
+// plus switching. Devices send in FIFO order, so only a ring of frame ids per device is
+// kept, the rest is running sums per (flow, device).
+class HopMonitor {
+    public:
+        static HopMonitor& Get();
+
+        // Senders tag their frames from now on
+        void Enable();
+        bool IsEnabled() const;
+        // Hook the transmit path traces of all CSMA devices on nodes
+        void Attach(NodeContainer nodes);
+
+        // Tag a frame about to be sent, replacing the tag of a frame that is sent on (echo replies)
+        void Tag(Ptr<Packet> pkt, uint32_t flowId, uint32_t seq) const;
+
+        // Hops of the first maxFlows flows in path order, i.e. by arrive delay
+        void Print(std::ostream& os, uint32_t maxFlows = UINT32_MAX) const;
+        // One row per (flow, device) as a columnar table, see ColumnFile.h and the colcsv tool
+        bool Write(const std::string& path) const;
+
+    private:
+        struct Waiting
+        {
+            uint32_t flowId;
+            uint32_t seq;
+            int64_t txNs;           // Send time from the tag
+            int64_t enqueueNs;      // When the device accepted the frame
+        };
+
+        struct Cell
+        {
+            uint64_t frames = 0;    // Frames that started transmission
+            uint64_t drops = 0;     // Frames refused or dropped by the device
+            int64_t arriveNs = 0;   // Sum of send to enqueue times
+            int64_t queueNs = 0;    // Sum of queueing delays
+            int64_t queueMaxNs = 0; // Largest queueing delay
+            int64_t txNs = 0;       // Sum of transmission times
+        };
+
+        struct Device
+        {
+            std::string label;              // e.g. "n2->n3"
+            uint32_t nodeId;
+            uint32_t ifIndex;
+            uint32_t peer;                  // Node on the other end of the link
+            std::vector<Waiting> fifo;      // Tagged frames in the device queue, power of two ring
+            uint32_t head = 0;              // Oldest waiting frame
+            uint32_t count = 0;             // Waiting frames
+            uint32_t current = UINT32_MAX;  // Flow of the frame being sent, UINT32_MAX if untagged or idle
+            int64_t beginNs = 0;            // Start of the transmission in progress
+            std::unordered_map<uint32_t, Cell> flows;   // Sums by flow id, only flows seen here
+        };
+
+        struct Row
+        {
+            uint32_t flowId;
+            uint32_t device;
+            const Cell* cell;
+        };
+
+        HopMonitor();
+
+        static void OnMacTx(uint32_t device, Ptr<const Packet> pkt);
+        static void OnMacTxDrop(uint32_t device, Ptr<const Packet> pkt);
+        static void OnTxBegin(uint32_t device, Ptr<const Packet> pkt);
+        static void OnTxEnd(uint32_t device, Ptr<const Packet> pkt);
+        static void OnPhyTxDrop(uint32_t device, Ptr<const Packet> pkt);
+        static Cell& GetCell(Device& device, uint32_t flowId);
+        // Every (flow, device) that saw a tagged frame, by flow and then in path order
+        std::vector<Row> Rows() const;
+
+        bool m_enabled;                 // Senders tag frames
+        std::vector<Device> m_devices;  // One entry per hooked device
+};
+
+inline bool HopMonitor::IsEnabled() const
+{
+    return m_enabled;
+}
+
+inline void HopMonitor::Tag(Ptr<Packet> pkt, uint32_t flowId, uint32_t seq) const
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    HopTag tag(flowId, seq, Simulator::Now());
+    if (!pkt->ReplacePacketTag(tag))
+    {
+        pkt->AddPacketTag(tag);
+    }
+}
+
+}
+
+#endif
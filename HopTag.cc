@@ -0,0 +1,77 @@
+#include "HopTag.h"
+
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("HopTag");
+NS_OBJECT_ENSURE_REGISTERED(HopTag);
+
+TypeId HopTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::HopTag")
+                        .SetParent<Tag>()
+                        .AddConstructor<HopTag>()
+                        ;
+    return tid;
+}
+
+TypeId HopTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+HopTag::HopTag()
+{
+    m_flowId = 0;
+    m_seq = 0;
+    m_txNs = 0;
+}
+
+HopTag::HopTag(uint32_t flowId, uint32_t seq, Time txTime)
+{
+    m_flowId = flowId;
+    m_seq = seq;
+    m_txNs = txTime.GetNanoSeconds();
+}
+
+uint32_t HopTag::GetFlowId() const
+{
+    return m_flowId;
+}
+
+uint32_t HopTag::GetSeq() const
+{
+    return m_seq;
+}
+
+int64_t HopTag::GetTxNs() const
+{
+    return m_txNs;
+}
+
+uint32_t HopTag::GetSerializedSize() const
+{
+    return SIZE;
+}
+
+void HopTag::Serialize(TagBuffer buf) const
+{
+    buf.WriteU32(m_flowId);
+    buf.WriteU32(m_seq);
+    buf.WriteU64(static_cast<uint64_t>(m_txNs));
+}
+
+void HopTag::Deserialize(TagBuffer buf)
+{
+    m_flowId = buf.ReadU32();
+    m_seq = buf.ReadU32();
+    m_txNs = static_cast<int64_t>(buf.ReadU64());
+}
+
+void HopTag::Print(std::ostream& os) const
+{
+    os << "flow=" << m_flowId << " seq=" << m_seq << " tx=" << m_txNs << "ns";
+}
+
+}
@@ -0,0 +1,40 @@
+#ifndef HOP_TAG_H
+#define HOP_TAG_H
+
+#include "ns3/tag.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+// Packet tag put on frames by senders while the hop monitor is on. Tags survive the
+// copies made by switches and devices, so every device on the path can attribute the
+// frame to its flow without parsing it, whatever the frame carries.
+class HopTag : public Tag {
+    public:
+        static const uint32_t SIZE = 16;
+
+        static TypeId GetTypeId(void);
+        TypeId GetInstanceTypeId(void) const override;
+
+        HopTag();
+        HopTag(uint32_t flowId, uint32_t seq, Time txTime);
+
+        uint32_t GetFlowId() const;
+        uint32_t GetSeq() const;
+        int64_t GetTxNs() const;
+
+        uint32_t GetSerializedSize(void) const override;
+        void Serialize(TagBuffer buf) const override;
+        void Deserialize(TagBuffer buf) override;
+        void Print(std::ostream& os) const override;
+
+    private:
+        uint32_t m_flowId;      // Flow the frame belongs to
+        uint32_t m_seq;         // Per flow frame number
+        int64_t m_txNs;         // When the sender handed the frame to its device
+};
+
+}
+
+#endif
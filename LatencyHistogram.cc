@@ -0,0 +1,153 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+
+LatencyHistogram::LatencyHistogram()
+{
+    m_count = 0;
+    m_min = std::numeric_limits<uint64_t>::max();
+    m_max = 0;
+    m_sum = 0;
+}
+
+// Values below SUB_COUNT map linearly. Above, the position of the most significant bit
+// picks the power of two range and the next SUB_BITS bits pick the sub-bucket.
+uint32_t LatencyHistogram::BucketIndex(uint64_t value)
+{
+    if (value < SUB_COUNT)
+    {
+        return static_cast<uint32_t>(value);
+    }
+    uint32_t msb = 63 - __builtin_clzll(value);
+    if (msb >= MAX_BITS)
+    {
+        return BUCKET_COUNT - 1;
+    }
+    uint32_t shift = msb - SUB_BITS;
+    return ((shift + 1) << SUB_BITS) + static_cast<uint32_t>((value >> shift) & (SUB_COUNT - 1));
+}
+
+uint64_t LatencyHistogram::BucketUpperEdge(uint32_t index)
+{
+    if (index < SUB_COUNT)
+    {
+        return index;
+    }
+    uint32_t shift = (index >> SUB_BITS) - 1;
+    uint64_t sub = (index & (SUB_COUNT - 1)) | SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    if (m_buckets.empty())
+    {
+        m_buckets.resize(BUCKET_COUNT, 0);
+    }
+    m_buckets[BucketIndex(value)]++;
+    m_count++;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    m_sum += static_cast<double>(value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+    if (other.m_count == 0)
+    {
+        return;
+    }
+    if (m_buckets.empty())
+    {
+        m_buckets.resize(BUCKET_COUNT, 0);
+    }
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+}
+
+uint64_t LatencyHistogram::Percentile(double q) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(m_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += m_buckets[i];
+        if (seen >= rank)
+        {
+            // Never report beyond what was actually observed
+            return std::min(BucketUpperEdge(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+uint64_t LatencyHistogram::GetCount() const
+{
+    return m_count;
+}
+
+uint64_t LatencyHistogram::GetMin() const
+{
+    return m_count ? m_min : 0;
+}
+
+uint64_t LatencyHistogram::GetMax() const
+{
+    return m_max;
+}
+
+double LatencyHistogram::GetMean() const
+{
+    return m_count ? m_sum / static_cast<double>(m_count) : 0.0;
+}
+
+const std::vector<uint64_t>& LatencyHistogram::GetBuckets() const
+{
+    return m_buckets;
+}
+
+void LatencyHistogram::Save(std::vector<uint64_t>& out) const
+{
+    uint64_t sum;
+    std::memcpy(&sum, &m_sum, sizeof(sum));
+    out.push_back(m_count);
+    out.push_back(m_min);
+    out.push_back(m_max);
+    out.push_back(sum);
+    if (m_count)
+    {
+        out.insert(out.end(), m_buckets.begin(), m_buckets.end());
+    }
+}
+
+const uint64_t* LatencyHistogram::Load(const uint64_t* in)
+{
+    m_count = in[0];
+    m_min = in[1];
+    m_max = in[2];
+    std::memcpy(&m_sum, &in[3], sizeof(m_sum));
+    in += 4;
+    m_buckets.clear();
+    if (m_count)
+    {
+        m_buckets.assign(in, in + BUCKET_COUNT);
+        in += BUCKET_COUNT;
+    }
+    return in;
+}
+
+}
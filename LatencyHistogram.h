@@ -0,0 +1,55 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+// HDR style log-bucketed histogram of non-negative values (nanoseconds). Each power of
+// two range is split into 2^SUB_BITS linear sub-buckets, so recording is a couple of
+// shifts and one counter increment, and the relative error is bounded by 2^-SUB_BITS.
+class LatencyHistogram {
+    public:
+        static const uint32_t SUB_BITS = 5;             // 32 sub-buckets, ~3% resolution
+        static const uint32_t MAX_BITS = 40;            // Values up to ~1100s
+        static const uint32_t SUB_COUNT = 1u << SUB_BITS;
+        static const uint32_t BUCKET_COUNT = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+        LatencyHistogram();
+
+        // Record one value, clamps values beyond the covered range
+        void Record(uint64_t value);
+        // Add all counts of other into this histogram
+        void Merge(const LatencyHistogram& other);
+
+        // Value at quantile q in [0, 1], reported as the upper edge of its bucket
+        uint64_t Percentile(double q) const;
+
+        uint64_t GetCount() const;
+        uint64_t GetMin() const;
+        uint64_t GetMax() const;
+        double GetMean() const;
+
+        // Raw bucket access for merging across processes
+        const std::vector<uint64_t>& GetBuckets() const;
+        // Append the histogram to out as 64 bit words: count, min, max, sum, then the buckets unless empty
+        void Save(std::vector<uint64_t>& out) const;
+        // Replace the histogram with one saved by Save, returns the word after it
+        const uint64_t* Load(const uint64_t* in);
+
+        static uint32_t BucketIndex(uint64_t value);
+        static uint64_t BucketUpperEdge(uint32_t index);
+
+    private:
+        std::vector<uint64_t> m_buckets;    // Allocated on first record
+        uint64_t m_count;                   // Values recorded
+        uint64_t m_min;                     // Smallest value recorded
+        uint64_t m_max;                     // Largest value recorded
+        double m_sum;                       // Sum of values, for the mean
+};
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+#include "LinkMonitor.h"
+
+#include "ns3/csma-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("LinkMonitor");
+
+LinkMonitor& LinkMonitor::Get()
+{
+    static LinkMonitor instance;
+    return instance;
+}
+
+LinkMonitor::LinkMonitor()
+{
+    m_sampleCount = 0;
+}
+
+void LinkMonitor::Attach(NodeContainer nodes)
+{
+    m_start = Simulator::Now();
+    for (uint32_t n = 0; n < nodes.GetN(); n++)
+    {
+        Ptr<Node> node = nodes.Get(n);
+        for (uint32_t i = 0; i < node->GetNDevices(); i++)
+        {
+            Ptr<CsmaNetDevice> csma = DynamicCast<CsmaNetDevice>(node->GetDevice(i));
+            if (!csma)
+            {
+                continue;
+            }
+
+            // Name the link after the node on the other end of the channel
+            std::ostringstream label;
+            label << "n" << node->GetId() << "->";
+            Ptr<Channel> channel = csma->GetChannel();
+            for (std::size_t d = 0; d < channel->GetNDevices(); d++)
+            {
+                if (channel->GetDevice(d) != csma)
+                {
+                    label << "n" << channel->GetDevice(d)->GetNode()->GetId();
+                }
+            }
+
+            uint32_t link = m_links.size();
+            m_links.emplace_back();
+            m_links.back().label = label.str();
+
+            Ptr<Queue<Packet>> queue = csma->GetQueue();
+            queue->TraceConnectWithoutContext("PacketsInQueue", MakeBoundCallback(&LinkMonitor::OnPackets, link));
+            queue->TraceConnectWithoutContext("BytesInQueue", MakeBoundCallback(&LinkMonitor::OnBytes, link));
+            csma->TraceConnectWithoutContext("PhyTxBegin", MakeBoundCallback(&LinkMonitor::OnTxBegin, link));
+            csma->TraceConnectWithoutContext("PhyTxEnd", MakeBoundCallback(&LinkMonitor::OnTxEnd, link));
+        }
+    }
+}
+
+void LinkMonitor::EnableSampling(Time interval, uint32_t slots, Time stop)
+{
+    m_interval = interval;
+    m_stop = stop;
+    m_samples.assign(static_cast<std::size_t>(slots) * m_links.size(), Sample{});
+    m_sampleCount = 0;
+    if (m_interval.IsStrictlyPositive() && !m_samples.empty() && Simulator::Now() + m_interval <= m_stop)
+    {
+        Simulator::Schedule(m_interval, &LinkMonitor::TakeSample, this);
+    }
+}
+
+void LinkMonitor::OnPackets(uint32_t link, uint32_t oldValue, uint32_t newValue)
+{
+    LinkState& state = Get().m_links[link];
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    state.packetsArea += static_cast<double>(oldValue) * (now - state.lastPacketsNs);
+    state.lastPacketsNs = now;
+    state.packets = newValue;
+    state.maxPackets = std::max(state.maxPackets, newValue);
+}
+
+void LinkMonitor::OnBytes(uint32_t link, uint32_t oldValue, uint32_t newValue)
+{
+    LinkState& state = Get().m_links[link];
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    state.bytesArea += static_cast<double>(oldValue) * (now - state.lastBytesNs);
+    state.lastBytesNs = now;
+    state.bytes = newValue;
+    state.maxBytes = std::max(state.maxBytes, newValue);
+}
+
+void LinkMonitor::OnTxBegin(uint32_t link, Ptr<const Packet> pkt)
+{
+    Get().m_links[link].txStartNs = Simulator::Now().GetNanoSeconds();
+}
+
+void LinkMonitor::OnTxEnd(uint32_t link, Ptr<const Packet> pkt)
+{
+    LinkState& state = Get().m_links[link];
+    if (state.txStartNs >= 0)
+    {
+        state.busyNs += Simulator::Now().GetNanoSeconds() - state.txStartNs;
+        state.txStartNs = -1;
+    }
+    state.txFrames++;
+}
+
+int64_t LinkMonitor::BusyAt(const LinkState& link, int64_t nowNs) const
+{
+    return link.busyNs + (link.txStartNs >= 0 ? nowNs - link.txStartNs : 0);
+}
+
+void LinkMonitor::TakeSample()
+{
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    double period = static_cast<double>(m_interval.GetNanoSeconds());
+    for (uint32_t link = 0; link < m_links.size(); link++)
+    {
+        LinkState& state = m_links[link];
+        int64_t busy = BusyAt(state, now);
+        Sample& sample = m_samples[m_sampleCount++ % m_samples.size()];
+        sample.timeNs = now;
+        sample.link = link;
+        sample.packets = state.packets;
+        sample.bytes = state.bytes;
+        sample.utilization = static_cast<float>((busy - state.sampledBusyNs) / period);
+        state.sampledBusyNs = busy;
+    }
+    if (Simulator::Now() + m_interval <= m_stop)
+    {
+        Simulator::Schedule(m_interval, &LinkMonitor::TakeSample, this);
+    }
+}
+
+void LinkMonitor::Print(std::ostream& os) const
+{
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    double elapsed = static_cast<double>(now - m_start.GetNanoSeconds());
+    if (elapsed <= 0)
+    {
+        return;
+    }
+    os << std::fixed << std::setprecision(3);
+    for (const LinkState& link : m_links)
+    {
+        if (link.txFrames == 0 && link.maxPackets == 0)
+        {
+            continue;
+        }
+        // Close the integrals up to now
+        double packetsArea = link.packetsArea + static_cast<double>(link.packets) * (now - link.lastPacketsNs);
+        double bytesArea = link.bytesArea + static_cast<double>(link.bytes) * (now - link.lastBytesNs);
+        os << "Link " << link.label << ": queue avg " << packetsArea / elapsed << "p / " << bytesArea / elapsed
+           << "B, max " << link.maxPackets << "p / " << link.maxBytes << "B, utilization "
+           << 100.0 * BusyAt(link, now) / elapsed << "%, " << link.txFrames << " frames" << std::endl;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+void LinkMonitor::WriteSamples(const std::string& path) const
+{
+    if (m_sampleCount == 0)
+    {
+        return;
+    }
+    std::ofstream out(path);
+    out << "time_s,link,packets,bytes,utilization\n";
+    // Oldest retained sample first
+    uint64_t first = m_sampleCount > m_samples.size() ? m_sampleCount - m_samples.size() : 0;
+    for (uint64_t i = first; i < m_sampleCount; i++)
+    {
+        const Sample& sample = m_samples[i % m_samples.size()];
+        out << sample.timeNs / 1e9 << "," << m_links[sample.link].label << "," << sample.packets << ","
+            << sample.bytes << "," << sample.utilization << "\n";
+    }
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+// Queue occupancy and link utilization for CSMA devices. Trace sinks only update the
+// per device accumulators (time weighted occupancy, maxima, busy time). Periodic samples
+// are taken by a separate event into a preallocated ring, so the packet path never
+// allocates or formats anything.
+class LinkMonitor {
+    public:
+        static LinkMonitor& Get();
+
+        // Hook queue and transmitter traces of all CSMA devices on nodes
+        void Attach(NodeContainer nodes);
+        // Sample every attached device each interval until stop, keeping the last slots samples per device
+        void EnableSampling(Time interval, uint32_t slots, Time stop);
+
+        // Time weighted average and maximum occupancy, busy fraction of the transmitter
+        void Print(std::ostream& os) const;
+        // Ring contents as CSV: time, device label, packets, bytes, utilization since the previous sample
+        void WriteSamples(const std::string& path) const;
+
+    private:
+        struct LinkState
+        {
+            std::string label;          // e.g. "n2->n3"
+            uint32_t packets = 0;       // Current queue length
+            uint32_t bytes = 0;         // Current queue bytes
+            uint32_t maxPackets = 0;    // Largest queue length seen
+            uint32_t maxBytes = 0;      // Largest queue bytes seen
+            int64_t lastPacketsNs = 0;  // Time of the last packet count change
+            int64_t lastBytesNs = 0;    // Time of the last byte count change
+            double packetsArea = 0;     // Integral of packets over time (packet * ns)
+            double bytesArea = 0;       // Integral of bytes over time (byte * ns)
+            int64_t txStartNs = -1;     // Start of the transmission in progress, -1 if idle
+            int64_t busyNs = 0;         // Total transmitter busy time
+            uint64_t txFrames = 0;      // Transmissions completed
+            int64_t sampledBusyNs = 0;  // busyNs at the previous sample
+        };
+
+        struct Sample
+        {
+            int64_t timeNs;
+            uint32_t link;
+            uint32_t packets;
+            uint32_t bytes;
+            float utilization;
+        };
+
+        LinkMonitor();
+
+        static void OnPackets(uint32_t link, uint32_t oldValue, uint32_t newValue);
+        static void OnBytes(uint32_t link, uint32_t oldValue, uint32_t newValue);
+        static void OnTxBegin(uint32_t link, Ptr<const Packet> pkt);
+        static void OnTxEnd(uint32_t link, Ptr<const Packet> pkt);
+        void TakeSample();
+        // Busy time including a transmission still in progress
+        int64_t BusyAt(const LinkState& link, int64_t nowNs) const;
+
+        std::vector<LinkState> m_links;     // One entry per hooked device
+        Time m_start;                       // When monitoring began
+        Time m_interval;                    // Sampling period, zero if sampling is off
+        Time m_stop;                        // No samples after this, so the event queue drains
+        std::vector<Sample> m_samples;      // Sample ring
+        uint64_t m_sampleCount;             // Samples taken, ring index is this modulo the ring size
+};
+
+}
+
+#endif
@@ -0,0 +1,342 @@
+#ifndef PCAP_MAP_H
+#define PCAP_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Sequential reader for pcap and pcapng captures. The file is memory-mapped one window at a
+// time and records are returned as views into the mapping, so walking a capture allocates
+// nothing per record and multi-GB files never need to fit in memory. Kept free of ns-3
+// headers so offline tools can use it.
+
+namespace ns3
+{
+
+static const uint32_t PCAP_LINKTYPE_ETHERNET = 1;
+
+// One captured frame, data stays valid until the next call to PcapMap::Next
+struct PcapRecord
+{
+    uint64_t timeNs;        // Capture timestamp
+    uint32_t capLen;        // Bytes captured
+    uint32_t origLen;       // Bytes on the wire
+    uint32_t linkType;      // Link type of the capturing interface
+    const uint8_t* data;    // capLen bytes
+};
+
+class PcapMap {
+    public:
+        PcapMap() = default;
+        PcapMap(const PcapMap&) = delete;
+        PcapMap& operator=(const PcapMap&) = delete;
+
+        ~PcapMap()
+        {
+            Close();
+        }
+
+        // Map windowBytes of the file at a time (rounded to whole pages). Returns false with error set
+        // if the file can not be opened or is neither pcap nor pcapng.
+        bool Open(const std::string& path, std::string& error, uint64_t windowBytes = 64 << 20)
+        {
+            Close();
+            m_fd = ::open(path.c_str(), O_RDONLY);
+            struct stat st;
+            if (m_fd < 0 || fstat(m_fd, &st) != 0)
+            {
+                error = "could not open " + path;
+                Close();
+                return false;
+            }
+            m_fileSize = st.st_size;
+            m_page = sysconf(_SC_PAGESIZE);
+            m_window = std::max<uint64_t>(m_page, (windowBytes + m_page - 1) / m_page * m_page);
+
+            const uint8_t* p = Map(0, 4);
+            if (!p)
+            {
+                error = path + " is too short for a capture";
+                Close();
+                return false;
+            }
+            uint32_t magic;
+            std::memcpy(&magic, p, 4);
+            if (magic == 0x0A0D0D0A)
+            {
+                m_ng = true;
+                m_offset = 0;
+                return true;
+            }
+            m_ng = false;
+            m_swapped = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+            if (magic != 0xa1b2c3d4 && magic != 0xa1b23c4d && !m_swapped)
+            {
+                error = path + " is neither pcap nor pcapng";
+                Close();
+                return false;
+            }
+            m_nanoTs = magic == 0xa1b23c4d || magic == 0x4d3cb2a1;
+            p = Map(0, 24);
+            if (!p)
+            {
+                error = path + " has a truncated pcap header";
+                Close();
+                return false;
+            }
+            m_linkType = Read32(p + 20) & 0xffff;
+            m_offset = 24;
+            return true;
+        }
+
+        void Close()
+        {
+            Unmap();
+            if (m_fd >= 0)
+            {
+                ::close(m_fd);
+                m_fd = -1;
+            }
+            m_interfaces.clear();
+            m_lastTimeNs = 0;
+        }
+
+        // Next frame in file order, false at the end of the file or at a truncated record
+        bool Next(PcapRecord& rec)
+        {
+            return m_ng ? NextNg(rec) : NextPcap(rec);
+        }
+
+        // Link type of a classic pcap file, pcapng carries it per record
+        uint32_t GetLinkType() const
+        {
+            return m_linkType;
+        }
+
+        uint64_t GetFileSize() const
+        {
+            return m_fileSize;
+        }
+
+        // Bytes consumed so far
+        uint64_t GetOffset() const
+        {
+            return m_offset;
+        }
+
+    private:
+        // Per pcapng interface description
+        struct Interface
+        {
+            uint32_t linkType;
+            bool binaryResolution;  // Timestamp unit is 2^-exponent instead of 10^-exponent seconds
+            uint8_t exponent;
+        };
+
+        // View of [offset, offset + len), remapping the window if needed. Null past the end of the file.
+        const uint8_t* Map(uint64_t offset, uint64_t len)
+        {
+            if (offset + len > m_fileSize)
+            {
+                return nullptr;
+            }
+            if (m_base && offset >= m_winStart && offset + len <= m_winStart + m_winSize)
+            {
+                return m_base + (offset - m_winStart);
+            }
+            Unmap();
+            m_winStart = offset / m_page * m_page;
+            m_winSize = std::max<uint64_t>(m_window, offset + len - m_winStart);
+            m_winSize = std::min<uint64_t>(m_winSize, m_fileSize - m_winStart);
+            void* base = mmap(nullptr, m_winSize, PROT_READ, MAP_PRIVATE, m_fd, m_winStart);
+            if (base == MAP_FAILED)
+            {
+                return nullptr;
+            }
+            m_base = static_cast<const uint8_t*>(base);
+            madvise(base, m_winSize, MADV_SEQUENTIAL);
+            return m_base + (offset - m_winStart);
+        }
+
+        void Unmap()
+        {
+            if (m_base)
+            {
+                munmap(const_cast<uint8_t*>(m_base), m_winSize);
+                m_base = nullptr;
+            }
+        }
+
+        uint16_t Read16(const uint8_t* p) const
+        {
+            uint16_t v;
+            std::memcpy(&v, p, 2);
+            return m_swapped ? __builtin_bswap16(v) : v;
+        }
+
+        uint32_t Read32(const uint8_t* p) const
+        {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return m_swapped ? __builtin_bswap32(v) : v;
+        }
+
+        bool NextPcap(PcapRecord& rec)
+        {
+            const uint8_t* hdr = Map(m_offset, 16);
+            if (!hdr)
+            {
+                return false;
+            }
+            uint32_t sec = Read32(hdr);
+            uint32_t frac = Read32(hdr + 4);
+            rec.capLen = Read32(hdr + 8);
+            rec.origLen = Read32(hdr + 12);
+            rec.timeNs = sec * 1000000000ull + (m_nanoTs ? frac : frac * 1000ull);
+            rec.linkType = m_linkType;
+            rec.data = Map(m_offset + 16, rec.capLen);
+            if (!rec.data)
+            {
+                return false;
+            }
+            m_offset += 16 + rec.capLen;
+            return true;
+        }
+
+        uint64_t ToNs(uint64_t ts, const Interface& iface) const
+        {
+            if (iface.binaryResolution)
+            {
+                return static_cast<uint64_t>((static_cast<unsigned __int128>(ts) * 1000000000u) >> iface.exponent);
+            }
+            uint64_t scale = 1;
+            for (uint8_t i = iface.exponent; i < 9; i++)
+            {
+                scale *= 10;
+            }
+            uint64_t ns = ts * scale;
+            for (uint8_t i = 9; i < iface.exponent; i++)
+            {
+                ns /= 10;
+            }
+            return ns;
+        }
+
+        bool NextNg(PcapRecord& rec)
+        {
+            while (true)
+            {
+                // Every block is at least type, length and trailing length
+                const uint8_t* hdr = Map(m_offset, 12);
+                if (!hdr)
+                {
+                    return false;
+                }
+                uint32_t type;
+                std::memcpy(&type, hdr, 4);
+                if (type == 0x0A0D0D0A)
+                {
+                    // Section header: the byte order magic decides how the section is read
+                    uint32_t magic;
+                    std::memcpy(&magic, hdr + 8, 4);
+                    m_swapped = magic == 0x4D3C2B1A;
+                    m_interfaces.clear();
+                }
+                else
+                {
+                    type = Read32(hdr);
+                }
+                uint32_t blockLen = Read32(hdr + 4);
+                if (blockLen < 12 || blockLen % 4)
+                {
+                    return false;
+                }
+                const uint8_t* block = Map(m_offset, blockLen);
+                if (!block)
+                {
+                    return false;
+                }
+                m_offset += blockLen;
+                const uint8_t* body = block + 8;
+                uint32_t bodyLen = blockLen - 12;
+
+                if (type == 1 && bodyLen >= 8)
+                {
+                    // Interface description, look for if_tsresol among the options
+                    Interface iface = {Read16(body), false, 6};
+                    for (uint32_t o = 8; o + 4 <= bodyLen;)
+                    {
+                        uint16_t code = Read16(body + o);
+                        uint16_t len = Read16(body + o + 2);
+                        if (code == 0)
+                        {
+                            break;
+                        }
+                        if (code == 9 && len >= 1 && o + 5 <= bodyLen)
+                        {
+                            iface.binaryResolution = body[o + 4] & 0x80;
+                            iface.exponent = body[o + 4] & 0x7f;
+                        }
+                        o += 4 + (len + 3) / 4 * 4;
+                    }
+                    m_interfaces.push_back(iface);
+                }
+                else if ((type == 6 || type == 2) && bodyLen >= 20)
+                {
+                    // Enhanced packet, or the obsolete packet block with a 16 bit interface id
+                    uint32_t ifId = type == 6 ? Read32(body) : Read16(body);
+                    if (ifId >= m_interfaces.size())
+                    {
+                        continue;
+                    }
+                    uint64_t ts = (static_cast<uint64_t>(Read32(body + 4)) << 32) | Read32(body + 8);
+                    rec.capLen = Read32(body + 12);
+                    rec.origLen = Read32(body + 16);
+                    if (20 + rec.capLen > bodyLen)
+                    {
+                        return false;
+                    }
+                    rec.timeNs = m_lastTimeNs = ToNs(ts, m_interfaces[ifId]);
+                    rec.linkType = m_interfaces[ifId].linkType;
+                    rec.data = body + 20;
+                    return true;
+                }
+                else if (type == 3 && bodyLen >= 4 && !m_interfaces.empty())
+                {
+                    // Simple packet: interface 0, no timestamp, keep the previous one
+                    rec.origLen = Read32(body);
+                    rec.capLen = std::min(rec.origLen, bodyLen - 4);
+                    rec.timeNs = m_lastTimeNs;
+                    rec.linkType = m_interfaces[0].linkType;
+                    rec.data = body + 4;
+                    return true;
+                }
+            }
+        }
+
+        int m_fd = -1;                  // Capture file
+        uint64_t m_fileSize = 0;        // Bytes in the file
+        uint64_t m_page = 4096;         // mmap offset granularity
+        uint64_t m_window = 0;          // Bytes mapped at a time
+        const uint8_t* m_base = nullptr;    // Current window
+        uint64_t m_winStart = 0;        // File offset of the window
+        uint64_t m_winSize = 0;         // Bytes in the window
+        uint64_t m_offset = 0;          // Next unread byte
+        bool m_ng = false;              // File is pcapng
+        bool m_swapped = false;         // File byte order differs from ours
+        bool m_nanoTs = false;          // Classic pcap with nanosecond timestamps
+        uint32_t m_linkType = 0;        // Classic pcap link type
+        uint64_t m_lastTimeNs = 0;      // Timestamp of the previous pcapng packet
+        std::vector<Interface> m_interfaces;    // Interfaces of the current pcapng section
+};
+
+}
+
+#endif
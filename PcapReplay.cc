@@ -0,0 +1,258 @@
+#include "PcapReplay.h"
+#include "Checksum.h"
+#include "Topology.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PcapReplay");
+
+// Hosts are keyed by IPv4 address with this bit set, or by MAC address
+static const uint64_t HOST_KEY_IPV4 = 1ull << 63;
+
+static uint64_t MacKey(const uint8_t* mac)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        key = key << 8 | mac[i];
+    }
+    return key;
+}
+
+static uint64_t Ipv4Key(const uint8_t* addr)
+{
+    return HOST_KEY_IPV4 | static_cast<uint64_t>(ReadNet16(addr)) << 16 | ReadNet16(addr + 2);
+}
+
+// Overwrite a 16 bit field of an IPv4 packet and patch up to two checksums covering it
+static void Rewrite16(uint8_t* l3, uint32_t offset, uint16_t value, int32_t csum1, int32_t csum2)
+{
+    uint16_t old = ReadNet16(l3 + offset);
+    WriteNet16(l3 + offset, value);
+    if (csum1 >= 0)
+    {
+        WriteNet16(l3 + csum1, ChecksumAdjust(ReadNet16(l3 + csum1), old, value));
+    }
+    if (csum2 >= 0)
+    {
+        WriteNet16(l3 + csum2, ChecksumAdjust(ReadNet16(l3 + csum2), old, value));
+    }
+}
+
+PcapReplay::PcapReplay()
+    : m_hasRec(false),
+      m_firstNs(0),
+      m_recOffset(0),
+      m_speedup(1.0),
+      m_records(0),
+      m_sent(0),
+      m_notEthernet(0),
+      m_sameEndpoint(0),
+      m_refused(0),
+      m_truncated(0),
+      m_lastNs(0),
+      m_leftBytes(0),
+      m_leftNs(0)
+{
+}
+
+bool PcapReplay::Open(const std::string& path, std::string& error, uint64_t windowBytes)
+{
+    m_path = path;
+    if (!m_map.Open(path, error, windowBytes))
+    {
+        return false;
+    }
+    // Records are copied here for rewriting, Ethernet frames fit without growing it
+    m_scratch.resize(65536);
+    return true;
+}
+
+void PcapReplay::SetSpeedup(double speedup)
+{
+    m_speedup = speedup > 0 ? speedup : 1.0;
+}
+
+void PcapReplay::AddEndpoint(Ptr<RawApp> app)
+{
+    Ptr<Node> node = app->GetNode();
+    m_endpoints.push_back(app);
+    m_macs.push_back(Mac48Address::ConvertFrom(Topology::GetEndpointDevice(node)->GetAddress()));
+    m_ips.push_back(Topology::GetEndpointAddress(node));
+}
+
+void PcapReplay::Start(Time start, Time stop)
+{
+    NS_ABORT_MSG_IF(m_endpoints.size() < 2, "Replay needs at least 2 endpoints");
+    m_start = start;
+    m_stop = stop;
+    m_hasRec = Read();
+    if (m_hasRec)
+    {
+        m_firstNs = m_rec.timeNs;
+        if (start >= stop)
+        {
+            m_leftBytes = m_map.GetFileSize() - m_recOffset;
+            m_leftNs = m_rec.timeNs;
+            m_map.Close();
+            return;
+        }
+        m_records++;
+        m_lastNs = m_rec.timeNs;
+        Simulator::Schedule(start, &PcapReplay::Step, this);
+    }
+}
+
+bool PcapReplay::Read()
+{
+    m_recOffset = m_map.GetOffset();
+    return m_map.Next(m_rec);
+}
+
+void PcapReplay::Step()
+{
+    while (m_hasRec)
+    {
+        Send();
+        m_hasRec = Read();
+        if (!m_hasRec)
+        {
+            break;
+        }
+        // Out of order timestamps are sent straight away
+        int64_t offsetNs = m_rec.timeNs > m_firstNs ? (m_rec.timeNs - m_firstNs) / m_speedup : 0;
+        Time due = m_start + NanoSeconds(offsetNs);
+        if (due >= m_stop)
+        {
+            // The sources are stopped by then, leave the rest of the capture unread
+            m_leftBytes = m_map.GetFileSize() - m_recOffset;
+            m_leftNs = m_rec.timeNs;
+            m_hasRec = false;
+            m_map.Close();
+            return;
+        }
+        m_records++;
+        m_lastNs = m_rec.timeNs;
+        if (due > Simulator::Now())
+        {
+            // The record stays mapped until the next read, so it can wait for its event
+            Simulator::Schedule(due - Simulator::Now(), &PcapReplay::Step, this);
+            return;
+        }
+    }
+}
+
+uint32_t PcapReplay::MapHost(uint64_t key)
+{
+    auto it = m_hosts.find(key);
+    if (it != m_hosts.end())
+    {
+        return it->second;
+    }
+    uint32_t endpoint = m_hosts.size() % m_endpoints.size();
+    m_hosts.emplace(key, endpoint);
+    return endpoint;
+}
+
+void PcapReplay::Send()
+{
+    if (m_rec.linkType != PCAP_LINKTYPE_ETHERNET || m_rec.capLen < 14)
+    {
+        m_notEthernet++;
+        return;
+    }
+    uint8_t* frame = m_scratch.data();
+    uint32_t len = std::min<uint32_t>(m_rec.capLen, m_scratch.size());
+    std::memcpy(frame, m_rec.data, len);
+    uint8_t* l3 = frame + 14;
+    uint32_t l3Len = len - 14;
+    uint16_t protocol = ReadNet16(frame + 12);
+    bool ipv4 = protocol == 0x0800 && l3Len >= 20 && (l3[0] >> 4) == 4 && (l3[0] & 0x0f) * 4u <= l3Len;
+    // Group and broadcast destinations stay as captured
+    bool group = frame[0] & 1;
+
+    uint32_t src = MapHost(ipv4 ? Ipv4Key(l3 + 12) : MacKey(frame + 6));
+    uint32_t dst = 0;
+    if (!group)
+    {
+        dst = MapHost(ipv4 ? Ipv4Key(l3 + 16) : MacKey(frame));
+        if (dst == src)
+        {
+            m_sameEndpoint++;
+            return;
+        }
+    }
+
+    if (ipv4)
+    {
+        // Checksums covering the addresses: the IPv4 header, and the UDP/TCP pseudo header
+        // when this is the first fragment and the checksum was captured
+        uint32_t ihl = (l3[0] & 0x0f) * 4;
+        bool firstFragment = (ReadNet16(l3 + 6) & 0x1fff) == 0;
+        int32_t l4csum = -1;
+        if (firstFragment && l3[9] == 17 && l3Len >= ihl + 8 && ReadNet16(l3 + ihl + 6) != 0)
+        {
+            l4csum = ihl + 6;
+        }
+        else if (firstFragment && l3[9] == 6 && l3Len >= ihl + 18)
+        {
+            l4csum = ihl + 16;
+        }
+        uint8_t addr[4];
+        m_ips[src].Serialize(addr);
+        Rewrite16(l3, 12, ReadNet16(addr), 10, l4csum);
+        Rewrite16(l3, 14, ReadNet16(addr + 2), 10, l4csum);
+        if (!group)
+        {
+            m_ips[dst].Serialize(addr);
+            Rewrite16(l3, 16, ReadNet16(addr), 10, l4csum);
+            Rewrite16(l3, 18, ReadNet16(addr + 2), 10, l4csum);
+        }
+    }
+
+    Ptr<Packet> pkt = Create<Packet>(l3, l3Len);
+    if (m_rec.origLen > len)
+    {
+        // Keep the wire size of truncated captures, the missing bytes become a zero area
+        m_truncated++;
+        pkt->AddPaddingAtEnd(m_rec.origLen - len);
+    }
+    Mac48Address dstMac;
+    dstMac.CopyFrom(frame);
+    if (m_endpoints[src]->SendReplayFrame(pkt, group ? dstMac : m_macs[dst], protocol))
+    {
+        m_sent++;
+    }
+    else
+    {
+        m_refused++;
+    }
+}
+
+void PcapReplay::Print(std::ostream& os) const
+{
+    os << std::fixed << std::setprecision(3);
+    os << "Replayed " << m_path << ": " << m_records << " records over " << (m_lastNs - m_firstNs) / 1e9
+       << "s of capture at speedup " << m_speedup << ", " << m_hosts.size() << " hosts on "
+       << m_endpoints.size() << " endpoints" << std::endl;
+    os << "    sent " << m_sent << ", refused " << m_refused << " (e.g. over the MTU), skipped " << m_notEthernet
+       << " non-Ethernet and " << m_sameEndpoint << " same-endpoint, padded " << m_truncated << " truncated" << std::endl;
+    if (m_leftBytes)
+    {
+        os << "    not replayed: the run ended before capture time " << (m_leftNs - m_firstNs) / 1e9 << "s, "
+           << m_leftBytes / 1048576.0 << " MB (" << 100.0 * m_leftBytes / m_map.GetFileSize()
+           << "%) of the capture left unread" << std::endl;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+uint64_t PcapReplay::GetSent() const
+{
+    return m_sent;
+}
+
+}
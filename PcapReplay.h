@@ -0,0 +1,78 @@
+#ifndef PCAP_REPLAY_H
+#define PCAP_REPLAY_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "PcapMap.h"
+#include "RawApp.h"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+// Replays an Ethernet capture through the simulated network with its recorded timing.
+// Each distinct captured host (IPv4 address, or MAC address for non-IP frames) is mapped
+// onto a simulated endpoint in order of first appearance, frames are rewritten to the
+// endpoints' MAC and IP addresses and sent by the source endpoint's replay RawApp.
+// The capture is walked once through a windowed memory map, one record at a time.
+class PcapReplay : public SimpleRefCount<PcapReplay> {
+    public:
+        PcapReplay();
+
+        // Open a pcap or pcapng file, mapping windowBytes at a time
+        bool Open(const std::string& path, std::string& error, uint64_t windowBytes);
+        // Replay speed relative to the capture, 2 halves all gaps
+        void SetSpeedup(double speedup);
+        // Replay source on an endpoint, set up with RawApp::SetupReplay and added to its node
+        void AddEndpoint(Ptr<RawApp> app);
+        // The first record is sent at start, later ones at their capture offset from it. Records
+        // due at stop or later are not read, the replay ends there.
+        void Start(Time start, Time stop);
+
+        // Records read, frames sent and frames skipped by reason
+        void Print(std::ostream& os) const;
+        uint64_t GetSent() const;
+
+    private:
+        // Send the current record and every record due by now, then wait for the next one
+        void Step();
+        // Read the next record, false at the end of the capture
+        bool Read();
+        // Rewrite the current record onto its endpoints and send it
+        void Send();
+        // Endpoint standing in for a captured host
+        uint32_t MapHost(uint64_t key);
+
+        PcapMap m_map;                  // Capture being replayed
+        std::string m_path;             // For the report
+        PcapRecord m_rec;               // Current record, valid until the next m_map.Next
+        bool m_hasRec;                  // m_rec is valid
+        uint64_t m_firstNs;             // Timestamp of the first record
+        Time m_start;                   // Simulation time of the first record
+        Time m_stop;                    // End of the run, nothing is sent from here
+        uint64_t m_recOffset;           // File offset of the current record
+        double m_speedup;               // Capture time / simulation time
+        std::vector<Ptr<RawApp>> m_endpoints;   // Replay sources by endpoint index
+        std::vector<Mac48Address> m_macs;       // Endpoint device MACs
+        std::vector<Ipv4Address> m_ips;         // Endpoint addresses
+        std::unordered_map<uint64_t, uint32_t> m_hosts;    // Captured host -> endpoint index
+        std::vector<uint8_t> m_scratch; // Reused rewrite buffer
+        uint64_t m_records;             // Records read
+        uint64_t m_sent;                // Frames accepted by a device
+        uint64_t m_notEthernet;         // Records from non-Ethernet interfaces
+        uint64_t m_sameEndpoint;        // Source and destination mapped to the same endpoint
+        uint64_t m_refused;             // Refused by the device, e.g. larger than the MTU
+        uint64_t m_truncated;           // Captured short of their wire length, padded with zeros
+        uint64_t m_lastNs;              // Timestamp of the last record read
+        uint64_t m_leftBytes;           // Capture bytes from the first record due after the run, 0 if all were due
+        uint64_t m_leftNs;              // Timestamp of that record
+};
+
+}
+
+#endif
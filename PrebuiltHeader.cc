@@ -0,0 +1,70 @@
+#include "PrebuiltHeader.h"
+
+#include "ns3/log.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("PrebuiltHeader");
+NS_OBJECT_ENSURE_REGISTERED(PrebuiltHeader);
+
+TypeId PrebuiltHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::PrebuiltHeader")
+                        .SetParent<Header>()
+                        .AddConstructor<PrebuiltHeader>()
+                        ;
+    return tid;
+}
+
+TypeId PrebuiltHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+PrebuiltHeader::PrebuiltHeader()
+{
+    m_size = 0;
+}
+
+void PrebuiltHeader::Set(const uint8_t* data, uint32_t size)
+{
+    NS_ASSERT_MSG(size <= MAX_SIZE, "Prebuilt header larger than " << MAX_SIZE << " bytes");
+    std::memcpy(m_bytes, data, size);
+    m_size = size;
+}
+
+uint8_t* PrebuiltHeader::Data()
+{
+    return m_bytes;
+}
+
+const uint8_t* PrebuiltHeader::Data() const
+{
+    return m_bytes;
+}
+
+uint32_t PrebuiltHeader::GetSerializedSize() const
+{
+    return m_size;
+}
+
+void PrebuiltHeader::Serialize(Buffer::Iterator start) const
+{
+    start.Write(m_bytes, m_size);
+}
+
+uint32_t PrebuiltHeader::Deserialize(Buffer::Iterator start)
+{
+    // Only meaningful after Set(), the size is not carried on the wire
+    start.Read(m_bytes, m_size);
+    return m_size;
+}
+
+void PrebuiltHeader::Print(std::ostream& os) const
+{
+    os << "prebuilt " << m_size << " bytes";
+}
+
+}
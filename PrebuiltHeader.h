@@ -0,0 +1,39 @@
+#ifndef PREBUILT_HEADER_H
+#define PREBUILT_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3
+{
+
+// Header holding already serialized bytes (e.g. an IPv4 + UDP header pair).
+// Built once per flow, stamped in place per packet and prepended to a shared
+// payload, so the send path never re-runs the per-field header serializers.
+class PrebuiltHeader : public Header {
+    public:
+        static const uint32_t MAX_SIZE = 64;
+
+        static TypeId GetTypeId(void);
+        TypeId GetInstanceTypeId(void) const override;
+
+        PrebuiltHeader();
+
+        // Replace the contents with size bytes copied from data
+        void Set(const uint8_t* data, uint32_t size);
+        // Writable view of the bytes, for per packet stamping
+        uint8_t* Data();
+        const uint8_t* Data() const;
+
+        uint32_t GetSerializedSize(void) const override;
+        void Serialize(Buffer::Iterator start) const override;
+        uint32_t Deserialize(Buffer::Iterator start) override;
+        void Print(std::ostream& os) const override;
+
+    private:
+        uint8_t m_bytes[MAX_SIZE];  // Serialized header bytes
+        uint32_t m_size;            // Number of valid bytes in m_bytes
+};
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PROBE_FORMAT_H
+#define PROBE_FORMAT_H
+
+#include <cstdint>
+
+// Wire format of the probe senders put at the start of each UDP payload, see ProbeHeader.
+// Kept free of ns-3 headers so offline tools can decode captures.
+//
+// Layout (network byte order, 20 bytes):
+//   magic (2) | kind (1) | reserved (1) | flow id (4) | sequence (4) | send time ns (8)
+
+namespace ns3
+{
+
+static const uint16_t PROBE_MAGIC = 0x5241;     // "RA"
+static const uint32_t PROBE_SIZE = 20;
+
+// Field offsets from the start of the probe
+static const uint32_t PROBE_KIND_OFFSET = 2;
+static const uint32_t PROBE_FLOW_OFFSET = 4;
+static const uint32_t PROBE_SEQ_OFFSET = 8;
+static const uint32_t PROBE_TX_OFFSET = 12;
+
+// What the frame carries, lets reflectors tell requests from their own replies
+enum ProbeKind : uint8_t
+{
+    PROBE_DATA = 0,
+    PROBE_ECHO_REQUEST = 1,
+    PROBE_ECHO_REPLY = 2,
+    PROBE_SEGMENT = 3,      // Followed by a SegmentInfo, part of a segmented message
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "ProbeHeader.h"
+
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ProbeHeader");
+NS_OBJECT_ENSURE_REGISTERED(ProbeHeader);
+
+TypeId ProbeHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::ProbeHeader")
+                        .SetParent<Header>()
+                        .AddConstructor<ProbeHeader>()
+                        ;
+    return tid;
+}
+
+TypeId ProbeHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+ProbeHeader::ProbeHeader()
+{
+    m_kind = DATA;
+    m_flowId = 0;
+    m_seq = 0;
+    m_txNs = 0;
+}
+
+void ProbeHeader::SetKind(uint8_t kind)
+{
+    m_kind = kind;
+}
+
+uint8_t ProbeHeader::GetKind() const
+{
+    return m_kind;
+}
+
+void ProbeHeader::SetFlowId(uint32_t flowId)
+{
+    m_flowId = flowId;
+}
+
+uint32_t ProbeHeader::GetFlowId() const
+{
+    return m_flowId;
+}
+
+void ProbeHeader::SetSeq(uint32_t seq)
+{
+    m_seq = seq;
+}
+
+uint32_t ProbeHeader::GetSeq() const
+{
+    return m_seq;
+}
+
+void ProbeHeader::SetTxTime(Time txTime)
+{
+    m_txNs = txTime.GetNanoSeconds();
+}
+
+Time ProbeHeader::GetTxTime() const
+{
+    return NanoSeconds(m_txNs);
+}
+
+void ProbeHeader::WriteTo(uint8_t* buf) const
+{
+    buf[0] = MAGIC >> 8;
+    buf[1] = MAGIC & 0xff;
+    buf[PROBE_KIND_OFFSET] = m_kind;
+    buf[PROBE_KIND_OFFSET + 1] = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        buf[PROBE_FLOW_OFFSET + i] = static_cast<uint8_t>(m_flowId >> (24 - 8 * i));
+        buf[PROBE_SEQ_OFFSET + i] = static_cast<uint8_t>(m_seq >> (24 - 8 * i));
+    }
+    uint64_t txNs = static_cast<uint64_t>(m_txNs);
+    for (int i = 0; i < 8; i++)
+    {
+        buf[PROBE_TX_OFFSET + i] = static_cast<uint8_t>(txNs >> (56 - 8 * i));
+    }
+}
+
+bool ProbeHeader::ReadFrom(const uint8_t* buf, uint32_t len)
+{
+    if (len < SIZE || ((buf[0] << 8) | buf[1]) != MAGIC)
+    {
+        return false;
+    }
+    m_kind = buf[PROBE_KIND_OFFSET];
+    m_flowId = 0;
+    m_seq = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        m_flowId = (m_flowId << 8) | buf[PROBE_FLOW_OFFSET + i];
+        m_seq = (m_seq << 8) | buf[PROBE_SEQ_OFFSET + i];
+    }
+    uint64_t txNs = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        txNs = (txNs << 8) | buf[PROBE_TX_OFFSET + i];
+    }
+    m_txNs = static_cast<int64_t>(txNs);
+    return true;
+}
+
+uint32_t ProbeHeader::GetSerializedSize() const
+{
+    return SIZE;
+}
+
+void ProbeHeader::Serialize(Buffer::Iterator start) const
+{
+    uint8_t buf[SIZE];
+    WriteTo(buf);
+    start.Write(buf, SIZE);
+}
+
+uint32_t ProbeHeader::Deserialize(Buffer::Iterator start)
+{
+    uint8_t buf[SIZE];
+    start.Read(buf, SIZE);
+    ReadFrom(buf, SIZE);
+    return SIZE;
+}
+
+void ProbeHeader::Print(std::ostream& os) const
+{
+    os << "flow=" << m_flowId << " seq=" << m_seq << " kind=" << +m_kind << " tx=" << m_txNs << "ns";
+}
+
+}
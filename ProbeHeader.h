@@ -0,0 +1,60 @@
+#ifndef PROBE_HEADER_H
+#define PROBE_HEADER_H
+
+#include "ns3/header.h"
+#include "ProbeFormat.h"
+
+namespace ns3
+{
+
+// Measurement header carried at the start of the UDP payload. Lets receivers attribute
+// a frame to its flow and compute loss, reordering and one-way delay without pcaps.
+// The wire layout is in ProbeFormat.h.
+class ProbeHeader : public Header {
+    public:
+        static const uint16_t MAGIC = PROBE_MAGIC;
+        static const uint32_t SIZE = PROBE_SIZE;
+
+        // Frame kinds, see ProbeKind
+        enum Kind : uint8_t
+        {
+            DATA = PROBE_DATA,
+            ECHO_REQUEST = PROBE_ECHO_REQUEST,
+            ECHO_REPLY = PROBE_ECHO_REPLY,
+            SEGMENT = PROBE_SEGMENT,
+        };
+
+        static TypeId GetTypeId(void);
+        TypeId GetInstanceTypeId(void) const override;
+
+        ProbeHeader();
+
+        void SetKind(uint8_t kind);
+        uint8_t GetKind() const;
+        void SetFlowId(uint32_t flowId);
+        uint32_t GetFlowId() const;
+        void SetSeq(uint32_t seq);
+        uint32_t GetSeq() const;
+        void SetTxTime(Time txTime);
+        Time GetTxTime() const;
+
+        // Raw byte access for paths that stamp prebuilt buffers instead of serializing headers
+        void WriteTo(uint8_t* buf) const;
+        // Returns false if buf does not start with a probe
+        bool ReadFrom(const uint8_t* buf, uint32_t len);
+
+        uint32_t GetSerializedSize(void) const override;
+        void Serialize(Buffer::Iterator start) const override;
+        uint32_t Deserialize(Buffer::Iterator start) override;
+        void Print(std::ostream& os) const override;
+
+    private:
+        uint8_t m_kind;         // Frame kind, see Kind
+        uint32_t m_flowId;      // Flow the frame belongs to
+        uint32_t m_seq;         // Per flow sequence number
+        int64_t m_txNs;         // Send time in ns of simulation time
+};
+
+}
+
+#endif
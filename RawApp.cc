@@ -1,4 +1,13 @@
 #include "RawApp.h"
+#include "Checksum.h"
+#include "EventLog.h"
+#include "FlowStats.h"
+#include "HopMonitor.h"
+#include "RawDemux.h"
+#include "Topology.h"
+
+#include <algorithm>
+#include <utility>
 
 namespace ns3 {
 
@@ -24,6 +33,21 @@ RawApp::RawApp()
     m_sent = 0;
     m_PSN = 0;
     m_byteTest = false;
+    m_fastPath = true;
+    m_burstSize = 1;
+    m_flowId = 0;
+    m_hasProbe = false;
+    m_echo = false;
+    m_port = 8080;
+    m_isSender = false;
+    m_replay = false;
+    m_gso = false;
+    m_mtu = 1500;
+    m_msgSent = 0;
+    m_reasmSlots = 16;
+    m_refused = 0;
+    m_msgRefused = 0;
+    m_notified = false;
 }
 
 // Destructor for RawApp, sets socket to nullptr
@@ -33,7 +57,7 @@ RawApp::~RawApp()
 }
 
 // Sets up all arguments for app
-void RawApp::Setup(uint32_t pktSize, uint32_t pktCount, Time interval, bool isSender, Ptr<Node> destNode, bool byteTest) 
+void RawApp::Setup(uint32_t pktSize, uint32_t pktCount, Time interval, bool isSender, Ptr<Node> destNode, bool byteTest, bool fastPath, uint32_t burstSize, Time burstGap) 
 {
     m_pktSize = pktSize;
     m_pktCount = pktCount;
@@ -41,6 +65,100 @@ void RawApp::Setup(uint32_t pktSize, uint32_t pktCount, Time interval, bool isSe
     m_isSender = isSender;
     m_destNode = destNode;
     m_byteTest = byteTest;
+    m_fastPath = fastPath;
+    m_burstSize = burstSize > 0 ? burstSize : 1;
+    // Without an explicit gap, bursts keep the average rate of one packet per interval
+    m_burstGap = burstGap.IsStrictlyPositive() ? burstGap : interval * m_burstSize;
+}
+
+void RawApp::SetupLoad(DataRate rate, ArrivalProcess process, int64_t stream)
+{
+    m_gen.Setup(rate, process, stream);
+}
+
+TrafficGen& RawApp::GetTrafficGen()
+{
+    return m_gen;
+}
+
+void RawApp::SetFlowId(uint32_t flowId)
+{
+    m_flowId = flowId;
+}
+
+void RawApp::SetEcho(bool echo)
+{
+    m_echo = echo;
+}
+
+void RawApp::SetPort(uint16_t port)
+{
+    m_port = port;
+}
+
+void RawApp::SetupSegmentation(uint32_t mtu, uint32_t reasmSlots)
+{
+    m_gso = true;
+    m_mtu = mtu;
+    m_reasmSlots = reasmSlots;
+}
+
+uint32_t RawApp::GetSent() const
+{
+    return m_sent - m_refused;
+}
+
+uint32_t RawApp::GetRefused() const
+{
+    return m_refused;
+}
+
+uint32_t RawApp::GetRefusedMessages() const
+{
+    return m_msgRefused;
+}
+
+void RawApp::SetupReplay()
+{
+    m_replay = true;
+}
+
+bool RawApp::SendReplayFrame(Ptr<Packet> pkt, Mac48Address dst, uint16_t protocol)
+{
+    if (!m_running || !m_device->SendFrom(pkt, m_srcMac, dst, protocol))
+    {
+        return false;
+    }
+    m_sent++;
+    return true;
+}
+
+void RawApp::SetFrame(Ptr<const FrameTemplate> frame)
+{
+    m_frame = frame;
+}
+
+void RawApp::SetDoneCallback(Callback<void, uint32_t> done)
+{
+    m_done = done;
+}
+
+// Apps can be retired before the end of the simulation, release the demux registration
+// and everything that refers back to the nodes
+void RawApp::DoDispose()
+{
+    // Disposal is not the end of the flow's sends, don't report it as done
+    m_done = MakeNullCallback<void, uint32_t>();
+    if (m_running)
+    {
+        StopApplication();
+    }
+    m_destNode = nullptr;
+    m_device = nullptr;
+    m_payload = nullptr;
+    m_lastPayload = nullptr;
+    m_frame = nullptr;
+    Application::DoDispose();
 }
 
 // Internally called method to start RawApp application
@@ -48,16 +166,77 @@ void RawApp::StartApplication()
 {
     m_running = true;
     
-    Ptr<NetDevice> device = GetNode()->GetDevice(1); // CSMA device resides at index 1 instead of 0, 0 occupied by Bridge Device (why?)
-   
-   
+    // Resolved by role, the device index depends on the order the topology installed devices in
+    m_device = Topology::GetEndpointDevice(GetNode());
 
+    if (m_replay)
+    {
+        // Replayed frames are absorbed by the demux at the far end, like frames of unknown flows
+        m_srcMac = Mac48Address::ConvertFrom(m_device->GetAddress());
+        RawDemux::Get(GetNode(), m_device);
+        return;
+    }
+
+    m_peerIp = Topology::GetEndpointAddress(m_destNode);
+    m_localIp = Topology::GetEndpointAddress(GetNode());
     if (!m_isSender)
     {
-        device->SetReceiveCallback(MakeCallback(&RawApp::ReceivePacket, this));
+        // Several receivers can share the device, the node's demux routes frames by (peer IP, port)
+        RawDemux::Get(GetNode(), m_device)->Register(m_peerIp, m_port, MakeCallback(&RawApp::ReceivePacket, this));
+        if (m_gso)
+        {
+            m_reasm.Setup(m_reasmSlots);
+        }
     }
     else
     {
+        if (m_byteTest)
+        {
+            NS_ABORT_MSG_IF(!m_frame, "byteTest sender without a frame");
+            // An all zero address in the frame stands for our own / the peer's device
+            Mac48Address none;
+            m_srcMac = m_frame->GetSource() == none ? Mac48Address::ConvertFrom(m_device->GetAddress()) : m_frame->GetSource();
+            m_dstMac = m_frame->GetDestination() == none
+                           ? Mac48Address::ConvertFrom(Topology::GetEndpointDevice(m_destNode)->GetAddress())
+                           : m_frame->GetDestination();
+            m_hdr = m_frame->GetHeader();
+        }
+        else if (m_fastPath || m_gso)
+        {
+            BuildTemplate();
+        }
+        else
+        {
+            m_srcMac = Mac48Address::ConvertFrom(m_device->GetAddress());
+            m_dstMac = Mac48Address::ConvertFrom(Topology::GetEndpointDevice(m_destNode)->GetAddress());
+        }
+        if (m_gen.IsEnabled())
+        {
+            // Offered load counts whole frames on the wire: payload, IP/UDP (28) and Ethernet header/trailer (18),
+            // the raw frame and the Ethernet trailer (4), or a message and the per segment headers
+            uint32_t bytes;
+            uint32_t frames = 1;
+            if (m_byteTest)
+            {
+                bytes = m_frame->GetFrameSize() + 4;
+            }
+            else if (m_gso)
+            {
+                bytes = m_pktSize + m_seg.count * (SEGMENT_OVERHEAD + 18);
+                frames = m_seg.count;
+            }
+            else
+            {
+                bytes = m_pktSize + 28 + 18;
+            }
+            m_gen.Start(m_burstSize * bytes, m_burstSize * frames);
+        }
+        if (m_echo)
+        {
+            // Replies come back from the peer with the ports swapped, i.e. to our source port
+            m_outstanding.assign(m_pktCount, false);
+            RawDemux::Get(GetNode(), m_device)->Register(m_peerIp, m_port, MakeCallback(&RawApp::ReceiveReply, this));
+        }
         RawApp::SendPacket();
     }
 }
@@ -74,89 +253,441 @@ void RawApp::StopApplication()
     {
         m_socket->Close();   
     }
+    if (m_device && !m_replay && (!m_isSender || m_echo))
+    {
+        RawDemux::Get(GetNode(), m_device)->Unregister(m_peerIp, m_port);
+    }
+    FlushReassembly();
+    // Stopped before all packets were sent
+    if (m_isSender)
+    {
+        NotifyDone();
+    }
 }
 
-void RawApp::SendPacket() 
+uint32_t RawApp::SegmentCount(uint32_t msgLen, uint32_t mtu)
 {
-    if (m_running && m_pktCount && m_sent < m_pktCount) 
-    {   
-        //LogComponentEnable("RawApp", LOG_LEVEL_DEBUG);
-        Ptr<Packet> pkt;
-        if (!m_byteTest) {
-            pkt = Create<Packet>(m_pktSize); 
-
-
-            Ipv4Header ipheader;
-            ipheader.SetSource(GetNode()->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal());
-            ipheader.SetDestination(m_destNode->GetObject<Ipv4>()->GetAddress(1,0).GetLocal());
-            ipheader.SetProtocol(17);
-            ipheader.SetPayloadSize(m_pktSize + 8);
-            ipheader.SetTtl(64);
-            ipheader.EnableChecksum();
-
-
-            // Must manually add UDP header, set both src and dest ports to 8080
-            UdpHeader udpheader;
-            udpheader.SetSourcePort(8080);
-            udpheader.SetDestinationPort(8080);
-            pkt->AddHeader(udpheader);
-            pkt->AddHeader(ipheader);
-
-            Ptr<NetDevice> device = GetNode()->GetDevice(1);
-            if (!device->SendFrom(pkt, Mac48Address::ConvertFrom(GetNode()->GetDevice(1)->GetAddress()), Mac48Address::ConvertFrom(m_destNode->GetDevice(1)->GetAddress()), 0x0800)) {
-                NS_LOG_UNCOND("Error in Sending");
-                return;
-            }
-        }
-        else 
+    uint32_t segPayload = mtu - SEGMENT_OVERHEAD;
+    return msgLen > 0 ? (msgLen + segPayload - 1) / segPayload : 1;
+}
+
+// Resolve everything that stays constant for the lifetime of the flow: MAC addresses
+// and the serialized IPv4/UDP headers. Only the IP identification changes per packet.
+// In segmentation mode the template describes a full size segment.
+void RawApp::BuildTemplate()
+{
+    uint32_t udpPayload = m_pktSize;
+    uint32_t segPayload = 0;
+    if (m_gso)
+    {
+        NS_ABORT_MSG_IF(m_mtu <= SEGMENT_OVERHEAD, "MTU " << m_mtu << " leaves no room for message data");
+        NS_ABORT_MSG_IF(m_pktSize > MAX_MESSAGE, "Message of " << m_pktSize << " bytes exceeds " << MAX_MESSAGE);
+        segPayload = m_mtu - SEGMENT_OVERHEAD;
+        m_seg.msgLen = m_pktSize;
+        m_seg.count = SegmentCount(m_pktSize, m_mtu);
+        NS_ABORT_MSG_IF(m_seg.count > SegmentInfo::MAX_SEGMENTS,
+                        "Message of " << m_pktSize << " bytes needs more than " << SegmentInfo::MAX_SEGMENTS << " segments at MTU " << m_mtu);
+        segPayload = std::min(segPayload, m_pktSize);
+        udpPayload = ProbeHeader::SIZE + SegmentInfo::SIZE + segPayload;
+    }
+
+    m_srcMac = Mac48Address::ConvertFrom(m_device->GetAddress());
+    m_dstMac = Mac48Address::ConvertFrom(Topology::GetEndpointDevice(m_destNode)->GetAddress());
+
+    Ipv4Header ipheader;
+    ipheader.SetSource(m_localIp);
+    ipheader.SetDestination(m_peerIp);
+    ipheader.SetProtocol(17);
+    ipheader.SetPayloadSize(udpPayload + 8);
+    ipheader.SetTtl(64);
+    ipheader.SetIdentification(0);
+    ipheader.EnableChecksum();
+
+    UdpHeader udpheader;
+    udpheader.SetSourcePort(m_port);
+    udpheader.SetDestinationPort(m_port);
+
+    Ptr<Packet> hdrPkt = Create<Packet>();
+    hdrPkt->AddHeader(udpheader);
+    hdrPkt->AddHeader(ipheader);
+
+    uint8_t bytes[PrebuiltHeader::MAX_SIZE];
+    uint32_t size = hdrPkt->CopyData(bytes, sizeof(bytes));
+    // The UDP header was serialized without its payload, fix up the length field (checksum is unused)
+    WriteNet16(bytes + 24, static_cast<uint16_t>(udpPayload + 8));
+
+    // The probe header becomes part of the template, only its sequence and timestamp change per packet
+    uint32_t payloadSize = udpPayload;
+    m_hasProbe = udpPayload >= ProbeHeader::SIZE;
+    if (m_hasProbe)
+    {
+        m_probe.SetFlowId(m_flowId);
+        m_probe.SetKind(m_gso ? ProbeHeader::SEGMENT : m_echo ? ProbeHeader::ECHO_REQUEST : ProbeHeader::DATA);
+        m_probe.WriteTo(bytes + size);
+        size += ProbeHeader::SIZE;
+        payloadSize -= ProbeHeader::SIZE;
+    }
+    if (m_gso)
+    {
+        // Followed by the segment header, stamped per frame after the probe
+        size += SegmentInfo::SIZE;
+        payloadSize = segPayload;
+    }
+    m_hdr.Set(bytes, size);
+
+    // Zero filled payloads are kept as a virtual zero area by ns-3, copies share it
+    m_payload = Create<Packet>(payloadSize);
+    if (m_gso)
+    {
+        m_lastPayload = Create<Packet>(m_pktSize - (m_seg.count - 1) * segPayload);
+    }
+}
+
+bool RawApp::SendTemplateFrame()
+{
+    // Stamp the IP identification and patch the header checksum incrementally
+    PatchNet16(m_hdr.Data(), 4, static_cast<uint16_t>(m_sent), 10);
+    if (m_hasProbe)
+    {
+        m_probe.SetSeq(m_sent);
+        m_probe.SetTxTime(Simulator::Now());
+        m_probe.WriteTo(m_hdr.Data() + 28);
+    }
+
+    Ptr<Packet> pkt = m_payload->Copy();
+    pkt->AddHeader(m_hdr);
+    HopMonitor::Get().Tag(pkt, m_flowId, m_sent);
+    return m_device->SendFrom(pkt, m_srcMac, m_dstMac, 0x0800);
+}
+
+// One frame of the current message. Only the last segment can be short, its lengths are
+// patched in before it is sent and restored by the first segment of the next message.
+bool RawApp::SendSegment(uint16_t index)
+{
+    Ptr<Packet> payload = index + 1 == m_seg.count ? m_lastPayload : m_payload;
+    uint8_t* bytes = m_hdr.Data();
+    uint16_t udpLength = static_cast<uint16_t>(8 + ProbeHeader::SIZE + SegmentInfo::SIZE + payload->GetSize());
+    if (ReadNet16(bytes + 24) != udpLength)
+    {
+        PatchNet16(bytes, 2, static_cast<uint16_t>(udpLength + 20), 10);
+        WriteNet16(bytes + 24, udpLength);
+    }
+    PatchNet16(bytes, 4, static_cast<uint16_t>(m_sent), 10);
+    m_probe.SetSeq(m_sent);
+    m_probe.SetTxTime(Simulator::Now());
+    m_probe.WriteTo(bytes + 28);
+    m_seg.index = index;
+    m_seg.WriteTo(bytes + 28 + ProbeHeader::SIZE);
+
+    Ptr<Packet> pkt = payload->Copy();
+    pkt->AddHeader(m_hdr);
+    HopMonitor::Get().Tag(pkt, m_flowId, m_sent);
+    uint32_t size = pkt->GetSize();
+    bool sent = m_device->SendFrom(pkt, m_srcMac, m_dstMac, 0x0800);
+    // A refused segment uses up its sequence number like a refused frame
+    EventLog::Get().Record(sent ? EVENT_TX : EVENT_TX_FAIL, GetNode()->GetId(), m_flowId, m_sent, size);
+    if (!sent)
+    {
+        m_refused++;
+    }
+    m_sent++;
+    return sent;
+}
+
+// Segments go to the device back to back, like a GSO super-packet split below the stack.
+// Once the device refuses a segment the message can not be reassembled, the rest of it
+// is not sent and the flow goes on with the next message.
+bool RawApp::SendMessage()
+{
+    m_seg.msgSeq = m_msgSent++;
+    for (uint16_t i = 0; i < m_seg.count; i++)
+    {
+        if (!SendSegment(i))
         {
-            uint8_t pktBytes[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x08, 0x00, 0x45, 0x00, 0x00, 0x4E, 0x00, 0x00, 0x00, 0x00, 0x40, 0x11, 0x66, \
-                0x9C, 0x0A, 0x00, 0x00, 0x01, 0x0A, 0x00, 0x00, 0x03, 0x1F, 0x90, 0x1F, 0x90, 0x00, 0x3A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, \
-                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-            uint8_t srcBytes[6];
-            uint8_t destBytes[6];
-            uint16_t protocol = (uint16_t)((pktBytes[12] << 8) | pktBytes[13]);
-            for (int i = 0; i < 6; i++) {
-                srcBytes[i] = pktBytes[i];
-                destBytes[i] = pktBytes[i + 6];
-            }
-            Mac48Address srcAddr;
-            srcAddr.CopyFrom(srcBytes);
-            Mac48Address destAddr;
-            destAddr.CopyFrom(destBytes);
-
-            pkt = Create<Packet>(pktBytes, 92);
-            pkt = pkt->CreateFragment(14, 78);
-
-            Ptr<NetDevice> device = GetNode()->GetDevice(1);
-            if (!device->SendFrom(pkt, srcAddr, destAddr, protocol)) {
-                NS_LOG_UNCOND("Error in Sending");
-                return;
-            }
+            m_msgRefused++;
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t RawApp::GetProgress() const
+{
+    return m_gso ? m_msgSent : m_sent;
+}
+
+// Original send path, rebuilds all headers on every packet. Kept for comparison against
+// the template path, addresses are resolved once at start for both.
+bool RawApp::SendLegacyFrame()
+{
+    Ptr<Packet> pkt;
+    if (m_pktSize >= ProbeHeader::SIZE)
+    {
+        pkt = Create<Packet>(m_pktSize - ProbeHeader::SIZE);
+        ProbeHeader probe;
+        probe.SetFlowId(m_flowId);
+        probe.SetKind(m_echo ? ProbeHeader::ECHO_REQUEST : ProbeHeader::DATA);
+        probe.SetSeq(m_sent);
+        probe.SetTxTime(Simulator::Now());
+        pkt->AddHeader(probe);
+    }
+    else
+    {
+        pkt = Create<Packet>(m_pktSize);
+    }
+
+    Ipv4Header ipheader;
+    ipheader.SetSource(m_localIp);
+    ipheader.SetDestination(m_peerIp);
+    ipheader.SetProtocol(17);
+    ipheader.SetPayloadSize(m_pktSize + 8);
+    ipheader.SetTtl(64);
+    ipheader.EnableChecksum();
+
+
+    // Must manually add UDP header, both src and dest ports are the flow's port
+    UdpHeader udpheader;
+    udpheader.SetSourcePort(m_port);
+    udpheader.SetDestinationPort(m_port);
+    pkt->AddHeader(udpheader);
+    pkt->AddHeader(ipheader);
+
+    HopMonitor::Get().Tag(pkt, m_flowId, m_sent);
+    return m_device->SendFrom(pkt, m_srcMac, m_dstMac, 0x0800);
+}
+
+// Raw frame path: stamp the declared fields into our copy of the frame prefix and prepend
+// it to the frame's shared payload
+bool RawApp::SendByteFrame()
+{
+    m_frame->Stamp(m_hdr.Data(), m_sent);
+    Ptr<Packet> pkt = m_frame->GetPayload()->Copy();
+    if (m_hdr.GetSerializedSize())
+    {
+        pkt->AddHeader(m_hdr);
+    }
+    HopMonitor::Get().Tag(pkt, m_flowId, m_sent);
+    return m_device->SendFrom(pkt, m_srcMac, m_dstMac, m_frame->GetProtocol());
+}
 
+// Hand a single frame to the device using the configured send path
+bool RawApp::SendFrame()
+{
+    if (m_gso)
+    {
+        // Segments count themselves in m_sent and m_refused, pktCount counts messages
+        if (!SendMessage())
+        {
+            return false;
         }
+        EventLog::Get().Record(EVENT_MSG_TX, GetNode()->GetId(), m_flowId, m_msgSent - 1, m_pktSize);
+        return true;
+    }
 
-        NS_LOG_UNCOND("Node " << GetNode()->GetId() << " sent Packet " << m_sent << " at time " << Simulator::Now().GetSeconds() << "s");
+    bool sent;
+    if (m_byteTest)
+    {
+        sent = SendByteFrame();
+    }
+    else if (m_fastPath)
+    {
+        sent = SendTemplateFrame();
+    }
+    else
+    {
+        sent = SendLegacyFrame();
+    }
 
+    // IP packet, or raw frame without its Ethernet header
+    uint32_t size = m_byteTest ? m_frame->GetFrameSize() - 14 : m_pktSize + 28;
+    if (!sent) {
+        // Dropped on enqueue, the sequence number is used up so the frame counts as lost
+        EventLog::Get().Record(EVENT_TX_FAIL, GetNode()->GetId(), m_flowId, m_sent, size);
+        m_refused++;
         m_sent++;
+        return false;
+    }
+
+    EventLog::Get().Record(EVENT_TX, GetNode()->GetId(), m_flowId, m_sent, size);
+
+    if (m_echo)
+    {
+        m_outstanding[m_sent] = true;
+    }
+    m_sent++;
+    return true;
+}
+
+void RawApp::SendPacket() 
+{
+    if (m_running && m_pktCount && GetProgress() < m_pktCount) 
+    {   
+        //LogComponentEnable("RawApp", LOG_LEVEL_DEBUG);
+        // Enqueue up to a burst worth of frames back to back, the device transmit queue
+        // paces them out at line rate so only one simulator event is needed per burst.
+        // A full queue refuses the frame, it is counted as dropped and the flow carries on.
+        for (uint32_t i = 0; i < m_burstSize && GetProgress() < m_pktCount; i++)
+        {
+            SendFrame();
+        }
         
         // Schedule the next event where this function must be called
         // Do it as long as the number of sent packets is less than the count to be sent
-        if (m_sent < m_pktCount)
+        if (GetProgress() < m_pktCount)
         {
-            m_sendEvent = Simulator::Schedule(m_interval, &RawApp::SendPacket, this);
+            Time gap;
+            if (m_gen.IsEnabled())
+            {
+                gap = m_gen.Next();
+            }
+            else
+            {
+                gap = m_burstSize > 1 ? m_burstGap : m_interval;
+            }
+            m_sendEvent = Simulator::Schedule(gap, &RawApp::SendPacket, this);
         }
+        else
+        {
+            NotifyDone();
+        }
+    }
+}
+
+void RawApp::NotifyDone()
+{
+    if (!m_notified && !m_done.IsNull())
+    {
+        m_notified = true;
+        m_done(m_flowId);
     }
 }
 
+bool RawApp::ParseProbe(Ptr<const Packet> pkt, uint16_t protocol, ProbeHeader& probe, uint32_t& payloadBytes, SegmentInfo* seg)
+{
+    if (protocol != 0x0800)
+    {
+        return false;
+    }
+    // Only the leading bytes are needed, copy them to the stack instead of removing headers
+    uint8_t buf[64];
+    uint32_t len = pkt->CopyData(buf, sizeof(buf));
+    if (len < 28 || buf[9] != 17)
+    {
+        return false;
+    }
+    uint32_t udpEnd = (buf[0] & 0x0f) * 4 + 8;
+    if (len < udpEnd || !probe.ReadFrom(buf + udpEnd, len - udpEnd))
+    {
+        return false;
+    }
+    payloadBytes = pkt->GetSize() - udpEnd;
+    if (seg && probe.GetKind() == ProbeHeader::SEGMENT)
+    {
+        uint32_t segStart = udpEnd + ProbeHeader::SIZE;
+        return len >= segStart && seg->ReadFrom(buf + segStart, len - segStart);
+    }
+    return true;
+}
+
 bool RawApp::ReceivePacket(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender)
 {
-   
-    NS_LOG_UNCOND("Node " << GetNode()->GetId() << " received packet " << m_PSN << " of size " << pkt->GetSize() << " at time " << Simulator::Now().GetSeconds() << "s");
-    m_PSN++; // Only local to one channel, need to implement global packet counting 
+    ProbeHeader probe;
+    uint32_t payloadBytes;
+    SegmentInfo seg;
+    bool hasProbe = ParseProbe(pkt, protocol, probe, payloadBytes, &seg);
+    // Frames without a probe are numbered by arrival, only local to one channel
+    EventLog::Get().Record(EVENT_RX, GetNode()->GetId(), hasProbe ? probe.GetFlowId() : UINT32_MAX,
+                           hasProbe ? probe.GetSeq() : m_PSN, pkt->GetSize());
+    m_PSN++;
+
+    if (hasProbe)
+    {
+        FlowStats::Get().RecordRx(probe.GetFlowId(), probe.GetSeq(), probe.GetTxTime(), payloadBytes);
+        if (probe.GetKind() == ProbeHeader::SEGMENT && m_reasm.IsSetup())
+        {
+            int64_t msgTxNs;
+            uint32_t evicted;
+            Reassembler::Result result = m_reasm.Add(seg, probe.GetTxTime().GetNanoSeconds(), msgTxNs, evicted);
+            if (evicted)
+            {
+                FlowStats::Get().RecordIncompleteMessages(probe.GetFlowId(), evicted);
+            }
+            if (result == Reassembler::COMPLETE)
+            {
+                FlowStats::Get().RecordMessage(probe.GetFlowId(), NanoSeconds(msgTxNs), seg.msgLen);
+                EventLog::Get().Record(EVENT_MSG_RX, GetNode()->GetId(), probe.GetFlowId(), seg.msgSeq, seg.msgLen);
+            }
+        }
+        if (m_echo && probe.GetKind() == ProbeHeader::ECHO_REQUEST)
+        {
+            Reflect(device, pkt, protocol, sender, probe);
+        }
+    }
     return true;
     
 }
+
+void RawApp::Reflect(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender, ProbeHeader& probe)
+{
+    // Only the headers are rewritten, on a stack copy. The payload is shared with the request.
+    uint8_t buf[PrebuiltHeader::MAX_SIZE];
+    uint32_t len = pkt->CopyData(buf, sizeof(buf));
+    uint32_t udpStart = (buf[0] & 0x0f) * 4;
+    uint32_t hdrLen = udpStart + 8 + ProbeHeader::SIZE;
+    if (len < hdrLen)
+    {
+        return;
+    }
+
+    // Swap IP addresses (the header checksum is order independent) and UDP ports
+    for (int i = 0; i < 4; i++)
+    {
+        std::swap(buf[12 + i], buf[16 + i]);
+    }
+    std::swap(buf[udpStart], buf[udpStart + 2]);
+    std::swap(buf[udpStart + 1], buf[udpStart + 3]);
+    probe.SetKind(ProbeHeader::ECHO_REPLY);
+    probe.WriteTo(buf + udpStart + 8);
+
+    PrebuiltHeader hdr;
+    hdr.Set(buf, hdrLen);
+    Ptr<Packet> reply = pkt->CreateFragment(hdrLen, pkt->GetSize() - hdrLen);
+    reply->AddHeader(hdr);
+    // The reply inherited the request's tag, its hops are timed from now
+    HopMonitor::Get().Tag(reply, probe.GetFlowId(), probe.GetSeq());
+
+    // The MACs swap too: reply from our own address to whoever sent the request
+    if (!device->SendFrom(reply, device->GetAddress(), sender, protocol))
+    {
+        EventLog::Get().Record(EVENT_TX_FAIL, GetNode()->GetId(), probe.GetFlowId(), probe.GetSeq(), pkt->GetSize());
+    }
+}
+
+void RawApp::FlushReassembly()
+{
+    uint32_t incomplete = m_reasm.Flush();
+    if (incomplete)
+    {
+        FlowStats::Get().RecordIncompleteMessages(m_flowId, incomplete);
+    }
+}
+
+bool RawApp::ReceiveReply(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender)
+{
+    ProbeHeader probe;
+    uint32_t payloadBytes;
+    if (!ParseProbe(pkt, protocol, probe, payloadBytes) || probe.GetKind() != ProbeHeader::ECHO_REPLY || probe.GetFlowId() != m_flowId)
+    {
+        return true;
+    }
+
+    // Only the first reply to an outstanding request counts
+    uint32_t seq = probe.GetSeq();
+    if (seq < m_outstanding.size() && m_outstanding[seq])
+    {
+        m_outstanding[seq] = false;
+        FlowStats::Get().RecordRtt(m_flowId, Simulator::Now() - probe.GetTxTime());
+    }
+    return true;
+}
 }
\ No newline at end of file
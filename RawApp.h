@@ -5,34 +5,116 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/application.h"
+#include "PrebuiltHeader.h"
+#include "TrafficGen.h"
+#include "ProbeHeader.h"
+#include "FrameTemplate.h"
+#include "Reassembly.h"
 
 namespace ns3 
 {
 
 class RawApp : public Application {
     public:
+        // Largest message accepted in segmentation mode
+        static const uint32_t MAX_MESSAGE = 65536;
+        // Per frame bytes in front of a message segment: IPv4, UDP, probe and segment headers
+        static const uint32_t SEGMENT_OVERHEAD = 28 + ProbeHeader::SIZE + SegmentInfo::SIZE;
+
         static TypeId GetTypeId(void);
 
         RawApp();
         ~RawApp() override;
 
         // Setup necessary parameters for UDP packet transmission over a raw socket
-        void Setup(uint32_t pktSize, uint32_t pktCount, Time interval, bool isSender, Ptr<Node> destNode, bool byteTest);
+        // fastPath selects the prebuilt header template send path over rebuilding headers per packet
+        // burstSize frames are enqueued back to back per send event, bursts are burstGap apart
+        void Setup(uint32_t pktSize, uint32_t pktCount, Time interval, bool isSender, Ptr<Node> destNode, bool byteTest,
+                   bool fastPath = true, uint32_t burstSize = 1, Time burstGap = Seconds(0));
+
+        // Replace the fixed interval with a target offered load and arrival process,
+        // gaps are drawn from random stream index stream
+        void SetupLoad(DataRate rate, ArrivalProcess process, int64_t stream);
+        // Expose the generator for process specific parameters (on/off periods, bucket depth)
+        TrafficGen& GetTrafficGen();
+
+        // Flow id stamped into the probe header by senders, must match on both ends
+        void SetFlowId(uint32_t flowId);
+
+        // Echo mode: senders send requests and match replies for RTT, receivers reflect requests at L2
+        void SetEcho(bool echo);
+
+        // UDP port used as both source and destination port, identifies the flow at the receiving node
+        void SetPort(uint16_t port);
+
+        // Segmentation mode: pktSize is a message of up to MAX_MESSAGE bytes that the sender splits
+        // into frames of at most mtu bytes sharing one header template. Receivers reassemble into
+        // reasmSlots preallocated slots and report message latency and goodput.
+        void SetupSegmentation(uint32_t mtu, uint32_t reasmSlots);
+        // Frames a message of msgLen bytes is split into at this MTU, at most SegmentInfo::MAX_SEGMENTS
+        // are allowed. The MTU must be above SEGMENT_OVERHEAD.
+        static uint32_t SegmentCount(uint32_t msgLen, uint32_t mtu);
+
+        // Number of frames handed to the device so far
+        uint32_t GetSent() const;
+        // Number of frames the device refused because its queue was full, counted as dropped
+        uint32_t GetRefused() const;
+        // Segmentation mode: messages given up on because the device refused one of their segments
+        uint32_t GetRefusedMessages() const;
+
+        // Replay source mode: the app sends whatever frames a PcapReplay hands it instead of its own flow
+        void SetupReplay();
+        // Send a replayed frame from this endpoint's device, false if refused or not running
+        bool SendReplayFrame(Ptr<Packet> pkt, Mac48Address dst, uint16_t protocol);
+
+        // Frame sent by byteTest senders, shared between flows
+        void SetFrame(Ptr<const FrameTemplate> frame);
+
+        // Called with the flow id once a sender has stopped sending, i.e. tried to send all packets or was stopped
+        void SetDoneCallback(Callback<void, uint32_t> done);
 
         
+    protected:
+        void DoDispose() override;
+
     private:
         void StartApplication() override;
         void StopApplication() override;
 
         // Method used by sending application
         void SendPacket();
+        // Report the end of sending to the done callback
+        void NotifyDone();
+        // Send one frame and count it, false if the device refused it
+        bool SendFrame();
+        // Per frame send paths, return false if the device refused the frame
+        bool SendTemplateFrame();
+        bool SendLegacyFrame();
+        bool SendByteFrame();
+        // Segmentation mode: send every frame of the next message, or a single frame of it
+        bool SendMessage();
+        bool SendSegment(uint16_t index);
+        // What pktCount counts: messages in segmentation mode, frames otherwise
+        uint32_t GetProgress() const;
+        // Resolve device, MACs and serialized IP/UDP headers once per run
+        void BuildTemplate();
         // Receiver method
         bool ReceivePacket(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender);
+        // Sender side handler for echo replies
+        bool ReceiveReply(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender);
+        // Send a request straight back to where it came from with addresses and ports swapped
+        void Reflect(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender, ProbeHeader& probe);
+        // Locate the probe header of an IPv4/UDP frame, payloadBytes is the UDP payload size.
+        // The segment header following a SEGMENT probe is read into seg when given.
+        static bool ParseProbe(Ptr<const Packet> pkt, uint16_t protocol, ProbeHeader& probe, uint32_t& payloadBytes,
+                               SegmentInfo* seg = nullptr);
+        // Count the messages still waiting for segments as incomplete
+        void FlushReassembly();
 
         Ptr<Socket> m_socket;   // Socket for RawUDPApp
         uint32_t m_pktSize;     // Size of each packet to be sent
         uint32_t m_pktCount;    // Count of packets to be sent
-        uint32_t m_sent;        // Count of packets already sent
+        uint32_t m_sent;        // Sequence numbers used so far, refused frames included
         Time m_interval;        // Interval between packet sends
         bool m_running;         // Running status variable
         EventId m_sendEvent;    // Send Event
@@ -40,6 +122,36 @@ class RawApp : public Application {
         Ptr<Node> m_destNode;   // Destination node for MAC Address
         int m_PSN;              // Packet tracking num
         bool m_byteTest;
+        bool m_fastPath;        // Send using the prebuilt header template
+        uint32_t m_burstSize;   // Frames enqueued per send event
+        Time m_burstGap;        // Time between the starts of consecutive bursts
+        TrafficGen m_gen;       // Rate based gap generator, used instead of the interval when enabled
+        Ptr<NetDevice> m_device;    // CSMA device used to send and receive
+        Mac48Address m_srcMac;      // Own MAC, resolved at start
+        Mac48Address m_dstMac;      // Destination MAC, resolved at start
+        PrebuiltHeader m_hdr;       // Serialized IPv4 + UDP header, stamped per packet
+        Ptr<Packet> m_payload;      // Zero filled payload shared (copy-on-write) by all sends
+        uint32_t m_flowId;          // Flow id carried in the probe header
+        bool m_hasProbe;            // Packets are large enough to carry a probe header
+        ProbeHeader m_probe;        // Probe stamped into each packet
+        bool m_echo;                // Request/reply mode instead of one-way streaming
+        uint16_t m_port;            // UDP source and destination port of the flow
+        Ipv4Address m_peerIp;       // IP of the destination node (senders) or the sending node (receivers)
+        Ipv4Address m_localIp;      // IP of this node
+        std::vector<bool> m_outstanding;    // Echo requests sent but not yet answered, by sequence number
+        Callback<void, uint32_t> m_done;    // Invoked when the sender stops sending
+        bool m_replay;                      // Replay source, sends only through SendReplayFrame
+        Ptr<const FrameTemplate> m_frame;   // Raw frame for byteTest, m_hdr holds our copy of its prefix
+        bool m_gso;                 // Segmentation mode, pktSize and pktCount describe messages
+        uint32_t m_mtu;             // Largest IP packet sent in segmentation mode
+        uint32_t m_msgSent;         // Messages started, the next message number
+        SegmentInfo m_seg;          // Segment header stamped into each frame of the current message
+        Ptr<Packet> m_lastPayload;  // Payload of the last, possibly short, segment (m_payload holds full ones)
+        uint32_t m_reasmSlots;      // Reassembly slots allocated by receivers
+        Reassembler m_reasm;        // Receiver side message reassembly
+        uint32_t m_refused;         // Frames refused by the device, they still used up a sequence number
+        uint32_t m_msgRefused;      // Messages cut short by a refused segment
+        bool m_notified;            // Done callback already called
 };
 
 }
@@ -0,0 +1,197 @@
+#include "RawDemux.h"
+#include "RxCoalescing.h"
+
+#include <cstdint>
+#include <string>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("RawDemux");
+NS_OBJECT_ENSURE_REGISTERED(RawDemux);
+
+TypeId RawDemux::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::RawDemux")
+                        .SetParent<Object>()
+                        .AddConstructor<RawDemux>()
+                        ;
+    return tid;
+}
+
+RawDemux::RawDemux()
+{
+    m_slots.assign(64, Slot{EMPTY, 0});
+    m_used = 0;
+    m_unmatched = 0;
+    m_ring = NO_RING;
+}
+
+RawDemux::~RawDemux()
+{
+}
+
+void RawDemux::DoDispose()
+{
+    if (m_ring != NO_RING)
+    {
+        RxCoalescing::Get().Detach(m_ring);
+        m_ring = NO_RING;
+    }
+    m_callbacks.clear();
+    m_slots.clear();
+    Object::DoDispose();
+}
+
+Ptr<RawDemux> RawDemux::Get(Ptr<Node> node, Ptr<NetDevice> device)
+{
+    Ptr<RawDemux> demux = node->GetObject<RawDemux>();
+    if (!demux)
+    {
+        demux = CreateObject<RawDemux>();
+        node->AggregateObject(demux);
+        if (RxCoalescing::Get().IsEnabled())
+        {
+            // The ring must not keep the demux alive, it is detached when the demux is disposed
+            demux->m_ring = RxCoalescing::Get().Attach("n" + std::to_string(node->GetId()),
+                                                       MakeCallback(&RawDemux::Dispatch, PeekPointer(demux)));
+        }
+        device->SetReceiveCallback(MakeCallback(&RawDemux::Receive, demux));
+    }
+    return demux;
+}
+
+uint64_t RawDemux::MakeKey(uint32_t src, uint16_t port)
+{
+    return (static_cast<uint64_t>(src) << 16) | port;
+}
+
+// Linear probing from a Fibonacci hash of the key
+uint32_t RawDemux::FindSlot(uint64_t key) const
+{
+    uint32_t mask = m_slots.size() - 1;
+    uint32_t i = static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    uint32_t firstFree = UINT32_MAX;
+    while (m_slots[i].key != EMPTY)
+    {
+        if (m_slots[i].key == key)
+        {
+            return i;
+        }
+        if (m_slots[i].key == TOMBSTONE && firstFree == UINT32_MAX)
+        {
+            firstFree = i;
+        }
+        i = (i + 1) & mask;
+    }
+    return firstFree != UINT32_MAX ? firstFree : i;
+}
+
+// Drop the tombstones. The table only doubles when the live keys need the room, with
+// flows coming and going the slots are mostly tombstones and the size stays put.
+void RawDemux::Rehash()
+{
+    uint32_t live = m_callbacks.size() - m_freeCallbacks.size();
+    std::vector<Slot> old;
+    old.swap(m_slots);
+    m_slots.assign((live + 1) * 4 > old.size() ? old.size() * 2 : old.size(), Slot{EMPTY, 0});
+    m_used = 0;
+    for (const Slot& slot : old)
+    {
+        if (slot.key != EMPTY && slot.key != TOMBSTONE)
+        {
+            m_slots[FindSlot(slot.key)] = slot;
+            m_used++;
+        }
+    }
+}
+
+void RawDemux::Register(Ipv4Address src, uint16_t dstPort, RxCallback cb)
+{
+    if ((m_used + 1) * 2 > m_slots.size())
+    {
+        Rehash();
+    }
+
+    uint64_t key = MakeKey(src.Get(), dstPort);
+    uint32_t i = FindSlot(key);
+    if (m_slots[i].key == key)
+    {
+        m_callbacks[m_slots[i].index] = cb;
+        return;
+    }
+
+    uint32_t index;
+    if (!m_freeCallbacks.empty())
+    {
+        index = m_freeCallbacks.back();
+        m_freeCallbacks.pop_back();
+        m_callbacks[index] = cb;
+    }
+    else
+    {
+        index = m_callbacks.size();
+        m_callbacks.push_back(cb);
+    }
+    if (m_slots[i].key == EMPTY)
+    {
+        m_used++;
+    }
+    m_slots[i] = Slot{key, index};
+}
+
+void RawDemux::Unregister(Ipv4Address src, uint16_t dstPort)
+{
+    if (m_slots.empty())
+    {
+        return;
+    }
+    uint64_t key = MakeKey(src.Get(), dstPort);
+    uint32_t i = FindSlot(key);
+    if (m_slots[i].key == key)
+    {
+        m_callbacks[m_slots[i].index] = RxCallback();
+        m_freeCallbacks.push_back(m_slots[i].index);
+        m_slots[i].key = TOMBSTONE;
+    }
+}
+
+uint64_t RawDemux::GetUnmatched() const
+{
+    return m_unmatched;
+}
+
+bool RawDemux::Receive(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender)
+{
+    if (m_ring != NO_RING)
+    {
+        RxCoalescing::Get().Enqueue(m_ring, device, pkt, protocol, sender);
+        return true;
+    }
+    return Dispatch(device, pkt, protocol, sender);
+}
+
+bool RawDemux::Dispatch(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender)
+{
+    if (protocol == 0x0800)
+    {
+        // Enough for an IPv4 header with options plus the UDP ports
+        uint8_t buf[64];
+        uint32_t len = pkt->CopyData(buf, sizeof(buf));
+        uint32_t udpStart = len >= 20 ? (buf[0] & 0x0f) * 4 : 0;
+        if (len >= 20 && len >= udpStart + 4 && buf[9] == 17)
+        {
+            uint32_t src = (static_cast<uint32_t>(buf[12]) << 24) | (buf[13] << 16) | (buf[14] << 8) | buf[15];
+            uint16_t dstPort = static_cast<uint16_t>((buf[udpStart + 2] << 8) | buf[udpStart + 3]);
+            uint64_t key = MakeKey(src, dstPort);
+            uint32_t i = FindSlot(key);
+            if (m_slots[i].key == key)
+            {
+                return m_callbacks[m_slots[i].index](device, pkt, protocol, sender);
+            }
+        }
+    }
+    m_unmatched++;
+    return true;
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef RAW_DEMUX_H
+#define RAW_DEMUX_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+// Node level dispatcher for raw frames. A NetDevice only holds one receive callback,
+// so the demux installs itself once and routes IPv4/UDP frames to the flow registered
+// for their (source IP, destination port). Lookup is a flat open addressing table,
+// constant time and allocation free per frame. With receive coalescing enabled, frames
+// wait in the device's RxCoalescing ring and are dispatched in batches.
+class RawDemux : public Object {
+    public:
+        typedef Callback<bool, Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address&> RxCallback;
+
+        static TypeId GetTypeId(void);
+
+        RawDemux();
+        ~RawDemux() override;
+
+        // Demux aggregated to node, created and attached to device on first use
+        static Ptr<RawDemux> Get(Ptr<Node> node, Ptr<NetDevice> device);
+
+        // Route frames from src addressed to UDP port dstPort to cb, replaces any earlier registration
+        void Register(Ipv4Address src, uint16_t dstPort, RxCallback cb);
+        void Unregister(Ipv4Address src, uint16_t dstPort);
+
+        // Frames that matched no registered flow
+        uint64_t GetUnmatched() const;
+
+    protected:
+        void DoDispose() override;
+
+    private:
+        // Device receive callback
+        bool Receive(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender);
+        // Route one frame to its flow
+        bool Dispatch(Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender);
+
+        static uint64_t MakeKey(uint32_t src, uint16_t port);
+        // Slot holding key, or the first free slot on its probe sequence
+        uint32_t FindSlot(uint64_t key) const;
+        // Rebuild the table without tombstones, doubling it if the live keys need the room
+        void Rehash();
+
+        static const uint64_t EMPTY = ~0ULL;        // Never a valid key, keys use only 48 bits
+        static const uint64_t TOMBSTONE = ~1ULL;    // Slot of an unregistered flow
+        static const uint32_t NO_RING = UINT32_MAX;
+
+        struct Slot
+        {
+            uint64_t key;       // (source IP << 16) | destination port
+            uint32_t index;     // Index into m_callbacks
+        };
+
+        std::vector<Slot> m_slots;              // Power of two sized, at most half full
+        std::vector<RxCallback> m_callbacks;    // Registered callbacks, referenced by slot
+        std::vector<uint32_t> m_freeCallbacks;  // Reusable m_callbacks entries
+        uint32_t m_used;                        // Slots holding a key or a tombstone
+        uint64_t m_unmatched;                   // Frames without a registered flow
+        uint32_t m_ring;                        // RxCoalescing ring in front of Dispatch, NO_RING if none
+};
+
+}
+
+#endif
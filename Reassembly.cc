@@ -0,0 +1,107 @@
+#include "Reassembly.h"
+#include "Checksum.h"
+
+namespace ns3 {
+
+void SegmentInfo::WriteTo(uint8_t* buf) const
+{
+    WriteNet16(buf, static_cast<uint16_t>(msgSeq >> 16));
+    WriteNet16(buf + 2, static_cast<uint16_t>(msgSeq));
+    WriteNet16(buf + 4, static_cast<uint16_t>(msgLen >> 16));
+    WriteNet16(buf + 6, static_cast<uint16_t>(msgLen));
+    WriteNet16(buf + 8, index);
+    WriteNet16(buf + 10, count);
+}
+
+bool SegmentInfo::ReadFrom(const uint8_t* buf, uint32_t len)
+{
+    if (len < SIZE)
+    {
+        return false;
+    }
+    msgSeq = static_cast<uint32_t>(ReadNet16(buf)) << 16 | ReadNet16(buf + 2);
+    msgLen = static_cast<uint32_t>(ReadNet16(buf + 4)) << 16 | ReadNet16(buf + 6);
+    index = ReadNet16(buf + 8);
+    count = ReadNet16(buf + 10);
+    return count > 0 && count <= MAX_SEGMENTS && index < count;
+}
+
+Reassembler::Reassembler()
+{
+}
+
+void Reassembler::Setup(uint32_t slots)
+{
+    m_slots.assign(slots > 0 ? slots : 1, Slot());
+    // Nothing finished yet, so nothing is stale
+    m_last.assign(m_slots.size(), UINT32_MAX);
+}
+
+bool Reassembler::IsSetup() const
+{
+    return !m_slots.empty();
+}
+
+Reassembler::Result Reassembler::Add(const SegmentInfo& seg, int64_t txNs, int64_t& msgTxNs, uint32_t& evicted)
+{
+    evicted = 0;
+    uint32_t index = seg.msgSeq % m_slots.size();
+    Slot& slot = m_slots[index];
+    if (slot.used && slot.msgSeq != seg.msgSeq)
+    {
+        if (seg.msgSeq < slot.msgSeq)
+        {
+            // Straggler of a message this slot already gave up on
+            return STALE;
+        }
+        evicted = 1;
+        m_last[index] = slot.msgSeq;
+        slot.used = false;
+    }
+    if (!slot.used)
+    {
+        if (m_last[index] != UINT32_MAX && seg.msgSeq <= m_last[index])
+        {
+            return STALE;
+        }
+        slot.used = true;
+        slot.msgSeq = seg.msgSeq;
+        slot.count = seg.count;
+        slot.received = 0;
+        slot.txNs = txNs;
+        for (uint64_t& word : slot.seen)
+        {
+            word = 0;
+        }
+    }
+
+    uint64_t bit = 1ull << (seg.index % 64);
+    uint64_t& word = slot.seen[seg.index / 64];
+    if (word & bit)
+    {
+        return DUPLICATE;
+    }
+    word |= bit;
+    slot.received++;
+    if (slot.received < slot.count)
+    {
+        return PARTIAL;
+    }
+    msgTxNs = slot.txNs;
+    slot.used = false;
+    m_last[index] = slot.msgSeq;
+    return COMPLETE;
+}
+
+uint32_t Reassembler::Flush()
+{
+    uint32_t incomplete = 0;
+    for (Slot& slot : m_slots)
+    {
+        incomplete += slot.used;
+        slot.used = false;
+    }
+    return incomplete;
+}
+
+}
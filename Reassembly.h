@@ -0,0 +1,73 @@
+#ifndef REASSEMBLY_H
+#define REASSEMBLY_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+// Segment header carried after the probe header of each frame of a segmented message.
+//
+// Wire layout (network byte order, 12 bytes):
+//   message sequence (4) | message length (4) | segment index (2) | segment count (2)
+struct SegmentInfo
+{
+    static const uint32_t SIZE = 12;
+    // Enough for a 64 KB message over a 576 byte MTU, 127 segments. The segments are enqueued
+    // back to back, a device queue shorter than that refuses the tail and the message is lost.
+    static const uint32_t MAX_SEGMENTS = 256;
+
+    uint32_t msgSeq = 0;    // Per flow message number
+    uint32_t msgLen = 0;    // Message bytes, excluding all headers
+    uint16_t index = 0;     // Position of this segment in the message
+    uint16_t count = 0;     // Segments in the message
+
+    void WriteTo(uint8_t* buf) const;
+    // Returns false if the header is short or inconsistent
+    bool ReadFrom(const uint8_t* buf, uint32_t len);
+};
+
+// Receiver side reassembly into a fixed set of slots allocated up front. Message n goes
+// to slot n % slots, a newer message claiming a busy slot evicts the older, incomplete one.
+// Only which segments have arrived is tracked: segmented payloads are zero filled, so
+// nothing needs to be copied.
+class Reassembler {
+    public:
+        enum Result
+        {
+            PARTIAL,        // Segment stored, message still incomplete
+            COMPLETE,       // Segment completed its message
+            DUPLICATE,      // Segment already seen
+            STALE,          // Segment of a message that was already completed or evicted
+        };
+
+        Reassembler();
+
+        void Setup(uint32_t slots);
+        bool IsSetup() const;
+
+        // Account one segment sent at txNs. On COMPLETE, txNs of the message's first segment is
+        // returned in msgTxNs. evicted counts incomplete messages pushed out by this segment.
+        Result Add(const SegmentInfo& seg, int64_t txNs, int64_t& msgTxNs, uint32_t& evicted);
+        // Drop every incomplete message, returns how many there were
+        uint32_t Flush();
+
+    private:
+        struct Slot
+        {
+            bool used = false;          // Holds an incomplete message
+            uint32_t msgSeq = 0;        // Message in the slot
+            uint16_t count = 0;         // Segments expected
+            uint16_t received = 0;      // Distinct segments seen
+            int64_t txNs = 0;           // Send time of the first segment seen
+            uint64_t seen[SegmentInfo::MAX_SEGMENTS / 64] = {};  // Bitmap by segment index
+        };
+
+        std::vector<Slot> m_slots;      // Preallocated reassembly slots
+        std::vector<uint32_t> m_last;   // Last message finished per slot, for stale detection
+};
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include "RxCoalescing.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("RxCoalescing");
+
+RxCoalescing& RxCoalescing::Get()
+{
+    static RxCoalescing instance;
+    return instance;
+}
+
+RxCoalescing::RxCoalescing()
+    : m_enabled(false)
+{
+}
+
+void RxCoalescing::Enable(const RxRingConfig& config)
+{
+    m_enabled = true;
+    m_config = config;
+    m_config.size = std::max<uint32_t>(m_config.size, 1);
+    m_config.budget = std::max<uint32_t>(m_config.budget, 1);
+    m_config.frames = std::max<uint32_t>(m_config.frames, 1);
+}
+
+bool RxCoalescing::IsEnabled() const
+{
+    return m_enabled;
+}
+
+uint32_t RxCoalescing::Attach(const std::string& label, Handler handler)
+{
+    m_rings.emplace_back();
+    m_rings.back().label = label;
+    m_rings.back().handler = handler;
+    return m_rings.size() - 1;
+}
+
+void RxCoalescing::Detach(uint32_t ring)
+{
+    Ring& r = m_rings[ring];
+    Simulator::Cancel(r.timer);
+    Simulator::Cancel(r.poll);
+    r.handler = Handler();
+    // Releases the packets and devices, the counters stay for the report
+    std::vector<Entry>().swap(r.entries);
+    r.count = 0;
+    r.inPoll = 0;
+}
+
+void RxCoalescing::Enqueue(uint32_t ring, Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender)
+{
+    Ring& r = m_rings[ring];
+    if (r.handler.IsNull())
+    {
+        return;
+    }
+    if (r.entries.empty())
+    {
+        r.entries.resize(m_config.size);
+        r.sizes.assign(m_config.budget + 1, 0);
+    }
+    if (r.count == r.entries.size())
+    {
+        r.drops++;
+        return;
+    }
+
+    Entry& entry = r.entries[(r.head + r.count) % r.entries.size()];
+    entry.device = device;
+    entry.pkt = pkt;
+    entry.sender = sender;
+    entry.protocol = protocol;
+    entry.arrivalNs = Simulator::Now().GetNanoSeconds();
+    r.count++;
+
+    // While a poll runs interrupts are off, the frame waits for the next poll
+    if (r.inPoll)
+    {
+        return;
+    }
+    if (r.count >= m_config.frames)
+    {
+        Simulator::Cancel(r.timer);
+        r.byCount++;
+        Poll(ring);
+    }
+    else if (!r.timer.IsPending())
+    {
+        r.timer = Simulator::Schedule(m_config.timeout, &RxCoalescing::OnTimeout, this, ring);
+    }
+}
+
+void RxCoalescing::OnTimeout(uint32_t ring)
+{
+    m_rings[ring].byTimeout++;
+    Poll(ring);
+}
+
+void RxCoalescing::Poll(uint32_t ring)
+{
+    Ring& r = m_rings[ring];
+    r.inPoll = std::min(r.count, m_config.budget);
+    r.poll = Simulator::Schedule(m_config.batchCost + m_config.frameCost * r.inPoll, &RxCoalescing::Complete, this, ring);
+}
+
+void RxCoalescing::Complete(uint32_t ring)
+{
+    uint32_t batch = m_rings[ring].inPoll;
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    for (uint32_t i = 0; i < batch && !m_rings[ring].handler.IsNull(); i++)
+    {
+        // The handler may send frames or start apps, which can attach new rings and move m_rings
+        Ring& r = m_rings[ring];
+        Entry entry = std::move(r.entries[r.head]);
+        r.entries[r.head] = Entry();
+        r.head = (r.head + 1) % r.entries.size();
+        r.count--;
+        r.added.Record(static_cast<uint64_t>(now - entry.arrivalNs));
+        r.frames++;
+        Handler handler = r.handler;
+        handler(entry.device, entry.pkt, entry.protocol, entry.sender);
+    }
+
+    Ring& r = m_rings[ring];
+    if (r.handler.IsNull())
+    {
+        return;
+    }
+    r.inPoll = 0;
+    r.batches++;
+    r.sizes[batch]++;
+    if (r.count == 0)
+    {
+        return;
+    }
+    if (batch == m_config.budget)
+    {
+        // More work is likely waiting, keep polling without re-enabling the interrupt
+        r.repolls++;
+        Poll(ring);
+    }
+    else if (r.count >= m_config.frames)
+    {
+        r.byCount++;
+        Poll(ring);
+    }
+    else
+    {
+        // Re-arm for the oldest waiting frame, which may already be overdue
+        int64_t waited = now - r.entries[r.head].arrivalNs;
+        Time left = Max(m_config.timeout - NanoSeconds(waited), Seconds(0));
+        r.timer = Simulator::Schedule(left, &RxCoalescing::OnTimeout, this, ring);
+    }
+}
+
+uint32_t RxCoalescing::SizePercentile(const std::vector<uint64_t>& sizes, uint64_t batches, double q)
+{
+    if (batches == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * batches);
+    uint64_t seen = 0;
+    for (uint32_t size = 0; size < sizes.size(); size++)
+    {
+        seen += sizes[size];
+        if (seen > rank)
+        {
+            return size;
+        }
+    }
+    return sizes.empty() ? 0 : sizes.size() - 1;
+}
+
+void RxCoalescing::Print(std::ostream& os) const
+{
+    os << std::fixed << std::setprecision(3);
+    for (const Ring& r : m_rings)
+    {
+        if (r.batches == 0 && r.drops == 0)
+        {
+            continue;
+        }
+        os << "Rx ring " << r.label << ": " << r.frames << " frames in " << r.batches << " batches ("
+           << r.byCount << " by count, " << r.byTimeout << " by timeout, " << r.repolls << " repolled), "
+           << r.drops << " ring drops" << std::endl;
+        os << "    batch size: mean " << (r.batches ? static_cast<double>(r.frames) / r.batches : 0.0)
+           << " p50 " << SizePercentile(r.sizes, r.batches, 0.5) << " p99 " << SizePercentile(r.sizes, r.batches, 0.99)
+           << ", added latency us p50 " << r.added.Percentile(0.5) / 1e3 << " p99 " << r.added.Percentile(0.99) / 1e3
+           << " max " << r.added.GetMax() / 1e3 << std::endl;
+        // Power of two ranges: 1, 2-3, 4-7, ...
+        os << "    batches by size:";
+        for (uint32_t low = 1; low < r.sizes.size(); low *= 2)
+        {
+            uint32_t high = std::min<uint32_t>(low * 2, r.sizes.size()) - 1;
+            uint64_t count = 0;
+            for (uint32_t size = low; size <= high; size++)
+            {
+                count += r.sizes[size];
+            }
+            os << " " << low;
+            if (high > low)
+            {
+                os << "-" << high;
+            }
+            os << ":" << count;
+        }
+        os << std::endl;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+void RxCoalescing::WriteSummary(std::ostream& os) const
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+    uint64_t frames = 0;
+    uint64_t batches = 0;
+    uint64_t drops = 0;
+    std::vector<uint64_t> sizes(m_config.budget + 1, 0);
+    LatencyHistogram added;
+    for (const Ring& r : m_rings)
+    {
+        frames += r.frames;
+        batches += r.batches;
+        drops += r.drops;
+        for (uint32_t size = 0; size < r.sizes.size(); size++)
+        {
+            sizes[size] += r.sizes[size];
+        }
+        added.Merge(r.added);
+    }
+    os << "rx_frames " << frames << "\n"
+       << "rx_batches " << batches << "\n"
+       << "rx_batch_mean " << (batches ? static_cast<double>(frames) / batches : 0.0) << "\n"
+       << "rx_batch_p99 " << SizePercentile(sizes, batches, 0.99) << "\n"
+       << "rx_ring_drops " << drops << "\n"
+       << "rx_added_p50_ms " << added.Percentile(0.5) / 1e6 << "\n"
+       << "rx_added_p99_ms " << added.Percentile(0.99) / 1e6 << "\n";
+}
+
+}
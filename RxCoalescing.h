@@ -0,0 +1,98 @@
+#ifndef RX_COALESCING_H
+#define RX_COALESCING_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "LatencyHistogram.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+// Receive side interrupt coalescing, modelled after NAPI
+struct RxRingConfig
+{
+    uint32_t size = 256;                // Frames the ring holds, arrivals to a full ring are dropped
+    uint32_t frames = 32;               // Raise the interrupt once this many frames wait
+    Time timeout = MicroSeconds(50);    // ... or once the oldest waiting frame is this old
+    uint32_t budget = 64;               // Frames processed per poll
+    Time batchCost = MicroSeconds(2);   // Receiver CPU time per poll
+    Time frameCost = NanoSeconds(200);  // Receiver CPU time per frame
+};
+
+// Bounded per device receive rings. Arriving frames wait in the ring until the interrupt
+// fires, by frame count or timeout. A poll then takes up to budget frames, keeps the
+// receiver busy for batchCost + n * frameCost and hands the frames to the handler when
+// it is done. A poll that used its whole budget is followed by another one right away,
+// otherwise the interrupt is re-armed. Ring slots are allocated on the first frame.
+class RxCoalescing {
+    public:
+        typedef Callback<bool, Ptr<NetDevice>, Ptr<const Packet>, uint16_t, const Address&> Handler;
+
+        static RxCoalescing& Get();
+
+        // Rings attached from now on use config
+        void Enable(const RxRingConfig& config);
+        bool IsEnabled() const;
+
+        // New ring in front of handler, returns its id
+        uint32_t Attach(const std::string& label, Handler handler);
+        // Drop the ring's waiting frames and pending events, the handler is not called again
+        void Detach(uint32_t ring);
+        // Device receive path of a ring
+        void Enqueue(uint32_t ring, Ptr<NetDevice> device, Ptr<const Packet> pkt, uint16_t protocol, const Address& sender);
+
+        // Batch size distribution, added latency and ring drops of every ring that received frames
+        void Print(std::ostream& os) const;
+        // Totals over all rings as key value lines, nothing if disabled
+        void WriteSummary(std::ostream& os) const;
+
+    private:
+        struct Entry
+        {
+            Ptr<NetDevice> device;
+            Ptr<const Packet> pkt;
+            Address sender;
+            uint16_t protocol = 0;
+            int64_t arrivalNs = 0;
+        };
+
+        struct Ring
+        {
+            std::string label;              // e.g. "n4"
+            Handler handler;                // Null once detached
+            std::vector<Entry> entries;     // Circular buffer of waiting frames
+            uint32_t head = 0;              // Oldest waiting frame
+            uint32_t count = 0;             // Waiting frames, including those of the poll in progress
+            uint32_t inPoll = 0;            // Frames taken by the poll in progress, 0 if none
+            EventId timer;                  // Coalescing timeout
+            EventId poll;                   // End of the poll in progress
+            uint64_t frames = 0;            // Frames handed to the handler
+            uint64_t batches = 0;           // Polls completed
+            uint64_t byCount = 0;           // Interrupts raised by the frame threshold
+            uint64_t byTimeout = 0;         // Interrupts raised by the timeout
+            uint64_t repolls = 0;           // Polls following a full budget poll without an interrupt
+            uint64_t drops = 0;             // Arrivals to a full ring
+            std::vector<uint64_t> sizes;    // Batches by number of frames
+            LatencyHistogram added;         // Arrival to hand over per frame, in ns
+        };
+
+        RxCoalescing();
+
+        void OnTimeout(uint32_t ring);
+        void Poll(uint32_t ring);
+        void Complete(uint32_t ring);
+        // Batch size at quantile q of the given counts by size
+        static uint32_t SizePercentile(const std::vector<uint64_t>& sizes, uint64_t batches, double q);
+
+        bool m_enabled;                 // Rings are attached by the demux
+        RxRingConfig m_config;          // Applied to every ring
+        std::vector<Ring> m_rings;      // By ring id
+};
+
+}
+
+#endif
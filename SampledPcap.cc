@@ -0,0 +1,46 @@
+#include "SampledPcap.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("SampledPcap");
+
+Ptr<SampledPcap> SampledPcap::Enable(const std::string& prefix, Ptr<NetDevice> device, uint32_t everyN, uint32_t snapLen)
+{
+    PcapHelper pcapHelper;
+    std::string filename = pcapHelper.GetFilenameFromDevice(prefix, device);
+    Ptr<PcapFileWrapper> file = pcapHelper.CreateFile(filename, std::ios::out, PcapHelper::DLT_EN10MB, snapLen);
+
+    Ptr<SampledPcap> sampler = Create<SampledPcap>(file, everyN);
+    device->TraceConnectWithoutContext("Sniffer", MakeCallback(&SampledPcap::Sniff, sampler));
+    return sampler;
+}
+
+SampledPcap::SampledPcap(Ptr<PcapFileWrapper> file, uint32_t everyN)
+{
+    m_file = file;
+    m_everyN = everyN > 0 ? everyN : 1;
+    m_seen = 0;
+    m_written = 0;
+}
+
+uint64_t SampledPcap::GetSeen() const
+{
+    return m_seen;
+}
+
+uint64_t SampledPcap::GetWritten() const
+{
+    return m_written;
+}
+
+void SampledPcap::Sniff(Ptr<const Packet> pkt)
+{
+    if (m_seen++ % m_everyN == 0)
+    {
+        // The pcap file truncates frames beyond its snap length
+        m_file->Write(Simulator::Now(), pkt);
+        m_written++;
+    }
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef SAMPLED_PCAP_H
+#define SAMPLED_PCAP_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <string>
+
+namespace ns3
+{
+
+// Pcap capture of one device that keeps only every Nth frame, truncated to a snap
+// length. Much cheaper than full capture on long runs while still giving a
+// representative sample of what crossed the device.
+class SampledPcap : public SimpleRefCount<SampledPcap> {
+    public:
+        // Capture 1 in everyN frames of device into <prefix>-<node>-<device>.pcap
+        static Ptr<SampledPcap> Enable(const std::string& prefix, Ptr<NetDevice> device, uint32_t everyN, uint32_t snapLen);
+
+        SampledPcap(Ptr<PcapFileWrapper> file, uint32_t everyN);
+
+        uint64_t GetSeen() const;
+        uint64_t GetWritten() const;
+
+    private:
+        void Sniff(Ptr<const Packet> pkt);
+
+        Ptr<PcapFileWrapper> m_file;    // Output capture
+        uint32_t m_everyN;              // Sampling ratio
+        uint64_t m_seen;                // Frames seen by the sniffer
+        uint64_t m_written;             // Frames written to the capture
+};
+
+}
+
+#endif
@@ -0,0 +1,410 @@
+#include "Scenario.h"
+#include "FlowStats.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("Scenario");
+
+// Binary records are read this many at a time
+static const size_t SCENARIO_CHUNK = 4096;
+
+ScenarioReader::ScenarioReader()
+    : m_file(nullptr),
+      m_binary(false),
+      m_line(nullptr),
+      m_lineCap(0),
+      m_lineNo(0),
+      m_pos(0),
+      m_lastStart(0)
+{
+}
+
+ScenarioReader::~ScenarioReader()
+{
+    if (m_file)
+    {
+        std::fclose(m_file);
+    }
+    std::free(m_line);
+}
+
+bool ScenarioReader::Open(const std::string& path)
+{
+    m_path = path;
+    m_file = std::fopen(path.c_str(), "rb");
+    if (!m_file)
+    {
+        return false;
+    }
+    char magic[sizeof(SCENARIO_MAGIC)];
+    m_binary = std::fread(magic, 1, sizeof(magic), m_file) == sizeof(magic) &&
+               std::memcmp(magic, SCENARIO_MAGIC, sizeof(magic)) == 0;
+    if (!m_binary)
+    {
+        std::rewind(m_file);
+    }
+    m_flows.clear();
+    m_pos = 0;
+    return true;
+}
+
+void ScenarioReader::SetFlows(std::vector<FlowSpec> flows)
+{
+    std::stable_sort(flows.begin(), flows.end(),
+                     [](const FlowSpec& a, const FlowSpec& b) { return a.start < b.start; });
+    m_flows = std::move(flows);
+    m_pos = 0;
+}
+
+bool ScenarioReader::Next(FlowSpec& spec)
+{
+    bool ok;
+    if (!m_file)
+    {
+        ok = m_pos < m_flows.size();
+        if (ok)
+        {
+            spec = m_flows[m_pos++];
+        }
+    }
+    else
+    {
+        ok = m_binary ? ReadBinary(spec) : ReadText(spec);
+    }
+    if (!ok)
+    {
+        return false;
+    }
+    if (spec.start < m_lastStart)
+    {
+        NS_FATAL_ERROR(m_path << ": flow starting at " << spec.start << "s follows one starting at " << m_lastStart
+                              << "s, scenario files must be sorted by start time");
+    }
+    m_lastStart = spec.start;
+    return true;
+}
+
+bool ScenarioReader::ReadText(FlowSpec& spec)
+{
+    std::string error;
+    while (getline(&m_line, &m_lineCap, m_file) != -1)
+    {
+        m_lineNo++;
+        int result = ParseFlowLine(m_line, spec, error);
+        if (result < 0)
+        {
+            NS_FATAL_ERROR(m_path << ":" << m_lineNo << ": " << error);
+        }
+        if (result > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ScenarioReader::ReadBinary(FlowSpec& spec)
+{
+    if (m_pos == m_flows.size())
+    {
+        m_flows.resize(SCENARIO_CHUNK);
+        size_t n = std::fread(m_flows.data(), sizeof(FlowSpec), SCENARIO_CHUNK, m_file);
+        m_flows.resize(n);
+        m_pos = 0;
+        if (n == 0)
+        {
+            return false;
+        }
+    }
+    spec = m_flows[m_pos++];
+    if (spec.arrival >= SCENARIO_ARRIVAL_COUNT)
+    {
+        NS_FATAL_ERROR(m_path << ": corrupt record, arrival process " << unsigned(spec.arrival));
+    }
+    return true;
+}
+
+ScenarioDriver::ScenarioDriver(ScenarioReader& reader, const Topology& topology, const FlowOptions& options)
+    : m_reader(reader),
+      m_topology(topology),
+      m_options(options),
+      m_lookahead(Seconds(1)),
+      m_linger(Seconds(1)),
+      m_hasNext(false),
+      m_numFlows(0),
+      m_retiredSent(0),
+      m_peakActive(0)
+{
+}
+
+void ScenarioDriver::SetLookahead(Time lookahead)
+{
+    m_lookahead = lookahead;
+}
+
+void ScenarioDriver::SetLinger(Time linger)
+{
+    m_linger = linger;
+}
+
+void ScenarioDriver::Start()
+{
+    m_hasNext = m_reader.Next(m_next);
+    Pump();
+}
+
+void ScenarioDriver::Pump()
+{
+    Time horizon = Simulator::Now() + m_lookahead;
+    while (m_hasNext && Seconds(m_next.start) <= horizon)
+    {
+        if (Seconds(m_next.start) >= m_options.stop)
+        {
+            // Sorted by start time, nothing after this runs either
+            m_hasNext = false;
+            break;
+        }
+        Activate(m_numFlows++, m_next);
+        m_hasNext = m_reader.Next(m_next);
+    }
+    if (m_hasNext && Seconds(m_next.start) < m_options.stop)
+    {
+        Time wake = Seconds(m_next.start) - m_lookahead - Simulator::Now();
+        Simulator::Schedule(Max(wake, Seconds(0)), &ScenarioDriver::Pump, this);
+    }
+}
+
+void ScenarioDriver::Activate(uint32_t flowId, const FlowSpec& spec)
+{
+    if (!m_topology.IsEndpoint(spec.src) || !m_topology.IsEndpoint(spec.dst))
+    {
+        NS_FATAL_ERROR("Flow " << flowId << ": only endpoints can be initiators or targets, got n" << spec.src << "->n" << spec.dst);
+    }
+    Ptr<Node> src = NodeList::GetNode(spec.src);
+    Ptr<Node> dst = NodeList::GetNode(spec.dst);
+    bool byteTest = m_options.frame != nullptr;
+    if (m_options.gso)
+    {
+        if (spec.pktSize > RawApp::MAX_MESSAGE)
+        {
+            NS_FATAL_ERROR("Flow " << flowId << ": message of " << spec.pktSize << " bytes exceeds " << RawApp::MAX_MESSAGE);
+        }
+        if (RawApp::SegmentCount(spec.pktSize, m_options.mtu) > SegmentInfo::MAX_SEGMENTS)
+        {
+            NS_FATAL_ERROR("Flow " << flowId << ": message of " << spec.pktSize << " bytes needs more than "
+                           << SegmentInfo::MAX_SEGMENTS << " segments at a " << m_options.mtu << " byte MTU");
+        }
+    }
+    else if (!byteTest && spec.pktSize + 28 > m_options.mtu)
+    {
+        NS_FATAL_ERROR("Flow " << flowId << ": " << spec.pktSize << " byte packets exceed the " << m_options.mtu << " byte MTU, see --gso");
+    }
+
+    std::ostringstream label;
+    label << "n" << spec.src << "->n" << spec.dst;
+    FlowStats::Get().Register(flowId, label.str());
+
+    // Start and stop times are relative to initialization, which happens now
+    Time now = Simulator::Now();
+    Time start = Max(Seconds(spec.start) - now, Seconds(0));
+    Time stop = m_options.stop - now;
+
+    // In distributed runs each rank only creates the apps of its own nodes
+    ActiveFlow flow;
+    flow.src = spec.src;
+    flow.dst = spec.dst;
+    if (m_topology.IsLocal(spec.dst))
+    {
+        flow.receiver = CreateReceiver(flowId, spec, src, dst, start, stop);
+    }
+    if (m_topology.IsLocal(spec.src))
+    {
+        flow.sender = CreateSender(flowId, spec, src, dst, start, stop);
+    }
+    if (!flow.sender && !flow.receiver)
+    {
+        FlowStats::Get().Retire(flowId);
+        return;
+    }
+    Claim(flowId, flow);
+    m_active[flowId] = flow;
+    m_peakActive = std::max<uint32_t>(m_peakActive, m_active.size());
+
+    // Done only fires on the sender's rank. A receiver whose sender is remote is retired
+    // --linger after the flow's last scheduled send, or by Finish if that time is not known.
+    if (!flow.sender && !spec.rateBps)
+    {
+        uint32_t burst = std::max<uint32_t>(spec.burst, 1);
+        uint32_t events = std::max<uint32_t>((spec.numPkts + burst - 1) / burst, 1);
+        // Same gaps as RawApp::SendPacket
+        Time gap = Seconds(spec.interval);
+        if (burst > 1)
+        {
+            gap = spec.burstGap > 0 ? Seconds(spec.burstGap) : gap * burst;
+        }
+        Time retire = start + gap * (events - 1) + m_linger;
+        if (retire < stop)
+        {
+            Simulator::Schedule(retire, &ScenarioDriver::Retire, this, flowId);
+        }
+    }
+}
+
+Ptr<RawApp> ScenarioDriver::CreateReceiver(uint32_t flowId, const FlowSpec& spec, Ptr<Node> src, Ptr<Node> dst, Time start, Time stop)
+{
+    Ptr<RawApp> receiver = CreateObject<RawApp>();
+    receiver->Setup(spec.pktSize, 0, Seconds(0), false, src, false);
+    receiver->SetFlowId(flowId);
+    receiver->SetPort(GetPort(flowId));
+    receiver->SetEcho(m_options.echo);
+    if (m_options.gso)
+    {
+        receiver->SetupSegmentation(m_options.mtu, m_options.reasmSlots);
+    }
+    receiver->SetNode(dst);
+    receiver->SetStartTime(start);
+    receiver->SetStopTime(stop);
+    // Not added to the node, which could never release it. Initialize like Node::AddApplication does.
+    Simulator::ScheduleWithContext(dst->GetId(), Seconds(0), &Object::Initialize, receiver);
+    return receiver;
+}
+
+Ptr<RawApp> ScenarioDriver::CreateSender(uint32_t flowId, const FlowSpec& spec, Ptr<Node> src, Ptr<Node> dst, Time start, Time stop)
+{
+    bool byteTest = m_options.frame != nullptr;
+    Ptr<RawApp> sender = CreateObject<RawApp>();
+    sender->Setup(spec.pktSize, spec.numPkts, Seconds(spec.interval), true, dst, byteTest,
+                  m_options.fastPath && !byteTest, spec.burst, Seconds(spec.burstGap));
+    sender->SetFrame(m_options.frame);
+    sender->SetFlowId(flowId);
+    sender->SetPort(GetPort(flowId));
+    sender->SetEcho(m_options.echo);
+    if (m_options.gso)
+    {
+        sender->SetupSegmentation(m_options.mtu, m_options.reasmSlots);
+    }
+    if (spec.rateBps)
+    {
+        // Stream index per flow keeps each flow's arrivals independent and reproducible across runs
+        sender->SetupLoad(DataRate(spec.rateBps), static_cast<ArrivalProcess>(spec.arrival), flowId);
+        sender->GetTrafficGen().SetOnOff(m_options.meanOn, m_options.meanOff);
+        sender->GetTrafficGen().SetBucket(m_options.bucket, m_options.queue);
+    }
+    sender->SetDoneCallback(MakeCallback(&ScenarioDriver::Done, this));
+    sender->SetNode(src);
+    sender->SetStartTime(start);
+    sender->SetStopTime(stop);
+    Simulator::ScheduleWithContext(src->GetId(), Seconds(0), &Object::Initialize, sender);
+    return sender;
+}
+
+// A port per flow lets any number of flows share an endpoint, the receiving node demuxes on
+// (source IP, port). Ports wrap around after 57456 flows.
+uint16_t ScenarioDriver::GetPort(uint32_t flowId)
+{
+    return 8080 + flowId % (65536 - 8080);
+}
+
+uint64_t ScenarioDriver::MakeClaim(uint32_t node, uint32_t peer, uint16_t port)
+{
+    return (static_cast<uint64_t>(node) << 40) | (static_cast<uint64_t>(peer) << 16) | port;
+}
+
+// Receivers register (source, port) on the destination, echo senders (destination, port) on
+// the source. Once ports wrap, two flows between the same endpoints that are active at once
+// would take each other's frames.
+void ScenarioDriver::Claim(uint32_t flowId, const ActiveFlow& flow)
+{
+    uint16_t port = GetPort(flowId);
+    std::pair<uint32_t, uint32_t> entries[2];
+    uint32_t count = 0;
+    if (flow.receiver)
+    {
+        entries[count++] = {flow.dst, flow.src};
+    }
+    if (flow.sender && m_options.echo)
+    {
+        entries[count++] = {flow.src, flow.dst};
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto claim = m_claims.emplace(MakeClaim(entries[i].first, entries[i].second, port), flowId);
+        if (!claim.second)
+        {
+            NS_FATAL_ERROR("Flow " << flowId << ": port " << port << " between n" << entries[i].second << " and n" << entries[i].first
+                           << " is still taken by flow " << claim.first->second << ", too many flows between the same endpoints at once");
+        }
+    }
+}
+
+void ScenarioDriver::Release(uint32_t flowId, const ActiveFlow& flow)
+{
+    uint16_t port = GetPort(flowId);
+    if (flow.receiver)
+    {
+        m_claims.erase(MakeClaim(flow.dst, flow.src, port));
+    }
+    if (flow.sender && m_options.echo)
+    {
+        m_claims.erase(MakeClaim(flow.src, flow.dst, port));
+    }
+}
+
+void ScenarioDriver::Done(uint32_t flowId)
+{
+    Simulator::Schedule(m_linger, &ScenarioDriver::Retire, this, flowId);
+}
+
+void ScenarioDriver::Retire(uint32_t flowId)
+{
+    auto it = m_active.find(flowId);
+    if (it == m_active.end())
+    {
+        return;
+    }
+    if (it->second.sender)
+    {
+        FlowStats::Get().SetSent(flowId, it->second.sender->GetSent(), it->second.sender->GetRefused());
+        FlowStats::Get().RecordRefusedMessages(flowId, it->second.sender->GetRefusedMessages());
+        m_retiredSent += it->second.sender->GetSent();
+        it->second.sender->Dispose();
+    }
+    if (it->second.receiver)
+    {
+        it->second.receiver->Dispose();
+    }
+    Release(flowId, it->second);
+    m_active.erase(it);
+    // After the receiver, which accounts its incomplete messages on dispose
+    FlowStats::Get().Retire(flowId);
+}
+
+void ScenarioDriver::Finish()
+{
+    while (!m_active.empty())
+    {
+        Retire(m_active.begin()->first);
+    }
+}
+
+uint64_t ScenarioDriver::GetTotalSent() const
+{
+    return m_retiredSent;
+}
+
+uint32_t ScenarioDriver::GetNumFlows() const
+{
+    return m_numFlows;
+}
+
+uint32_t ScenarioDriver::GetPeakActive() const
+{
+    return m_peakActive;
+}
+
+}
@@ -0,0 +1,129 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "RawApp.h"
+#include "ScenarioFormat.h"
+#include "Topology.h"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+// Hands out flows in start time order from a scenario file (text or binary, see
+// ScenarioFormat.h) or from an in-memory list, one at a time so files are never held in memory
+class ScenarioReader {
+    public:
+        ScenarioReader();
+        ~ScenarioReader();
+
+        // Open a scenario file, the form is detected from the magic. Returns false if it can not be read.
+        bool Open(const std::string& path);
+        // Use an in-memory list instead, e.g. flows given on the command line. Sorted by start time.
+        void SetFlows(std::vector<FlowSpec> flows);
+
+        // Next flow, false at the end. Malformed entries and out of order start times are fatal.
+        bool Next(FlowSpec& spec);
+
+    private:
+        bool ReadText(FlowSpec& spec);
+        bool ReadBinary(FlowSpec& spec);
+
+        std::string m_path;             // File being read, for error messages
+        FILE* m_file;                   // Open scenario file, null for in-memory flows
+        bool m_binary;                  // File holds FlowSpec records
+        char* m_line;                   // getline buffer for the text form
+        size_t m_lineCap;               // Capacity of m_line
+        uint64_t m_lineNo;              // Current line of the text form
+        std::vector<FlowSpec> m_flows;  // In-memory flows, or the current chunk of binary records
+        size_t m_pos;                   // Next entry of m_flows
+        double m_lastStart;             // Start time of the previous flow, to enforce ordering
+};
+
+// Settings shared by every flow of a run
+struct FlowOptions
+{
+    Ptr<const FrameTemplate> frame; // Raw frame sent instead of IPv4/UDP packets, null for none
+    bool fastPath = true;       // Send from prebuilt header templates
+    bool echo = false;          // Request/reply mode
+    Time meanOn;                // On period of the onoff arrival process
+    Time meanOff;               // Off period of the onoff arrival process
+    uint32_t bucket = 65536;    // Depth of the tbf arrival process (bytes)
+    QueueSize queue{"100p"};    // Device transmit queue, the tbf bucket is capped at what it holds
+    uint32_t mtu = 1500;        // Device MTU, larger packets need segmentation
+    bool gso = false;           // pktSize is a message, split into MTU sized frames and reassembled
+    uint32_t reasmSlots = 16;   // Reassembly slots per receiver in segmentation mode
+    Time stop;                  // Simulation end, apps stop here
+};
+
+// Creates the apps of each flow shortly before it starts and releases them, and retires the
+// flow's statistics, once the sender is done. So memory follows the number of concurrently
+// active flows rather than the total.
+// Flow ids are assigned in reading order.
+class ScenarioDriver {
+    public:
+        ScenarioDriver(ScenarioReader& reader, const Topology& topology, const FlowOptions& options);
+
+        // How far ahead of its start time a flow is created
+        void SetLookahead(Time lookahead);
+        // How long the receiver (and echo sender) outlives the last send, for frames in flight
+        void SetLinger(Time linger);
+
+        // Schedule activation of the first flows, call before Simulator::Run
+        void Start();
+        // Account the frames sent by flows still active at the end of the run
+        void Finish();
+
+        uint64_t GetTotalSent() const;
+        uint32_t GetNumFlows() const;
+        uint32_t GetPeakActive() const;
+
+    private:
+        // Activate every flow starting within the lookahead, then schedule the next pump
+        void Pump();
+        void Activate(uint32_t flowId, const FlowSpec& spec);
+        Ptr<RawApp> CreateReceiver(uint32_t flowId, const FlowSpec& spec, Ptr<Node> src, Ptr<Node> dst, Time start, Time stop);
+        Ptr<RawApp> CreateSender(uint32_t flowId, const FlowSpec& spec, Ptr<Node> src, Ptr<Node> dst, Time start, Time stop);
+        void Done(uint32_t flowId);
+        void Retire(uint32_t flowId);
+
+        // Either app is null when its node is simulated by another rank. A flow whose
+        // sender is remote is retired at the end of its sends, rate driven flows at Finish.
+        struct ActiveFlow
+        {
+            Ptr<RawApp> sender;
+            Ptr<RawApp> receiver;
+            uint32_t src;
+            uint32_t dst;
+        };
+
+        // UDP port of a flow, the same on every rank
+        static uint16_t GetPort(uint32_t flowId);
+        // Demux entry (peer IP, port) registered on node
+        static uint64_t MakeClaim(uint32_t node, uint32_t peer, uint16_t port);
+        // Take the demux entries of the flow's local apps, aborts if another active flow holds one
+        void Claim(uint32_t flowId, const ActiveFlow& flow);
+        void Release(uint32_t flowId, const ActiveFlow& flow);
+
+        ScenarioReader& m_reader;
+        const Topology& m_topology;
+        FlowOptions m_options;
+        Time m_lookahead;               // Creation lead time
+        Time m_linger;                  // Retirement delay after the last send
+        FlowSpec m_next;                // Next flow to activate
+        bool m_hasNext;                 // m_next is valid
+        uint32_t m_numFlows;            // Flows activated so far, the next flow id
+        uint64_t m_retiredSent;         // Frames sent by retired flows
+        uint32_t m_peakActive;          // Most flows active at once
+        std::unordered_map<uint32_t, ActiveFlow> m_active;  // By flow id
+        std::unordered_map<uint64_t, uint32_t> m_claims;    // Flow holding each demux entry in use
+};
+
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef SCENARIO_FORMAT_H
+#define SCENARIO_FORMAT_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Scenario files describe one flow per entry, sorted by start time so they can be read in
+// a single streaming pass while the simulation runs. Kept free of ns-3 headers so offline
+// tools can write them.
+//
+// Text form, one flow per line, '#' starts a comment:
+//     src dst start numPkts pktSize interval [burst [burstGap [rate [arrival]]]]
+// with times in seconds, rate e.g. 12Mbps or - for none, arrival constant, poisson, onoff or tbf.
+//
+// Binary form: the 8 byte magic followed by FlowSpec records in host byte order.
+
+namespace ns3
+{
+
+static const char SCENARIO_MAGIC[8] = {'R', 'A', 'W', 'S', 'C', 'N', '0', '1'};
+
+// Same order as ArrivalProcess
+static const char* const SCENARIO_ARRIVALS[] = {"constant", "poisson", "onoff", "tbf"};
+static const uint8_t SCENARIO_ARRIVAL_COUNT = 4;
+
+struct FlowSpec
+{
+    double start = 0;       // Start time (s)
+    double interval = 1.0;  // Interval between send events (s), unused with a rate
+    double burstGap = 0;    // Time between bursts (s), 0 keeps one packet per interval
+    uint64_t rateBps = 0;   // Offered load replacing the interval, 0 for none
+    uint32_t src = 0;       // Initiator node id
+    uint32_t dst = 0;       // Target node id
+    uint32_t numPkts = 5;   // Packets to send
+    uint32_t pktSize = 1024;    // UDP payload bytes
+    uint32_t burst = 1;     // Frames per send event
+    uint8_t arrival = 0;    // Index into SCENARIO_ARRIVALS
+    uint8_t reserved[3] = {0, 0, 0};
+};
+
+static_assert(sizeof(FlowSpec) == 56, "FlowSpec must stay 56 bytes");
+
+// Parse a rate such as 1500000, 1.5Mbps, 100kbps or 10Gbps into bits per second
+inline bool ParseRateBps(const char* text, uint64_t& bps)
+{
+    char* end;
+    errno = 0;
+    double value = std::strtod(text, &end);
+    if (end == text || errno || value < 0)
+    {
+        return false;
+    }
+    double scale = 1;
+    if (*end == 'k' || *end == 'K')
+    {
+        scale = 1e3;
+        end++;
+    }
+    else if (*end == 'M')
+    {
+        scale = 1e6;
+        end++;
+    }
+    else if (*end == 'G')
+    {
+        scale = 1e9;
+        end++;
+    }
+    if (*end && std::strcmp(end, "bps") != 0 && std::strcmp(end, "b/s") != 0)
+    {
+        return false;
+    }
+    bps = static_cast<uint64_t>(value * scale + 0.5);
+    return true;
+}
+
+inline bool ParseArrival(const char* text, uint8_t& arrival)
+{
+    for (uint8_t i = 0; i < SCENARIO_ARRIVAL_COUNT; i++)
+    {
+        if (std::strcmp(text, SCENARIO_ARRIVALS[i]) == 0)
+        {
+            arrival = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse one line of the text form. Returns 1 for a flow, 0 for a blank or comment line and
+// -1 with error set for a malformed line. line is modified.
+inline int ParseFlowLine(char* line, FlowSpec& spec, std::string& error)
+{
+    char* hash = std::strchr(line, '#');
+    if (hash)
+    {
+        *hash = '\0';
+    }
+    const char* fields[10];
+    int n = 0;
+    for (char* tok = std::strtok(line, " \t\r\n"); tok; tok = std::strtok(nullptr, " \t\r\n"))
+    {
+        if (n == 10)
+        {
+            error = "more than 10 fields";
+            return -1;
+        }
+        fields[n++] = tok;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (n < 6)
+    {
+        error = "expected at least src dst start numPkts pktSize interval";
+        return -1;
+    }
+
+    spec = FlowSpec();
+    char* end;
+    bool ok = true;
+    auto toUint = [&](const char* text) {
+        unsigned long value = std::strtoul(text, &end, 10);
+        ok = ok && end != text && *end == '\0' && value <= UINT32_MAX;
+        return static_cast<uint32_t>(value);
+    };
+    auto toDouble = [&](const char* text) {
+        double value = std::strtod(text, &end);
+        ok = ok && end != text && *end == '\0' && value >= 0;
+        return value;
+    };
+    spec.src = toUint(fields[0]);
+    spec.dst = toUint(fields[1]);
+    spec.start = toDouble(fields[2]);
+    spec.numPkts = toUint(fields[3]);
+    spec.pktSize = toUint(fields[4]);
+    spec.interval = toDouble(fields[5]);
+    if (n > 6)
+    {
+        spec.burst = toUint(fields[6]);
+    }
+    if (n > 7)
+    {
+        spec.burstGap = toDouble(fields[7]);
+    }
+    if (!ok)
+    {
+        error = "malformed number";
+        return -1;
+    }
+    if (n > 8 && std::strcmp(fields[8], "-") != 0 && !ParseRateBps(fields[8], spec.rateBps))
+    {
+        error = std::string("malformed rate ") + fields[8];
+        return -1;
+    }
+    if (n > 9 && !ParseArrival(fields[9], spec.arrival))
+    {
+        error = std::string("unknown arrival process ") + fields[9];
+        return -1;
+    }
+    return 1;
+}
+
+}
+
+#endif
@@ -0,0 +1,364 @@
+#include "Topology.h"
+#include "FastSwitchNetDevice.h"
+#include "ns3/bridge-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("Topology");
+
+Topology::Topology()
+    : m_queueSize("100p"),
+      m_mtu(1500),
+      m_links(0),
+      m_trunks(0),
+      m_rank(0),
+      m_ranks(1)
+{
+}
+
+void Topology::SetQueueSize(const std::string& queueSize)
+{
+    m_queueSize = queueSize;
+}
+
+void Topology::SetMtu(uint32_t mtu)
+{
+    m_mtu = mtu;
+}
+
+void Topology::SetSwitch(const SwitchConfig& config)
+{
+    m_switch = config;
+}
+
+void Topology::SetRanks(uint32_t rank, uint32_t ranks)
+{
+    m_rank = rank;
+    m_ranks = std::max<uint32_t>(ranks, 1);
+}
+
+Ptr<Node> Topology::CreateNode(uint32_t rank)
+{
+    Ptr<Node> node = CreateObject<Node>(rank % m_ranks);
+    m_nodes.Add(node);
+    return node;
+}
+
+CsmaHelper Topology::MakeHelper(const LinkTier& tier) const
+{
+    CsmaHelper csma;
+    csma.SetChannelAttribute("DataRate", StringValue(tier.rate));
+    csma.SetChannelAttribute("Delay", TimeValue(tier.delay));
+    csma.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize(m_queueSize)));
+    csma.SetDeviceAttribute("Mtu", UintegerValue(m_mtu));
+    return csma;
+}
+
+NetDeviceContainer Topology::Link(CsmaHelper& csma, Ptr<Node> a, Ptr<Node> b)
+{
+    NetDeviceContainer devices = csma.Install(NodeContainer(a, b));
+    m_ports[b->GetId()].Add(devices.Get(1));
+    if (!m_isEndpoint[a->GetId()])
+    {
+        m_ports[a->GetId()].Add(devices.Get(0));
+    }
+    m_links++;
+    return devices;
+}
+
+void Topology::Trunk(const LinkTier& tier, Ptr<Node> a, Ptr<Node> b)
+{
+    NS_ABORT_MSG_IF(m_isEndpoint[a->GetId()] || m_isEndpoint[b->GetId()], "Only switches can be split across ranks");
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue(tier.rate));
+    p2p.SetChannelAttribute("Delay", TimeValue(tier.delay));
+    p2p.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize(m_queueSize)));
+    // Frames cross with their Ethernet header inside
+    p2p.SetDeviceAttribute("Mtu", UintegerValue(m_mtu + 14));
+    // Becomes a remote channel when a and b are on different ranks
+    NetDeviceContainer devices = p2p.Install(a, b);
+    m_trunkPorts[a->GetId()].Add(devices.Get(0));
+    m_trunkPorts[b->GetId()].Add(devices.Get(1));
+    m_links++;
+    m_trunks++;
+}
+
+void Topology::InstallBridges()
+{
+    NS_ABORT_MSG_IF(!m_trunkPorts.empty() && !m_switch.fast,
+                    "Links between ranks need fast switches (--switch=fast), bridges can not forward over point to point links");
+    BridgeHelper bridgehelper;
+    bridgehelper.SetDeviceAttribute("Mtu", UintegerValue(m_mtu));
+    for (uint32_t i = 0; i < m_switches.GetN(); i++)
+    {
+        Ptr<Node> node = m_switches.Get(i);
+        if (!m_switch.fast)
+        {
+            bridgehelper.Install(node, m_ports[node->GetId()]);
+            continue;
+        }
+        Ptr<FastSwitchNetDevice> device = CreateObject<FastSwitchNetDevice>();
+        device->SetMtu(m_mtu);
+        device->SetLatency(m_switch.latency);
+        device->SetCutThrough(m_switch.cutThrough);
+        device->SetQueueSize(m_switch.queueSize);
+        node->AddDevice(device);
+        const NetDeviceContainer& ports = m_ports[node->GetId()];
+        for (uint32_t p = 0; p < ports.GetN(); p++)
+        {
+            device->AddPort(ports.Get(p));
+        }
+        const NetDeviceContainer& trunks = m_trunkPorts[node->GetId()];
+        for (uint32_t p = 0; p < trunks.GetN(); p++)
+        {
+            device->AddTrunk(trunks.Get(p));
+        }
+    }
+    // Only needed while wiring
+    m_ports.clear();
+    m_trunkPorts.clear();
+}
+
+void Topology::AssignAddresses(const NetDeviceContainer& devices, uint32_t count)
+{
+    // All endpoints share one subnet, a /16 once a /24 runs out
+    if (count > 65534)
+    {
+        NS_FATAL_ERROR("At most 65534 endpoints fit in 10.0.0.0/16, got " << count);
+    }
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", count > 254 ? "255.255.0.0" : "255.255.255.0");
+    ipv4.Assign(devices);
+}
+
+void Topology::BuildClassic()
+{
+    // Create Nodes, each switch with its endpoints on one rank when split
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        CreateNode(i < 3 ? 0 : 1);
+    }
+    m_isEndpoint = {true, true, false, false, true, true};
+
+    // We categorise nodes into endpoints and bridges. The bridge nodes act as switches
+    // The internet stack is only installed on the endpoints, n2 and n3 simply forward packets from one side
+    // of the subnet to the other.
+    m_endpoints.Add(m_nodes.Get(0));
+    m_endpoints.Add(m_nodes.Get(1));
+    m_endpoints.Add(m_nodes.Get(4));
+    m_endpoints.Add(m_nodes.Get(5));
+
+    m_switches.Add(m_nodes.Get(2));
+    m_switches.Add(m_nodes.Get(3));
+
+    InternetStackHelper internet;
+    internet.Install(m_endpoints);
+
+    // We use CSMA channels to emulate the behaviour of ethernet. This is paired with the installation
+    // of CSMA net devices on all the nodes in the network. These are the devices that grant each node
+    // their unique MAC addresses. We set up channels of three types, one between switches and one between endpoints
+    // and their respective switch. These have latency and bandwidth parameters as described in the network topology.
+
+    // CSMA Channel for Switch 1 System
+    NS_LOG_LOGIC("Setting up Ethernet(CSMA) Channel for Switch 1 (n0, n1, n2)");
+    CsmaHelper csmaSwitch1 = MakeHelper({"10Mbps", MilliSeconds(3)});
+    NetDeviceContainer n0n2 = Link(csmaSwitch1, m_nodes.Get(0), m_nodes.Get(2));
+    NetDeviceContainer n1n2 = Link(csmaSwitch1, m_nodes.Get(1), m_nodes.Get(2));
+
+    // CSMA Channel for Switch 2 System
+    NS_LOG_LOGIC("Setting up Ethernet(CSMA) Channel for Switch 2 (n3, n4, n5)");
+    CsmaHelper csmaSwitch2 = MakeHelper({"10Mbps", MilliSeconds(5)});
+    NetDeviceContainer n4n3 = Link(csmaSwitch2, m_nodes.Get(4), m_nodes.Get(3));
+    NetDeviceContainer n5n3 = Link(csmaSwitch2, m_nodes.Get(5), m_nodes.Get(3));
+
+    // Channel between the switches n2 -- n3
+    LinkTier inter{"1.5Mbps", MilliSeconds(15)};
+    if (m_nodes.Get(2)->GetSystemId() != m_nodes.Get(3)->GetSystemId())
+    {
+        NS_LOG_LOGIC("Setting up point to point trunk between Switches (n2, n3) on different ranks");
+        Trunk(inter, m_nodes.Get(2), m_nodes.Get(3));
+    }
+    else
+    {
+        NS_LOG_LOGIC("Setting up Ethernet(CSMA) Channel between Switches (n2, n3)");
+        CsmaHelper csmaInter = MakeHelper(inter);
+        Link(csmaInter, m_nodes.Get(2), m_nodes.Get(3));
+    }
+
+    // Switch 1 (n2) bridges n0, n1 and the inter switch link, Switch 2 (n3) n4, n5 and the inter switch link
+    InstallBridges();
+
+    // Declare all nodes to be in the same subnet with base 10.0.0.0
+    NetDeviceContainer endpointDevices;
+    endpointDevices.Add(n0n2.Get(0));
+    endpointDevices.Add(n1n2.Get(0));
+    endpointDevices.Add(n4n3.Get(0));
+    endpointDevices.Add(n5n3.Get(0));
+    AssignAddresses(endpointDevices, endpointDevices.GetN());
+
+    m_positions = {Vector(0.0, 0.0, 0), Vector(0.0, 10.0, 0), Vector(2.5, 5.0, 0),
+                   Vector(7.5, 5.0, 0), Vector(10.0, 0.0, 0), Vector(10.0, 10.0, 0)};
+}
+
+void Topology::BuildTree(uint32_t numEndpoints, const std::vector<uint32_t>& fanout, const std::vector<LinkTier>& tiers)
+{
+    NS_ABORT_MSG_IF(numEndpoints < 2, "A tree needs at least 2 endpoints");
+    NS_ABORT_MSG_IF(fanout.empty() || tiers.empty(), "A tree needs at least one fanout and one link tier");
+    for (uint32_t f : fanout)
+    {
+        NS_ABORT_MSG_IF(f < 2, "Fanout must be at least 2");
+    }
+
+    // Endpoints first so their node ids are 0..N-1 and flows can be written against them directly.
+    // Each is simulated by the rank of its leaf switch.
+    for (uint32_t i = 0; i < numEndpoints; i++)
+    {
+        m_endpoints.Add(CreateNode(i / fanout[0]));
+    }
+    m_isEndpoint.assign(numEndpoints, true);
+    m_positions.reserve(numEndpoints * 2);
+    for (uint32_t i = 0; i < numEndpoints; i++)
+    {
+        m_positions.push_back(Vector(i, 0, 0));
+    }
+
+    InternetStackHelper internet;
+    internet.Install(m_endpoints);
+
+    NetDeviceContainer endpointDevices;
+    NodeContainer children = m_endpoints;
+    for (uint32_t tier = 0; tier == 0 || children.GetN() > 1; tier++)
+    {
+        uint32_t fan = fanout[std::min<size_t>(tier, fanout.size() - 1)];
+        const LinkTier& linkTier = tiers[std::min<size_t>(tier, tiers.size() - 1)];
+        CsmaHelper csma = MakeHelper(linkTier);
+        NS_LOG_LOGIC("Tier " << tier << ": " << children.GetN() << " children, fanout " << fan);
+
+        // Leaves go round robin over the ranks, everything above them stays on rank 0
+        NodeContainer parents;
+        for (uint32_t p = 0; p < (children.GetN() + fan - 1) / fan; p++)
+        {
+            parents.Add(CreateNode(tier == 0 ? p : 0));
+        }
+        m_switches.Add(parents);
+        m_isEndpoint.resize(m_isEndpoint.size() + parents.GetN(), false);
+        // Centre each switch over its children
+        double spread = std::max(1.0, numEndpoints / double(parents.GetN()));
+        for (uint32_t p = 0; p < parents.GetN(); p++)
+        {
+            m_positions.push_back(Vector(spread * (p + 0.5), 10.0 * (tier + 1), 0));
+        }
+
+        for (uint32_t c = 0; c < children.GetN(); c++)
+        {
+            Ptr<Node> child = children.Get(c);
+            Ptr<Node> parent = parents.Get(c / fan);
+            if (child->GetSystemId() != parent->GetSystemId())
+            {
+                Trunk(linkTier, child, parent);
+                continue;
+            }
+            NetDeviceContainer devices = Link(csma, child, parent);
+            if (tier == 0)
+            {
+                endpointDevices.Add(devices.Get(0));
+            }
+        }
+        children = parents;
+    }
+    InstallBridges();
+    AssignAddresses(endpointDevices, numEndpoints);
+}
+
+NodeContainer Topology::GetNodes() const
+{
+    return m_nodes;
+}
+
+NodeContainer Topology::GetEndpoints() const
+{
+    return m_endpoints;
+}
+
+NodeContainer Topology::GetSwitches() const
+{
+    return m_switches;
+}
+
+uint32_t Topology::GetNumLinks() const
+{
+    return m_links;
+}
+
+uint32_t Topology::GetNumTrunks() const
+{
+    return m_trunks;
+}
+
+bool Topology::IsLocal(uint32_t nodeId) const
+{
+    return nodeId < m_nodes.GetN() && m_nodes.Get(nodeId)->GetSystemId() == m_rank;
+}
+
+bool Topology::IsEndpoint(uint32_t nodeId) const
+{
+    return nodeId < m_isEndpoint.size() && m_isEndpoint[nodeId];
+}
+
+Vector Topology::GetPosition(uint32_t nodeId) const
+{
+    return nodeId < m_positions.size() ? m_positions[nodeId] : Vector();
+}
+
+void Topology::PrintSwitches(std::ostream& os) const
+{
+    for (uint32_t i = 0; i < m_switches.GetN(); i++)
+    {
+        Ptr<Node> node = m_switches.Get(i);
+        for (uint32_t d = 0; d < node->GetNDevices(); d++)
+        {
+            Ptr<FastSwitchNetDevice> device = DynamicCast<FastSwitchNetDevice>(node->GetDevice(d));
+            if (device)
+            {
+                device->Print(os);
+            }
+        }
+    }
+}
+
+Ptr<NetDevice> Topology::GetEndpointDevice(Ptr<Node> node)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    NS_ABORT_MSG_IF(!ipv4, "Node " << node->GetId() << " is not an endpoint");
+    // Interface 0 is loopback
+    for (uint32_t i = 1; i < ipv4->GetNInterfaces(); i++)
+    {
+        if (ipv4->GetNAddresses(i) > 0)
+        {
+            return ipv4->GetNetDevice(i);
+        }
+    }
+    NS_FATAL_ERROR("Node " << node->GetId() << " has no addressed interface");
+    return nullptr;
+}
+
+Ipv4Address Topology::GetEndpointAddress(Ptr<Node> node)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    NS_ABORT_MSG_IF(!ipv4, "Node " << node->GetId() << " is not an endpoint");
+    for (uint32_t i = 1; i < ipv4->GetNInterfaces(); i++)
+    {
+        if (ipv4->GetNAddresses(i) > 0)
+        {
+            return ipv4->GetAddress(i, 0).GetLocal();
+        }
+    }
+    NS_FATAL_ERROR("Node " << node->GetId() << " has no addressed interface");
+    return Ipv4Address();
+}
+
+}
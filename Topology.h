@@ -0,0 +1,111 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/csma-module.h"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+// Link parameters for one tier of the network. Tier 0 connects endpoints to their leaf
+// switch, tier 1 connects leaves to the switches above them, and so on.
+struct LinkTier
+{
+    std::string rate;   // e.g. "10Mbps"
+    Time delay;         // Propagation delay
+};
+
+// Device forwarding frames between the ports of each switch
+struct SwitchConfig
+{
+    bool fast = false;          // FastSwitchNetDevice instead of BridgeNetDevice
+    Time latency;               // Forwarding latency (fast switch only)
+    bool cutThrough = false;    // Cut-through instead of store-and-forward latency (fast switch only)
+    uint32_t queueSize = 1000;  // Output FIFO frames per port (fast switch only)
+};
+
+// Builds bridged Ethernet (CSMA) networks. Endpoints carry the internet stack and one
+// CSMA device each. Switches are nodes with a BridgeNetDevice over their CSMA ports.
+// Endpoints are created first, so in generated networks their node ids are 0..N-1.
+class Topology {
+    public:
+        Topology();
+
+        // Size of every device DropTailQueue, e.g. "100p"
+        void SetQueueSize(const std::string& queueSize);
+        // MTU of every CSMA device and bridge, the largest IP packet a link carries
+        void SetMtu(uint32_t mtu);
+        // Switch device installed on every switch, BridgeNetDevice by default
+        void SetSwitch(const SwitchConfig& config);
+        // Split the network over ranks switch domain by switch domain, this process simulates rank.
+        // The classic network splits at the n2-n3 link, trees at the uplinks of their leaf switches
+        // (leaves go round robin, higher tiers stay on rank 0). Links between ranks become point
+        // to point trunks between fast switches.
+        void SetRanks(uint32_t rank, uint32_t ranks);
+
+        // The original network: n0, n1 on switch n2, n4, n5 on switch n3, 1.5Mbps between the switches
+        void BuildClassic();
+        // Multi-tier tree: fanout[t] children per switch at tier t (last value repeats), tiers[t] link
+        // parameters per tier (last value repeats). Stops when a tier has a single switch (the root).
+        // With two tiers this is a leaf-spine fabric with one spine. Bridges run no spanning tree,
+        // so the generated network must stay loop free.
+        void BuildTree(uint32_t numEndpoints, const std::vector<uint32_t>& fanout, const std::vector<LinkTier>& tiers);
+
+        NodeContainer GetNodes() const;
+        NodeContainer GetEndpoints() const;
+        NodeContainer GetSwitches() const;
+        uint32_t GetNumLinks() const;
+        // Links between ranks, a subset of GetNumLinks
+        uint32_t GetNumTrunks() const;
+        // Node is simulated by this process
+        bool IsLocal(uint32_t nodeId) const;
+        bool IsEndpoint(uint32_t nodeId) const;
+        // Layout for NetAnim, one (x, y) per node in node id order
+        Vector GetPosition(uint32_t nodeId) const;
+        // Forwarding counters of every fast switch, nothing for bridges
+        void PrintSwitches(std::ostream& os) const;
+
+        // The device an endpoint sends and receives on: the device carrying its IPv4 interface.
+        // Resolved by role, so it does not matter where loopback or other devices sit in the device list.
+        static Ptr<NetDevice> GetEndpointDevice(Ptr<Node> node);
+        static Ipv4Address GetEndpointAddress(Ptr<Node> node);
+
+    private:
+        // CSMA helper for one tier
+        CsmaHelper MakeHelper(const LinkTier& tier) const;
+        // Connect a and b over a point to point CSMA channel, b's end becomes a switch port, and a's if a is a switch
+        NetDeviceContainer Link(CsmaHelper& csma, Ptr<Node> a, Ptr<Node> b);
+        // Connect switches a and b, on different ranks, over a point to point trunk
+        void Trunk(const LinkTier& tier, Ptr<Node> a, Ptr<Node> b);
+        // New node simulated by rank (modulo the number of ranks), appended to m_nodes
+        Ptr<Node> CreateNode(uint32_t rank);
+        // Install a bridge over the collected ports of every switch
+        void InstallBridges();
+        void AssignAddresses(const NetDeviceContainer& devices, uint32_t count);
+
+        std::string m_queueSize;        // DropTailQueue size of every device
+        uint32_t m_mtu;                 // MTU of every device
+        SwitchConfig m_switch;          // Device installed on the switches
+        NodeContainer m_nodes;          // All nodes in id order
+        NodeContainer m_endpoints;      // Nodes with an internet stack
+        NodeContainer m_switches;       // Bridge nodes
+        std::unordered_map<uint32_t, NetDeviceContainer> m_ports;  // Switch node id -> bridge ports
+        std::unordered_map<uint32_t, NetDeviceContainer> m_trunkPorts;  // Switch node id -> trunk ports
+        std::vector<bool> m_isEndpoint; // By node id
+        std::vector<Vector> m_positions;    // By node id
+        uint32_t m_links;               // Channels created
+        uint32_t m_trunks;              // Point to point channels between ranks
+        uint32_t m_rank;                // Rank simulated by this process
+        uint32_t m_ranks;               // Ranks the network is split over
+};
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "TrafficGen.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("TrafficGen");
+
+ArrivalProcess ParseArrivalProcess(const std::string& name)
+{
+    if (name == "constant")
+    {
+        return ArrivalProcess::CONSTANT;
+    }
+    if (name == "poisson")
+    {
+        return ArrivalProcess::POISSON;
+    }
+    if (name == "onoff")
+    {
+        return ArrivalProcess::ONOFF;
+    }
+    if (name == "tbf")
+    {
+        return ArrivalProcess::TOKEN_BUCKET;
+    }
+    NS_FATAL_ERROR("Unknown arrival process '" << name << "', use constant, poisson, onoff or tbf");
+    return ArrivalProcess::CONSTANT;
+}
+
+TrafficGen::TrafficGen()
+{
+    m_enabled = false;
+    m_process = ArrivalProcess::CONSTANT;
+    m_stream = -1;
+    m_meanOn = MilliSeconds(50);
+    m_meanOff = MilliSeconds(50);
+    m_bucketBytes = 64 * 1024;
+    m_queue = QueueSize("100p");
+    m_burstLeft = 1;
+    m_burstEvents = 1;
+    m_next = 0;
+}
+
+void TrafficGen::Setup(DataRate rate, ArrivalProcess process, int64_t stream)
+{
+    NS_ASSERT_MSG(rate.GetBitRate() > 0, "Target rate must be positive");
+    m_enabled = true;
+    m_rate = rate;
+    m_process = process;
+    m_stream = stream;
+}
+
+void TrafficGen::SetOnOff(Time meanOn, Time meanOff)
+{
+    m_meanOn = meanOn;
+    m_meanOff = meanOff;
+}
+
+void TrafficGen::SetBucket(uint32_t bucketBytes, QueueSize queue)
+{
+    m_bucketBytes = bucketBytes;
+    m_queue = queue;
+}
+
+bool TrafficGen::IsEnabled() const
+{
+    return m_enabled;
+}
+
+void TrafficGen::Start(uint32_t bytesPerEvent, uint32_t framesPerEvent)
+{
+    m_exp = CreateObject<ExponentialRandomVariable>();
+    if (m_stream >= 0)
+    {
+        m_exp->SetStream(m_stream);
+    }
+
+    m_eventGap = m_rate.CalculateBytesTxTime(bytesPerEvent);
+    m_onLeft = Seconds(m_exp->GetValue(m_meanOn.GetSeconds(), 0));
+    uint32_t queueEvents = m_queue.GetUnit() == QueueSizeUnit::PACKETS ? m_queue.GetValue() / framesPerEvent
+                                                                       : m_queue.GetValue() / bytesPerEvent;
+    m_burstEvents = std::max<uint32_t>(1, std::min(m_bucketBytes / bytesPerEvent, queueEvents));
+    m_burstLeft = m_burstEvents;
+
+    m_gaps.resize(BLOCK_SIZE);
+    Refill();
+}
+
+Time TrafficGen::Next()
+{
+    if (m_next == m_gaps.size())
+    {
+        Refill();
+    }
+    return m_gaps[m_next++];
+}
+
+// Draw the next block of gaps. All random draws happen here, off the per packet path.
+void TrafficGen::Refill()
+{
+    for (uint32_t i = 0; i < m_gaps.size(); i++)
+    {
+        Time gap;
+        switch (m_process)
+        {
+        case ArrivalProcess::CONSTANT:
+            gap = m_eventGap;
+            break;
+        case ArrivalProcess::POISSON:
+            gap = Seconds(m_exp->GetValue(m_eventGap.GetSeconds(), 0));
+            break;
+        case ArrivalProcess::ONOFF: {
+            // Send at the peak rate while on, so that on average the target rate is met
+            double duty = m_meanOn.GetSeconds() / (m_meanOn.GetSeconds() + m_meanOff.GetSeconds());
+            gap = Seconds(m_eventGap.GetSeconds() * duty);
+            m_onLeft -= gap;
+            if (m_onLeft.IsNegative())
+            {
+                // On period used up, sit out an off period before the next event
+                gap += Seconds(m_exp->GetValue(m_meanOff.GetSeconds(), 0));
+                m_onLeft = Seconds(m_exp->GetValue(m_meanOn.GetSeconds(), 0));
+            }
+            break;
+        }
+        case ArrivalProcess::TOKEN_BUCKET:
+            // Empty a full bucket back to back, then wait until it has refilled at the target rate
+            if (--m_burstLeft == 0)
+            {
+                m_burstLeft = m_burstEvents;
+                gap = m_eventGap * m_burstEvents;
+            }
+            else
+            {
+                gap = Seconds(0);
+            }
+            break;
+        }
+        m_gaps[i] = gap;
+    }
+    m_next = 0;
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef TRAFFIC_GEN_H
+#define TRAFFIC_GEN_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+// Arrival processes supported by the rate based load generator
+enum class ArrivalProcess
+{
+    CONSTANT,       // Fixed spacing at the target rate
+    POISSON,        // Exponential inter-arrival times with the target rate as mean
+    ONOFF,          // Exponential on/off periods, peak rate while on so the mean is the target rate
+    TOKEN_BUCKET,   // Worst case (rate, bucket) conforming source: a full bucket back to back, then wait for refill
+};
+
+// Parse "constant", "poisson", "onoff" or "tbf", aborts on anything else
+ArrivalProcess ParseArrivalProcess(const std::string& name);
+
+// Generates send event inter-arrival times for a target offered load. Gaps are drawn
+// from seeded ns-3 random streams in blocks ahead of time, so the send path only reads
+// the next precomputed value.
+class TrafficGen {
+    public:
+        TrafficGen();
+
+        // rate is the target offered load, stream the random stream index for this flow
+        void Setup(DataRate rate, ArrivalProcess process, int64_t stream);
+        // Mean on/off period lengths, used by ONOFF
+        void SetOnOff(Time meanOn, Time meanOff);
+        // Bucket depth in bytes, used by TOKEN_BUCKET. Capped at what the sender's device queue
+        // holds, a full bucket sent back to back would otherwise be refused by its own device.
+        void SetBucket(uint32_t bucketBytes, QueueSize queue);
+
+        // Reset the generator, one send event puts framesPerEvent frames of bytesPerEvent in total on the wire
+        void Start(uint32_t bytesPerEvent, uint32_t framesPerEvent);
+        // Gap to the next send event
+        Time Next();
+
+        bool IsEnabled() const;
+
+    private:
+        void Refill();
+
+        static const uint32_t BLOCK_SIZE = 4096;    // Gaps precomputed per refill
+
+        bool m_enabled;             // A target rate has been configured
+        DataRate m_rate;            // Target offered load
+        ArrivalProcess m_process;   // Arrival process
+        int64_t m_stream;           // Random stream index assigned to this flow
+        Time m_meanOn;              // Mean on period (ONOFF)
+        Time m_meanOff;             // Mean off period (ONOFF)
+        uint32_t m_bucketBytes;     // Token bucket depth (TOKEN_BUCKET)
+        QueueSize m_queue;          // Sender's device queue, limits the bucket (TOKEN_BUCKET)
+
+        Time m_eventGap;            // Gap between events at exactly the target rate
+        Time m_onLeft;              // Time left in the current on period (ONOFF)
+        uint32_t m_burstLeft;       // Events left in the current bucket burst (TOKEN_BUCKET)
+        uint32_t m_burstEvents;     // Events that fit into a full bucket (TOKEN_BUCKET)
+
+        std::vector<Time> m_gaps;   // Precomputed gaps
+        uint32_t m_next;            // Next gap to hand out
+
+        Ptr<ExponentialRandomVariable> m_exp;   // Poisson gaps and on/off periods
+};
+
+}
+
+#endif
@@ -12,13 +12,30 @@
 #include "ns3/bridge-module.h"
 #include "ns3/log.h"
 #include "RawApp.h"
+#include "TrafficGen.h"
+#include "FlowStats.h"
+#include "DropStats.h"
+#include "LinkMonitor.h"
+#include "SampledPcap.h"
+#include "Topology.h"
+#include "Scenario.h"
+#include "PcapReplay.h"
+#include "RxCoalescing.h"
+#include "EventLog.h"
+#include "HopMonitor.h"
+#include "Distributed.h"
+#include "Emulation.h"
 #include <unordered_set>
+#include <algorithm>
 #include "ns3/pyviz.h"
 #include "external/popl.hpp"
 #include "ns3/netanim-module.h"
 #include "ns3/mobility-module.h"
 #include <map>
 #include <fstream>
+#include <chrono>
+#include <memory>
+#include <sys/resource.h>
 #include "ns3/drop-tail-queue.h"
 
 /*
@@ -47,86 +64,100 @@ std::vector<T> parse(const std::string &input)
     while (stream >> value)
     {
         T val;
-        if (std::is_same<T, int>())
+        if constexpr (std::is_same<T, int>())
         {
             val = std::stoi(value);
         }
-        else if (std::is_same<T, double>())
+        else if constexpr (std::is_same<T, double>())
         {
             val = std::stod(value);
         }
+        else
+        {
+            val = value;
+        }
         output.push_back(val);
     }
 
     return output;
 }
 
-struct runConfig
+// How much tracing a run pays for, each level includes everything below it
+enum TraceLevel
 {
-    double interval;
-    double start;
-    int numPkts;
-    int pktSize;
-    Ptr<Node> src;
-    Ptr<Node> dst;
+    TRACE_NONE,         // Flow statistics only
+    TRACE_COUNTERS,     // Plus drop counters and queue/link monitoring
+    TRACE_SAMPLED,      // Plus binary drop log and 1-in-N pcap capture at the endpoints
+    TRACE_FULL,         // Plus packet metadata, full pcap capture and NetAnim XML
 };
 
-static std::map<uint32_t, uint32_t> nodeDropCounts;
-static std::ofstream dropLogFile;
-
-static void PacketDropCallback(uint32_t nodeId, Ptr<const Packet> pkt)
+static bool ParseTraceLevel(const std::string& name, TraceLevel& level)
 {
-    nodeDropCounts[nodeId]++;
-    dropLogFile << Simulator::Now().GetSeconds() << "\t" << nodeId << "\t" << nodeDropCounts[nodeId] << std::endl;
-    NS_LOG_UNCOND("Node " << nodeId << " dropped packet at time " << Simulator::Now().GetSeconds() << "s. Total drops at node: " << nodeDropCounts[nodeId]);
+    static const std::map<std::string, TraceLevel> levels = {
+        {"none", TRACE_NONE}, {"counters", TRACE_COUNTERS}, {"sampled", TRACE_SAMPLED}, {"full", TRACE_FULL}};
+    auto it = levels.find(name);
+    if (it == levels.end())
+    {
+        return false;
+    }
+    level = it->second;
+    return true;
 }
 
-static void DropCallback(std::string context, Ptr<const Packet> pkt)
+static bool ParseEventLogMode(const std::string& name, EventLogMode& mode)
 {
-    // Extract node ID from the trace path context
-    // Context looks like: "/NodeList/2/DeviceList/0/$ns3::CsmaNetDevice/MacTxDrop"
-    size_t nodeStart = context.find("/NodeList/") + 10;
-    size_t nodeEnd = context.find("/", nodeStart);
-    uint32_t nodeId = std::stoi(context.substr(nodeStart, nodeEnd - nodeStart));
-
-    PacketDropCallback(nodeId, pkt);
+    static const std::map<std::string, EventLogMode> modes = {
+        {"quiet", EVENTS_QUIET}, {"text", EVENTS_TEXT}, {"binary", EVENTS_BINARY}};
+    auto it = modes.find(name);
+    if (it == modes.end())
+    {
+        return false;
+    }
+    mode = it->second;
+    return true;
 }
 
-void SetupDropTrack()
+// ns-3 event queue implementations, the fastest one depends on the event mix
+static bool ParseScheduler(const std::string& name, std::string& typeId)
 {
-    for (int i = 0; i < 6; i++)
+    static const std::map<std::string, std::string> schedulers = {
+        {"map", "ns3::MapScheduler"}, {"heap", "ns3::HeapScheduler"}, {"calendar", "ns3::CalendarScheduler"},
+        {"list", "ns3::ListScheduler"}, {"priority", "ns3::PriorityQueueScheduler"}};
+    auto it = schedulers.find(name);
+    if (it == schedulers.end())
     {
-        nodeDropCounts[i] = 0;
+        return false;
     }
+    typeId = it->second;
+    return true;
+}
 
-    dropLogFile.open("node-drops.dat");
-    dropLogFile << "# Time(s)\tNodeID\tCumulativeDrops" << std::endl;
-
-    for (uint32_t i = 0; i < 6; i++)
+// Output file of this rank, e.g. link-samples.csv becomes link-samples-r1.csv, unchanged when not distributed
+static std::string RankPath(const std::string& path)
+{
+    if (Distributed::Get().GetSize() < 2)
     {
-        std::ostringstream oss;
-        oss << "/NodeList/" << i << "/DeviceList/*/$ns3::CsmaNetDevice/MacTxDrop";
-        Config::ConnectWithoutContext(oss.str(),
-                                      MakeBoundCallback(&PacketDropCallback, i));
-
-        oss.str("");
-        oss << "/NodeList/" << i << "/DeviceList/*/$ns3::CsmaNetDevice/PhyTxDrop";
-        Config::ConnectWithoutContext(oss.str(),
-                                      MakeBoundCallback(&PacketDropCallback, i));
+        return path;
     }
+    std::string suffix = "-r" + std::to_string(Distributed::Get().GetRank());
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
 }
 
-std::vector<uint8_t> StringToByteArray(const std::string& input) {
-    std::vector<uint8_t> byteArray;
-    std::istringstream stream(input);
-
-    unsigned int byte;
-    while (stream >> std::hex >> byte) {
-        byteArray.push_back(static_cast<uint8_t>(byte));
+// Shuts MPI down when main returns, after everything declared later is gone. Does nothing
+// unless --distributed enabled it.
+struct DistributedGuard
+{
+    ~DistributedGuard()
+    {
+        Distributed::Get().Disable();
     }
-
-    return byteArray;
-}
+};
 
 int main(int argc, char *argv[])
 {
@@ -140,7 +171,69 @@ int main(int argc, char *argv[])
     auto intervalOpt = op.add<popl::Value<std::string>>("l", "interval", "String (double): Space separated floats indicating the interval between packet sends (s)", "1.0");
     auto simEndOpt = op.add<popl::Value<double>>("e", "simEnd", "double: end time for the simulation", 10.0);
     auto helpOpt = op.add<popl::Switch>("h", "help", "Print this help message");
-    auto rawEnableOpt = op.add<popl::Value<bool>>("y", "enableByte", "Bool: Turn on byte array sending", false);
+    auto rawEnableOpt = op.add<popl::Value<bool>>("y", "enableByte", "Bool: Turn on byte array sending, of the built in test frame unless --frame or --frameFile is given", false);
+    auto frameOpt = op.add<popl::Value<std::string>>("", "frame", "String: Ethernet frame to send as hex bytes, implies --enableByte", "");
+    auto frameFileOpt = op.add<popl::Value<std::string>>("", "frameFile", "String: file holding the Ethernet frame to send, raw or as hex text, implies --enableByte", "");
+    auto framePatchOpt = op.add<popl::Value<std::string>>("", "framePatch", "String: comma separated frame fields written per packet (seq@OFFSET[:2|4], ipid) or once (len, csum)", "");
+    auto burstOpt = op.add<popl::Value<std::string>>("b", "burst", "String (int): Space separated integers indicating the number of packets enqueued back to back per send event", "1");
+    auto burstGapOpt = op.add<popl::Value<std::string>>("g", "burstGap", "String (double): Space separated floats indicating the time between bursts (s), 0 keeps the average rate of one packet per interval", "0");
+    auto rateOpt = op.add<popl::Value<std::string>>("r", "rate", "String: Space separated target offered loads (e.g. 12Mbps) replacing --interval, counted in whole Ethernet frames", "");
+    auto arrivalOpt = op.add<popl::Value<std::string>>("a", "arrival", "String: Space separated arrival processes for --rate: constant, poisson, onoff or tbf", "constant");
+    auto meanOnOpt = op.add<popl::Value<double>>("", "meanOn", "double: mean on period for the onoff arrival process (s)", 0.05);
+    auto meanOffOpt = op.add<popl::Value<double>>("", "meanOff", "double: mean off period for the onoff arrival process (s)", 0.05);
+    auto bucketOpt = op.add<popl::Value<int>>("", "bucket", "int: token bucket depth for the tbf arrival process (bytes), capped at the device queue", 65536);
+    auto rngRunOpt = op.add<popl::Value<int>>("", "rngRun", "int: run number for the seeded random streams", 1);
+    auto echoOpt = op.add<popl::Value<bool>>("", "echo", "Bool: Receivers reflect packets back at L2 and senders measure round-trip times", false);
+    auto linkSampleOpt = op.add<popl::Value<double>>("", "linkSample", "double: period for sampling queue depth and link utilization into link-samples.csv (s), 0 disables", 0.0);
+    auto linkSlotsOpt = op.add<popl::Value<int>>("", "linkSampleSlots", "int: samples kept per device, older samples are overwritten", 4096);
+    auto queueSizeOpt = op.add<popl::Value<std::string>>("", "queueSize", "String: size of every device DropTailQueue, e.g. 100p or 64000B", "100p");
+    auto schedulerOpt = op.add<popl::Value<std::string>>("", "scheduler", "String: simulator event queue, one of map, heap, calendar, list or priority", "map");
+    auto statsOutOpt = op.add<popl::Value<std::string>>("", "statsOut", "String: file to write run totals to as key value lines, for sweep scripts", "");
+    auto traceOpt = op.add<popl::Value<std::string>>("", "trace", "String: trace level, one of none, counters, sampled or full", "counters");
+    auto eventLogOpt = op.add<popl::Value<std::string>>("", "eventLog", "String: per packet send/receive events, text (a log line each), binary (records written to --eventFile by a background thread) or quiet (counters only)", "text");
+    auto eventFileOpt = op.add<popl::Value<std::string>>("", "eventFile", "String: binary event log written with --eventLog=binary, see the eventdump tool", "events.bin");
+    auto eventRingOpt = op.add<popl::Value<int>>("", "eventRing", "int: event records buffered in memory for the writer thread with --eventLog=binary", 1 << 20);
+    auto hopMonitorOpt = op.add<popl::Value<bool>>("", "hopMonitor", "Bool: tag frames and break each flow's delay down by hop (queueing and transmission at every device on the path)", false);
+    auto hopFileOpt = op.add<popl::Value<std::string>>("", "hopFile", "String: columnar table the per hop statistics are written to with --hopMonitor, see the colcsv tool", "hop-stats.col");
+    auto sampleNOpt = op.add<popl::Value<int>>("", "sampleN", "int: capture 1 in N frames at trace level sampled", 100);
+    auto snapLenOpt = op.add<popl::Value<int>>("", "snaplen", "int: bytes kept per captured frame at trace level sampled", 96);
+    auto scenarioOpt = op.add<popl::Value<std::string>>("", "scenario", "String: scenario file with one flow per entry (text or binary), replaces the per flow options above", "");
+    auto lookaheadOpt = op.add<popl::Value<double>>("", "lookahead", "double: flows are created this long before their start time (s)", 1.0);
+    auto lingerOpt = op.add<popl::Value<double>>("", "linger", "double: flows are released this long after their last send, for frames still in flight (s)", 1.0);
+    auto printFlowsOpt = op.add<popl::Value<int>>("", "printFlows", "int: flows listed individually in the report at the end of the run", 100);
+    auto replayOpt = op.add<popl::Value<std::string>>("", "replay", "String: pcap or pcapng capture to replay through the network instead of the per flow options above", "");
+    auto replaySpeedOpt = op.add<popl::Value<double>>("", "replaySpeed", "double: replay speed relative to the capture timing", 1.0);
+    auto replayStartOpt = op.add<popl::Value<double>>("", "replayStart", "double: simulation time of the first replayed frame (s)", 1.0);
+    auto replayWindowOpt = op.add<popl::Value<int>>("", "replayWindow", "int: MB of the capture memory-mapped at a time", 64);
+    auto topoOpt = op.add<popl::Value<std::string>>("", "topo", "String: network to build, classic (the network above) or tree", "classic");
+    auto endpointsOpt = op.add<popl::Value<int>>("", "endpoints", "int: number of endpoints for --topo=tree, these are nodes 0..N-1", 16);
+    auto fanoutOpt = op.add<popl::Value<std::string>>("", "fanout", "String (int): Space separated children per switch for each tier of --topo=tree, the last value repeats", "4");
+    auto tierRateOpt = op.add<popl::Value<std::string>>("", "tierRate", "String: Space separated link rates for each tier of --topo=tree, endpoint links first, the last value repeats", "10Mbps 100Mbps");
+    auto tierDelayOpt = op.add<popl::Value<std::string>>("", "tierDelay", "String: Space separated link delays for each tier of --topo=tree (e.g. 3ms), the last value repeats", "3ms 1ms");
+    auto switchOpt = op.add<popl::Value<std::string>>("", "switch", "String: switch device, bridge (ns-3 BridgeNetDevice) or fast (flat MAC table, per port output FIFOs)", "bridge");
+    auto switchLatencyOpt = op.add<popl::Value<std::string>>("", "switchLatency", "String: forwarding latency of a fast switch, e.g. 500ns", "0ns");
+    auto cutThroughOpt = op.add<popl::Value<bool>>("", "cutThrough", "Bool: fast switches forward cut-through, overlapping the latency with receiving the frame", false);
+    auto switchQueueOpt = op.add<popl::Value<int>>("", "switchQueue", "int: frames each fast switch port holds while they wait out the latency", 1000);
+    auto fastPathOpt = op.add<popl::Value<bool>>("f", "fastPath", "Bool: Send from prebuilt per-flow header templates instead of rebuilding headers per packet", true);
+    auto mtuOpt = op.add<popl::Value<int>>("", "mtu", "int: MTU of every link (bytes), packets larger than this need --gso", 1500);
+    auto gsoOpt = op.add<popl::Value<bool>>("", "gso", "Bool: --pktSize is a message of up to 64 KB, split into MTU sized frames and reassembled by the receiver", false);
+    auto rxRingOpt = op.add<popl::Value<int>>("", "rxRing", "int: frames each endpoint's receive ring holds, enables NAPI style batched receive processing, 0 disables", 0);
+    auto rxFramesOpt = op.add<popl::Value<int>>("", "rxFrames", "int: receive interrupt fires once this many frames wait in the ring", 32);
+    auto rxTimeoutOpt = op.add<popl::Value<std::string>>("", "rxTimeout", "String: receive interrupt also fires once the oldest waiting frame is this old, e.g. 50us", "50us");
+    auto rxBudgetOpt = op.add<popl::Value<int>>("", "rxBudget", "int: frames processed per receive poll", 64);
+    auto rxBatchCostOpt = op.add<popl::Value<std::string>>("", "rxBatchCost", "String: receiver processing time per poll, e.g. 2us", "2us");
+    auto rxFrameCostOpt = op.add<popl::Value<std::string>>("", "rxFrameCost", "String: receiver processing time per frame, e.g. 200ns", "200ns");
+    auto reasmSlotsOpt = op.add<popl::Value<int>>("", "reasmSlots", "int: messages each receiver reassembles at once with --gso, older incomplete ones are dropped", 16);
+    auto realtimeOpt = op.add<popl::Value<bool>>("", "realtime", "Bool: run against the wall clock (RealtimeSimulatorImpl) and report how far the simulation falls behind", false);
+    auto rtProbeOpt = op.add<popl::Value<std::string>>("", "rtProbe", "String: period of the real time lag probe, e.g. 1ms", "1ms");
+    auto rtDeadlineOpt = op.add<popl::Value<std::string>>("", "rtDeadline", "String: lag beyond which a probe counts as a missed deadline, e.g. 1ms", "1ms");
+    auto emulateOpt = op.add<popl::Value<std::string>>("", "emulate", "String: Space separated endpoints bridged to a socketpair with a frame generator (N), or to a local tap/veth interface (N=ifname), implies --realtime", "");
+    auto emuRateOpt = op.add<popl::Value<double>>("", "emuRate", "double: frames/s each --emulate generator sends in its first step", 1000.0);
+    auto emuRampOpt = op.add<popl::Value<double>>("", "emuRamp", "double: generator rate factor from one step to the next, 1 keeps the rate", 2.0);
+    auto emuStepOpt = op.add<popl::Value<double>>("", "emuStep", "double: length of a generator rate step (s), steps run until --linger before --simEnd", 1.0);
+    auto emuStartOpt = op.add<popl::Value<double>>("", "emuStart", "double: simulation time the generators start at (s)", 1.0);
+    auto emuFrameSizeOpt = op.add<popl::Value<int>>("", "emuFrameSize", "int: size of the generated Ethernet frames (bytes)", 128);
+    auto distributedOpt = op.add<popl::Value<bool>>("", "distributed", "Bool: split the network over MPI ranks at the switches, run under mpirun with --switch=fast", false);
 
     try
     {
@@ -158,12 +251,130 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    TraceLevel traceLevel;
+    if (!ParseTraceLevel(traceOpt->value(), traceLevel))
+    {
+        std::cout << "ERROR: --trace must be one of none, counters, sampled or full" << std::endl;
+        return 1;
+    }
+
+    EventLogMode eventLogMode;
+    if (!ParseEventLogMode(eventLogOpt->value(), eventLogMode))
+    {
+        std::cout << "ERROR: --eventLog must be one of text, binary or quiet" << std::endl;
+        return 1;
+    }
+
+    if (mtuOpt->value() < 68 || mtuOpt->value() > 9000)
+    {
+        std::cout << "ERROR: --mtu must be between 68 and 9000" << std::endl;
+        return 1;
+    }
+    bool rawFrames = !frameOpt->value().empty() || !frameFileOpt->value().empty() || rawEnableOpt->value();
+    if (gsoOpt->value())
+    {
+        if (rawFrames || echoOpt->value())
+        {
+            std::cout << "ERROR: --gso can not be combined with raw frames or --echo" << std::endl;
+            return 1;
+        }
+        if (mtuOpt->value() <= static_cast<int>(RawApp::SEGMENT_OVERHEAD) || reasmSlotsOpt->value() < 1)
+        {
+            std::cout << "ERROR: --gso needs an MTU above " << RawApp::SEGMENT_OVERHEAD << " bytes and at least one reassembly slot" << std::endl;
+            return 1;
+        }
+    }
+
+    if (rxRingOpt->value() < 0 || (rxRingOpt->value() > 0 && (rxFramesOpt->value() < 1 || rxBudgetOpt->value() < 1)))
+    {
+        std::cout << "ERROR: --rxRing must not be negative, --rxFrames and --rxBudget must be at least 1" << std::endl;
+        return 1;
+    }
+
+    if (switchOpt->value() != "bridge" && switchOpt->value() != "fast")
+    {
+        std::cout << "ERROR: --switch must be bridge or fast" << std::endl;
+        return 1;
+    }
+
+    // The real time simulator is selected like the distributed one, before the scheduler is set
+    if (realtimeOpt->value() || !emulateOpt->value().empty())
+    {
+        if (distributedOpt->value())
+        {
+            std::cout << "ERROR: --realtime and --emulate can not be combined with --distributed" << std::endl;
+            return 1;
+        }
+        EmulationConfig emulation;
+        emulation.probe = Time(rtProbeOpt->value());
+        emulation.deadline = Time(rtDeadlineOpt->value());
+        emulation.start = Seconds(emuStartOpt->value());
+        emulation.step = Seconds(emuStepOpt->value());
+        emulation.rate = emuRateOpt->value();
+        emulation.ramp = emuRampOpt->value();
+        emulation.frameSize = emuFrameSizeOpt->value();
+        double window = simEndOpt->value() - lingerOpt->value() - emuStartOpt->value();
+        if (emulation.probe.IsZero() || emuStepOpt->value() <= 0 || emuRateOpt->value() <= 0 || emuRampOpt->value() < 1 ||
+            emuFrameSizeOpt->value() < 60 || emuFrameSizeOpt->value() > mtuOpt->value() + 14 ||
+            (!emulateOpt->value().empty() && window < emuStepOpt->value()))
+        {
+            std::cout << "ERROR: --rtProbe, --emuStep and --emuRate must be positive, --emuRamp at least 1, --emuFrameSize between 60 bytes and the MTU plus 14, "
+                      << "and --simEnd must leave --emuStart, one --emuStep and --linger" << std::endl;
+            return 1;
+        }
+        if (!emulateOpt->value().empty())
+        {
+            // Checked above: the window holds at least one step and the step is positive. Clamped
+            // as a double, a huge quotient does not fit in 32 bits.
+            emulation.steps = static_cast<uint32_t>(std::min<double>(window / emuStepOpt->value(), Emulation::MAX_STEPS));
+        }
+        Emulation::Get().Enable(emulation);
+        if (traceLevel > TRACE_NONE || eventLogMode != EVENTS_QUIET)
+        {
+            std::cout << "Note: tracing slows the simulation down, measure the sustainable rate with --trace=none --eventLog=quiet" << std::endl;
+        }
+    }
+
+    std::string schedulerType;
+    if (!ParseScheduler(schedulerOpt->value(), schedulerType))
+    {
+        std::cout << "ERROR: --scheduler must be one of map, heap, calendar, list or priority" << std::endl;
+        return 1;
+    }
+
+    // MPI must be up before the simulator is created, i.e. before the scheduler is set. The
+    // options are checked before, from here on every return shuts MPI down through the guard.
+    DistributedGuard distributedGuard;
+    if (distributedOpt->value())
+    {
+        std::string error;
+        if (!Distributed::Get().Enable(&argc, &argv, error))
+        {
+            std::cout << "ERROR: --distributed: " << error << std::endl;
+            return 1;
+        }
+        if (Distributed::Get().GetSize() > 1 && (switchOpt->value() != "fast" || traceLevel == TRACE_FULL || !replayOpt->value().empty()))
+        {
+            std::cout << "ERROR: --distributed needs --switch=fast and can not be combined with --trace=full or --replay" << std::endl;
+            return 1;
+        }
+    }
+    bool isRoot = Distributed::Get().IsRoot();
+
+    ObjectFactory schedulerFactory;
+    schedulerFactory.SetTypeId(schedulerType);
+    Simulator::SetScheduler(schedulerFactory);
+
     std::vector<int> initiatorVec = parse<int>(initiatorOpt->value());
     std::vector<int> targetVec = parse<int>(targetOpt->value());
     std::vector<double> startVec = parse<double>(startOpt->value());
     std::vector<int> numPktsVec = parse<int>(numPktsOpt->value());
     std::vector<int> pktSizeVec = parse<int>(pktSizeOpt->value());
     std::vector<double> intervalVec = parse<double>(intervalOpt->value());
+    std::vector<int> burstVec = parse<int>(burstOpt->value());
+    std::vector<double> burstGapVec = parse<double>(burstGapOpt->value());
+    std::vector<std::string> rateVec = parse<std::string>(rateOpt->value());
+    std::vector<std::string> arrivalVec = parse<std::string>(arrivalOpt->value());
 
     int numConfigs = initiatorVec.size();
     if (targetVec.size() != numConfigs)
@@ -171,25 +382,6 @@ int main(int argc, char *argv[])
         std::cout << "ERROR: Make sure the number of targets match the number of initiators" << std::endl;
         return 1;
     }
-    std::unordered_set allowed = {0, 1, 4, 5};
-    for (int i = 0; i < numConfigs; i++)
-    {
-        for (int num : initiatorVec)
-        {
-            if (allowed.find(num) == allowed.end())
-            {
-                std::cout << "ERROR: Only 0, 1, 4, 5 can be initiators or targets" << std::endl;
-            }
-        }
-        for (int num : targetVec)
-        {
-            if (allowed.find(num) == allowed.end())
-            {
-                std::cout << "ERROR: Only 0, 1, 4, 5 can be initiators or targets" << std::endl;
-                return 1;
-            }
-        }
-    }
     if (startVec.size() != numConfigs)
     {
         for (int i = 0; i < (numConfigs - startVec.size()); i++)
@@ -218,156 +410,410 @@ int main(int argc, char *argv[])
             intervalVec.push_back(1.0);
         }
     }
+    while (burstVec.size() < numConfigs)
+    {
+        burstVec.push_back(1);
+    }
+    while (burstGapVec.size() < numConfigs)
+    {
+        burstGapVec.push_back(0.0);
+    }
+    // Flows without a rate keep using their fixed interval
+    while (rateVec.size() < numConfigs)
+    {
+        rateVec.push_back("");
+    }
+    while (arrivalVec.size() < numConfigs)
+    {
+        arrivalVec.push_back(arrivalVec.empty() ? "constant" : arrivalVec.back());
+    }
 
     Time::SetResolution(Time::NS);
+    RngSeedManager::SetRun(rngRunOpt->value());
     // Log component enable
 
-    // Create Nodes
-    NodeContainer nodes, endpoints, bridges;
-    nodes.Create(6);
+    // Build the network, timed so setup cost can be tracked as node counts grow
+    auto setupStart = std::chrono::steady_clock::now();
+    struct rusage setupUsage;
+    getrusage(RUSAGE_SELF, &setupUsage);
+    long setupRssBefore = setupUsage.ru_maxrss;
+
+    Topology topology;
+    topology.SetQueueSize(queueSizeOpt->value());
+    topology.SetMtu(mtuOpt->value());
+    SwitchConfig switchConfig;
+    switchConfig.fast = switchOpt->value() == "fast";
+    switchConfig.latency = Time(switchLatencyOpt->value());
+    switchConfig.cutThrough = cutThroughOpt->value();
+    switchConfig.queueSize = std::max(switchQueueOpt->value(), 1);
+    topology.SetSwitch(switchConfig);
+    topology.SetRanks(Distributed::Get().GetRank(), Distributed::Get().GetSize());
+    if (topoOpt->value() == "classic")
+    {
+        topology.BuildClassic();
+    }
+    else if (topoOpt->value() == "tree")
+    {
+        std::vector<int> fanoutVec = parse<int>(fanoutOpt->value());
+        std::vector<std::string> tierRateVec = parse<std::string>(tierRateOpt->value());
+        std::vector<std::string> tierDelayVec = parse<std::string>(tierDelayOpt->value());
+        if (endpointsOpt->value() < 2 || fanoutVec.empty() || tierRateVec.empty() || tierDelayVec.empty() ||
+            std::any_of(fanoutVec.begin(), fanoutVec.end(), [](int f) { return f < 2; }))
+        {
+            std::cout << "ERROR: --topo=tree needs at least 2 endpoints, fanouts of at least 2 and a rate and delay per tier" << std::endl;
+            return 1;
+        }
+        std::vector<LinkTier> tiers;
+        for (size_t t = 0; t < std::max(tierRateVec.size(), tierDelayVec.size()); t++)
+        {
+            tiers.push_back({tierRateVec[std::min(t, tierRateVec.size() - 1)],
+                             Time(tierDelayVec[std::min(t, tierDelayVec.size() - 1)])});
+        }
+        topology.BuildTree(endpointsOpt->value(), std::vector<uint32_t>(fanoutVec.begin(), fanoutVec.end()), tiers);
+    }
+    else
+    {
+        std::cout << "ERROR: --topo must be classic or tree" << std::endl;
+        return 1;
+    }
+    NodeContainer nodes = topology.GetNodes();
 
     // GlobalValue::Bind("SimulatorImplementationType", ns3::StringValue("ns3::VisualSimulatorImpl"));
     MobilityHelper mobility;
     mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
     mobility.Install(nodes);
 
-    struct runConfig configs[numConfigs];
-    for (int i = 0; i < numConfigs; i++)
+    std::chrono::duration<double> setupWall = std::chrono::steady_clock::now() - setupStart;
+    getrusage(RUSAGE_SELF, &setupUsage);
+    long setupRssKb = setupUsage.ru_maxrss - setupRssBefore;
+    std::cout << "Built " << topoOpt->value() << " topology with " << switchOpt->value() << " switches: " << nodes.GetN() << " nodes ("
+              << topology.GetEndpoints().GetN() << " endpoints, " << topology.GetSwitches().GetN() << " switches, "
+              << topology.GetNumLinks() << " links) in " << setupWall.count() << "s, RSS +" << setupRssKb / 1024.0 << " MB" << std::endl;
+    if (Distributed::Get().GetSize() > 1)
+    {
+        std::cout << "Rank " << Distributed::Get().GetRank() << " of " << Distributed::Get().GetSize() << ", "
+                  << topology.GetNumTrunks() << " trunks between ranks" << std::endl;
+    }
+
+    // Endpoints bridged to the outside, a generator thread each on socketpairs
+    for (const std::string& entry : parse<std::string>(emulateOpt->value()))
+    {
+        size_t eq = entry.find('=');
+        std::string node = entry.substr(0, eq);
+        if (node.empty() || node.find_first_not_of("0123456789") != std::string::npos || node.size() > 9 ||
+            eq + 1 == entry.size())
+        {
+            std::cout << "ERROR: --emulate entry " << entry << " must be N or N=ifname with N an endpoint" << std::endl;
+            return 1;
+        }
+        uint32_t num = std::stoul(node);
+        if (!topology.IsEndpoint(num))
+        {
+            std::cout << "ERROR: Node " << num << " is not an endpoint and can not be emulated" << std::endl;
+            return 1;
+        }
+        std::string error;
+        if (!Emulation::Get().Attach(nodes.Get(num), eq == std::string::npos ? "" : entry.substr(eq + 1), error))
+        {
+            std::cout << "ERROR: --emulate: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    // Flows from the command line are small enough to hold in memory, scenario files are streamed
+    ScenarioReader reader;
+    if (!scenarioOpt->value().empty())
     {
-        configs[i].src = nodes.Get(initiatorVec[i]);
-        configs[i].dst = nodes.Get(targetVec[i]);
-        configs[i].interval = intervalVec[i];
-        configs[i].numPkts = numPktsVec[i];
-        configs[i].pktSize = pktSizeVec[i];
-        configs[i].start = startVec[i];
+        if (!reader.Open(scenarioOpt->value()))
+        {
+            std::cout << "ERROR: Could not open scenario file " << scenarioOpt->value() << std::endl;
+            return 1;
+        }
+    }
+    else if (!replayOpt->value().empty())
+    {
+        // The capture replaces the command line flows
+        reader.SetFlows({});
+    }
+    else
+    {
+        // Only endpoints carry the internet stack, switches can not send or receive
+        for (int num : initiatorVec)
+        {
+            if (!topology.IsEndpoint(num))
+            {
+                std::cout << "ERROR: Node " << num << " is not an endpoint and can not be an initiator" << std::endl;
+                return 1;
+            }
+        }
+        for (int num : targetVec)
+        {
+            if (!topology.IsEndpoint(num))
+            {
+                std::cout << "ERROR: Node " << num << " is not an endpoint and can not be a target" << std::endl;
+                return 1;
+            }
+        }
+
+        // IPv4 and UDP headers count against the MTU, messages are split to fit it
+        for (int size : pktSizeVec)
+        {
+            if (gsoOpt->value() && size > static_cast<int>(RawApp::MAX_MESSAGE))
+            {
+                std::cout << "ERROR: Messages are limited to " << RawApp::MAX_MESSAGE << " bytes, got " << size << std::endl;
+                return 1;
+            }
+            if (gsoOpt->value() && RawApp::SegmentCount(size, mtuOpt->value()) > SegmentInfo::MAX_SEGMENTS)
+            {
+                std::cout << "ERROR: Messages of " << size << " bytes need more than " << SegmentInfo::MAX_SEGMENTS
+                          << " segments at a " << mtuOpt->value() << " byte MTU, raise --mtu" << std::endl;
+                return 1;
+            }
+            if (!gsoOpt->value() && !rawFrames && size + 28 > mtuOpt->value())
+            {
+                std::cout << "ERROR: Packets of " << size << " bytes exceed the " << mtuOpt->value() << " byte MTU, use --gso to send them as messages" << std::endl;
+                return 1;
+            }
+        }
+
+        std::vector<FlowSpec> flows(numConfigs);
+        for (int i = 0; i < numConfigs; i++)
+        {
+            flows[i].src = initiatorVec[i];
+            flows[i].dst = targetVec[i];
+            flows[i].interval = intervalVec[i];
+            flows[i].numPkts = numPktsVec[i];
+            flows[i].pktSize = pktSizeVec[i];
+            flows[i].start = startVec[i];
+            flows[i].burst = burstVec[i];
+            flows[i].burstGap = burstGapVec[i];
+            if (!rateVec[i].empty())
+            {
+                flows[i].rateBps = DataRate(rateVec[i]).GetBitRate();
+                flows[i].arrival = static_cast<uint8_t>(ParseArrivalProcess(arrivalVec[i]));
+            }
+        }
+        reader.SetFlows(std::move(flows));
     }
 
     LogComponentEnable("UDPTestScript", LOG_LEVEL_LOGIC);
 
-    // We categorise nodes into endpoints and bridges. The bridge nodes act as switches
-    // The internet stack is only installed on the endpoints, n2 and n3 simply forward packets from one side
-    // of the subnet to the other.
-    endpoints.Add(nodes.Get(0));
-    endpoints.Add(nodes.Get(1));
-    endpoints.Add(nodes.Get(4));
-    endpoints.Add(nodes.Get(5));
-
-    bridges.Add(nodes.Get(2));
-    bridges.Add(nodes.Get(3));
-
-    InternetStackHelper internet;
-    internet.Install(endpoints);
-
-    // We use CSMA channels to emulate the behaviour of ethernet. This is paired with the installation
-    // of CSMA net devices on all the nodes in the network. These are the devices that grant each node
-    // their unique MAC addresses. We set up channels of three types, one between switches and one between endpoints
-    // and their respective switch. These have latency and bandwidth parameters as described in the network topology.
-
-    // CSMA Channel for Switch 1 System
-    NS_LOG_LOGIC("Setting up Ethernet(CSMA) Channel for Switch 1 (n0, n1, n2)");
-    CsmaHelper csmaSwitch1;
-    csmaSwitch1.SetChannelAttribute("DataRate", StringValue("10Mbps"));
-    csmaSwitch1.SetChannelAttribute("Delay", TimeValue(MilliSeconds(3)));
-    csmaSwitch1.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize("100p")));
-    NetDeviceContainer n0n2 = csmaSwitch1.Install(NodeContainer(nodes.Get(0), nodes.Get(2)));
-    NetDeviceContainer n1n2 = csmaSwitch1.Install(NodeContainer(nodes.Get(1), nodes.Get(2)));
-
-    // CSMA Channel for Switch 2 System
-    NS_LOG_LOGIC("Setting up Ethernet(CSMA) Channel for Switch 2 (n3, n4, n5)");
-    CsmaHelper csmaSwitch2;
-    csmaSwitch2.SetChannelAttribute("DataRate", StringValue("10Mbps"));
-    csmaSwitch2.SetChannelAttribute("Delay", TimeValue(MilliSeconds(5)));
-    csmaSwitch2.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize("100p")));
-    NetDeviceContainer n3n4 = csmaSwitch2.Install(NodeContainer(nodes.Get(3), nodes.Get(4)));
-    NetDeviceContainer n3n5 = csmaSwitch2.Install(NodeContainer(nodes.Get(3), nodes.Get(5)));
-
-    // CSMA Channel for n2 -- n3
-    NS_LOG_LOGIC("Setting up Ethernet(CSMA) Channel between Switches (n2, n3)");
-    CsmaHelper csmaInter;
-    csmaInter.SetChannelAttribute("DataRate", StringValue("1.5Mbps"));
-    csmaInter.SetChannelAttribute("Delay", StringValue("15ms"));
-    csmaInter.SetQueue("ns3::DropTailQueue", "MaxSize", QueueSizeValue(QueueSize("100p")));
-    NetDeviceContainer interDevices = csmaInter.Install(NodeContainer(nodes.Get(2), nodes.Get(3)));
-
-    // Set up ports for Switch 1 (n2)
-    // i.e. connect the CSMA net devices of all direct
-    // connections on that switch
-    NetDeviceContainer bridge1ports;
-    bridge1ports.Add(n0n2.Get(1));
-    bridge1ports.Add(n1n2.Get(1));
-    bridge1ports.Add(interDevices.Get(0));
-
-    // Set up ports for Switch 2 (n3)
-    // i.e. connect the CSMA net devices of all direct
-    // connections on that switch
-    NetDeviceContainer bridge2ports;
-    bridge2ports.Add(n3n4.Get(0));
-    bridge2ports.Add(n3n5.Get(0));
-    bridge2ports.Add(interDevices.Get(1));
-
-    BridgeHelper bridgehelper;
-    NetDeviceContainer bridge1device = bridgehelper.Install(nodes.Get(2), bridge1ports);
-    NetDeviceContainer bridge2device = bridgehelper.Install(nodes.Get(3), bridge2ports);
-    // NS_LOG_INFO("Bridge 1 (n2) MAC Address: " << nodes.Get(2)->GetDevice(0)->GetAddress());
-    // NS_LOG_INFO("Bridge 2 (n3) MAC Address: " << nodes.Get(3)->GetDevice(0)->GetAddress());
-    // NS_LOG_INFO("Source (n0) MAC Address: " << nodes.Get(0)->GetDevice(1)->GetAddress());
-    // NS_LOG_INFO("Dest (n4) MAC Address: " << nodes.Get(4)->GetDevice(1)->GetAddress());
-
-    // Declare all nodes to be in the same subnet with base 10.0.0.0
-    Ipv4AddressHelper ipv4;
-    ipv4.SetBase("10.0.0.0", "255.255.255.0");
-    Ipv4InterfaceContainer interfaces;
-    interfaces.Add(ipv4.Assign(n0n2.Get(0)));
-    interfaces.Add(ipv4.Assign(n1n2.Get(0)));
-    interfaces.Add(ipv4.Assign(n3n4.Get(1)));
-    interfaces.Add(ipv4.Assign(n3n5.Get(1)));
-
-
-    SetupDropTrack();
+    if (traceLevel >= TRACE_COUNTERS)
+    {
+        // Drop counters for every CSMA device, bridge port and device queue, the
+        // per drop records are buffered in memory and written to node-drops.bin in chunks
+        DropStats::Get().Open(traceLevel >= TRACE_SAMPLED ? RankPath("node-drops.bin") : "");
+        DropStats::Get().Attach(nodes);
+
+        // Queue occupancy and transmitter busy time of every CSMA device, e.g. to tell queueing
+        // at n2 apart from serialization on the n2-n3 link
+        LinkMonitor::Get().Attach(nodes);
+        LinkMonitor::Get().EnableSampling(Seconds(linkSampleOpt->value()), linkSlotsOpt->value(),
+                                          Seconds(simEndOpt->value()));
+    }
+
+    if (hopMonitorOpt->value())
+    {
+        // Senders tag frames, every CSMA device on the path times them through its queue and transmitter
+        HopMonitor::Get().Enable();
+        HopMonitor::Get().Attach(nodes);
+    }
 
     // Set up sending and receiving applicataions for each channel
     // activated by the user.
-    ns3::PacketMetadata::Enable();
+    if (traceLevel >= TRACE_FULL)
+    {
+        // Metadata grows every packet, only pay for it when pcaps and NetAnim need it
+        ns3::PacketMetadata::Enable();
+    }
 
-    for (int i = 0; i < numConfigs; i++)
+    if (rxRingOpt->value() > 0)
     {
+        // Endpoint demuxes put a ring in front of their flows when they are created
+        RxRingConfig ring;
+        ring.size = rxRingOpt->value();
+        ring.frames = rxFramesOpt->value();
+        ring.timeout = Time(rxTimeoutOpt->value());
+        ring.budget = rxBudgetOpt->value();
+        ring.batchCost = Time(rxBatchCostOpt->value());
+        ring.frameCost = Time(rxFrameCostOpt->value());
+        RxCoalescing::Get().Enable(ring);
+    }
 
-        Ptr<RawApp> rcvAppLoop = CreateObject<RawApp>();
-        rcvAppLoop->Setup(configs[i].pktSize, 0, Seconds(0), false, configs[i].src, false);
-        configs[i].dst->AddApplication(rcvAppLoop);
-        rcvAppLoop->SetStartTime(Seconds(configs[i].start));
-        rcvAppLoop->SetStopTime(Seconds(simEndOpt->value()));
+    if (!EventLog::Get().Open(eventLogMode, RankPath(eventFileOpt->value()), std::max(eventRingOpt->value(), 1)))
+    {
+        std::cout << "ERROR: Could not open event log " << eventFileOpt->value() << std::endl;
+        return 1;
+    }
 
-        Ptr<RawApp> sndAppLoop = CreateObject<RawApp>();
-        if (!rawEnableOpt->value()) {
-            sndAppLoop->Setup(configs[i].pktSize, configs[i].numPkts, Seconds(configs[i].interval), true, configs[i].dst, false);
+    // Apps are created shortly before each flow starts and released once it is done
+    FlowOptions flowOptions;
+    // The raw frame is parsed once and shared by all senders
+    if (rawFrames)
+    {
+        Ptr<FrameTemplate> frame = !frameOpt->value().empty() ? FrameTemplate::FromHex(frameOpt->value())
+                                   : !frameFileOpt->value().empty() ? FrameTemplate::FromFile(frameFileOpt->value())
+                                   : FrameTemplate::TestFrame();
+        frame->SetPatches(framePatchOpt->value());
+        flowOptions.frame = frame;
+    }
+    flowOptions.fastPath = fastPathOpt->value();
+    flowOptions.echo = echoOpt->value();
+    flowOptions.meanOn = Seconds(meanOnOpt->value());
+    flowOptions.meanOff = Seconds(meanOffOpt->value());
+    flowOptions.bucket = bucketOpt->value();
+    flowOptions.queue = QueueSize(queueSizeOpt->value());
+    flowOptions.mtu = mtuOpt->value();
+    flowOptions.gso = gsoOpt->value();
+    flowOptions.reasmSlots = reasmSlotsOpt->value();
+    flowOptions.stop = Seconds(simEndOpt->value());
+    // Only the flows the report lists keep their statistics after they retire
+    FlowStats::Get().SetKept(printFlowsOpt->value());
+    ScenarioDriver driver(reader, topology, flowOptions);
+    driver.SetLookahead(Seconds(lookaheadOpt->value()));
+    driver.SetLinger(Seconds(lingerOpt->value()));
+    driver.Start();
+
+    // Replay sources on every endpoint, captured hosts are spread over them
+    Ptr<PcapReplay> replay;
+    if (!replayOpt->value().empty())
+    {
+        replay = Create<PcapReplay>();
+        std::string error;
+        if (!replay->Open(replayOpt->value(), error, uint64_t(replayWindowOpt->value()) << 20))
+        {
+            std::cout << "ERROR: " << error << std::endl;
+            return 1;
         }
-        else 
+        replay->SetSpeedup(replaySpeedOpt->value());
+        NodeContainer endpoints = topology.GetEndpoints();
+        for (uint32_t i = 0; i < endpoints.GetN(); i++)
         {
-            sndAppLoop->Setup(configs[i].pktSize, configs[i].numPkts, Seconds(configs[i].interval), true, configs[i].dst, true);
+            Ptr<RawApp> source = CreateObject<RawApp>();
+            source->SetupReplay();
+            endpoints.Get(i)->AddApplication(source);
+            source->SetStartTime(Seconds(0));
+            source->SetStopTime(Seconds(simEndOpt->value()));
+            replay->AddEndpoint(source);
         }
-        configs[i].src->AddApplication(sndAppLoop);
-        sndAppLoop->SetStartTime(Seconds(configs[i].start));
-        sndAppLoop->SetStopTime(Seconds(simEndOpt->value()));
+        replay->Start(Seconds(replayStartOpt->value()), Seconds(simEndOpt->value()));
     }
 
     // Enable packet capture for each endpoint.
 
-    csmaSwitch1.EnablePcap("endpoint-n0", n0n2.Get(0));
-    csmaSwitch1.EnablePcap("endpoint-n1", n1n2.Get(0));
-    csmaSwitch2.EnablePcap("endpoint-n4", n3n4.Get(1));
-    csmaSwitch2.EnablePcap("endpoint-n5", n3n5.Get(1));
+    std::unique_ptr<AnimationInterface> anim;
+    std::vector<Ptr<SampledPcap>> samplers;
+    if (traceLevel == TRACE_FULL)
+    {
+        NodeContainer endpoints = topology.GetEndpoints();
+        CsmaHelper csma;
+        for (uint32_t i = 0; i < endpoints.GetN(); i++)
+        {
+            csma.EnablePcap("endpoint-n" + std::to_string(endpoints.Get(i)->GetId()), Topology::GetEndpointDevice(endpoints.Get(i)));
+        }
 
-    AnimationInterface anim("simulation.xml");
-    anim.SetConstantPosition(nodes.Get(0), 0.0, 0.0);
-    anim.SetConstantPosition(nodes.Get(1), 0.0, 10.0);
-    anim.SetConstantPosition(nodes.Get(2), 2.5, 5.0);
-    anim.SetConstantPosition(nodes.Get(3), 7.5, 5.0);
-    anim.SetConstantPosition(nodes.Get(4), 10.0, 0.0);
-    anim.SetConstantPosition(nodes.Get(5), 10.0, 10.0);
-    anim.EnablePacketMetadata(true);
+        anim = std::make_unique<AnimationInterface>("simulation.xml");
+        for (uint32_t i = 0; i < nodes.GetN(); i++)
+        {
+            Vector pos = topology.GetPosition(i);
+            anim->SetConstantPosition(nodes.Get(i), pos.x, pos.y);
+        }
+        anim->EnablePacketMetadata(true);
+    }
+    else if (traceLevel == TRACE_SAMPLED)
+    {
+        NodeContainer endpoints = topology.GetEndpoints();
+        for (uint32_t i = 0; i < endpoints.GetN(); i++)
+        {
+            if (!topology.IsLocal(endpoints.Get(i)->GetId()))
+            {
+                continue;
+            }
+            samplers.push_back(SampledPcap::Enable("endpoint-n" + std::to_string(endpoints.Get(i)->GetId()),
+                                                   Topology::GetEndpointDevice(endpoints.Get(i)), sampleNOpt->value(), snapLenOpt->value()));
+        }
+    }
+
+    if (Emulation::Get().IsEnabled())
+    {
+        Emulation::Get().Start(Seconds(simEndOpt->value()));
+    }
 
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+    Emulation::Get().Stop();
+
+    // Wall clock send rate, compare runs with --fastPath=true/false to benchmark the send path
+    driver.Finish();
+    // The writer thread drains what is left, so the counts below are final
+    EventLog::Get().Close();
+    LinkMonitor::Get().WriteSamples(RankPath("link-samples.csv"));
+    if (hopMonitorOpt->value() && !HopMonitor::Get().Write(RankPath(hopFileOpt->value())))
+    {
+        std::cout << "ERROR: Could not write " << RankPath(hopFileOpt->value()) << std::endl;
+    }
+
+    // Distributed runs report totals over all ranks from rank 0. Drop, link, hop and switch
+    // sections only cover rank 0's nodes, the other ranks' are in their per rank files.
+    Distributed::Get().GatherFlowStats();
+    uint64_t totalSent = Distributed::Get().Sum(driver.GetTotalSent() + (replay ? replay->GetSent() : 0));
+    uint64_t events = Distributed::Get().Sum(Simulator::GetEventCount());
+    uint64_t drops = Distributed::Get().Sum(DropStats::Get().GetTotal());
+    wall = std::chrono::duration<double>(Distributed::Get().Max(wall.count()));
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    if (!isRoot)
+    {
+        std::cout << "Rank " << Distributed::Get().GetRank() << " done, " << driver.GetNumFlows() << " flows" << std::endl;
+        Simulator::Destroy();
+        return 0;
+    }
+    std::cout << "Sent " << totalSent << " packets in " << wall.count() << "s wall clock ("
+              << (wall.count() > 0 ? totalSent / wall.count() : 0.0) << " pkts/s, "
+              << (flowOptions.frame ? "raw frame" : gsoOpt->value() ? "segmented" : fastPathOpt->value() ? "template" : "legacy") << " send path)" << std::endl;
+    std::cout << "Ran " << driver.GetNumFlows() << " flows, at most " << driver.GetPeakActive() << " active at once" << std::endl;
+
+    // Cost of the run at the chosen trace level, the RSS is rank 0's
+    std::cout << "Executed " << events << " events (" << (wall.count() > 0 ? events / wall.count() : 0.0)
+              << " events/s), peak RSS " << usage.ru_maxrss / 1024.0 << " MB, trace level " << traceOpt->value()
+              << ", " << schedulerOpt->value() << " scheduler" << std::endl;
+
+    if (replay)
+    {
+        replay->Print(std::cout);
+    }
+    EventLog::Get().Print(std::cout);
+    FlowStats::Get().Print(std::cout);
+    DropStats::Get().Print(std::cout);
+    LinkMonitor::Get().Print(std::cout);
+    HopMonitor::Get().Print(std::cout, printFlowsOpt->value());
+    topology.PrintSwitches(std::cout);
+    RxCoalescing::Get().Print(std::cout);
+    Emulation::Get().Print(std::cout);
+
+    if (!statsOutOpt->value().empty())
+    {
+        std::ofstream stats(statsOutOpt->value());
+        stats << "nodes " << nodes.GetN() << "\n"
+              << "setup_s " << setupWall.count() << "\n"
+              << "setup_rss_kb " << setupRssKb << "\n"
+              << "wall_s " << wall.count() << "\n"
+              << "events " << events << "\n"
+              << "events_per_s " << (wall.count() > 0 ? events / wall.count() : 0.0) << "\n"
+              << "peak_rss_kb " << usage.ru_maxrss << "\n"
+              << "sim_s " << Simulator::Now().GetSeconds() << "\n"
+              << "flows " << driver.GetNumFlows() << "\n"
+              << "peak_active_flows " << driver.GetPeakActive() << "\n"
+              << "sent " << totalSent << "\n"
+              << "pkts_per_s " << (wall.count() > 0 ? totalSent / wall.count() : 0.0) << "\n"
+              << "drops " << drops << "\n"
+              << "ranks " << Distributed::Get().GetSize() << "\n";
+        FlowStats::Get().WriteSummary(stats);
+        RxCoalescing::Get().WriteSummary(stats);
+        Emulation::Get().WriteSummary(stats);
+    }
+
     Simulator::Destroy();
 
     return 0;
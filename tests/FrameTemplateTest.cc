@@ -0,0 +1,75 @@
+/*
+ * Checks that frames stamped from a FrameTemplate carry valid IPv4 and UDP checksums.
+ * Exits non-zero on the first bad frame.
+ *
+ * Usage: frame-template-test
+ */
+
+#include "Checksum.h"
+#include "FrameTemplate.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+// Stamp packet seq and return the frame after the Ethernet header
+static std::vector<uint8_t> StampFrame(Ptr<const FrameTemplate> frame, uint32_t seq)
+{
+    PrebuiltHeader hdr = frame->GetHeader();
+    frame->Stamp(hdr.Data(), seq);
+    uint32_t prefix = hdr.GetSerializedSize();
+    std::vector<uint8_t> l3(prefix + frame->GetPayload()->GetSize());
+    std::copy(hdr.Data(), hdr.Data() + prefix, l3.begin());
+    frame->GetPayload()->CopyData(l3.data() + prefix, l3.size() - prefix);
+    return l3;
+}
+
+// Both checksums of an IPv4/UDP packet verify, a zero UDP checksum does not count as valid here
+static bool ChecksumsValid(const std::vector<uint8_t>& l3)
+{
+    uint32_t ipHeaderLen = (l3[0] & 0x0f) * 4u;
+    if (ChecksumSum(l3.data(), ipHeaderLen) != 0xffff)
+    {
+        return false;
+    }
+    const uint8_t* udp = l3.data() + ipHeaderLen;
+    uint32_t udpSize = l3.size() - ipHeaderLen;
+    if (ReadNet16(udp + 6) == 0)
+    {
+        return false;
+    }
+    uint32_t sum = ChecksumSum(&l3[12], 8);
+    sum += 17;
+    sum += udpSize;
+    return ChecksumSum(udp, udpSize, sum) == 0xffff;
+}
+
+static int Check(const std::string& name, const std::string& patches)
+{
+    // The test frame's UDP checksum field is 0, csum fills it in before the fields are stamped
+    Ptr<FrameTemplate> frame = FrameTemplate::TestFrame();
+    frame->SetPatches(patches);
+    for (uint32_t seq : {0u, 1u, 2u, 0xffffu, 0x10000u, 0x12345678u, 0xffffffffu})
+    {
+        std::vector<uint8_t> l3 = StampFrame(frame, seq);
+        if (!ChecksumsValid(l3))
+        {
+            std::cout << "ERROR: " << name << ": bad checksum in the frame for seq " << seq << std::endl;
+            return 1;
+        }
+    }
+    std::cout << name << ": ok" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    int failed = 0;
+    // Offsets count from the start of the Ethernet header, the UDP payload starts at 42
+    failed += Check("seq in the UDP payload", "seq@42,csum");
+    failed += Check("16 bit seq in the UDP payload", "seq@46:2,csum");
+    failed += Check("ipid and seq", "ipid,seq@42,csum");
+    failed += Check("seq with len", "seq@50,len");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs independent simulator processes, at most a fixed number at a time. Each ns-3
+// simulation owns the process wide Simulator singleton, so parallelism comes from
+// forking whole runs rather than threads.
+
+struct ProcessJob
+{
+    std::vector<std::string> args;  // argv, args[0] must be an absolute path
+    std::string dir;                // Working directory, created if missing
+    std::string log;                // File in dir receiving stdout and stderr
+};
+
+struct ProcessResult
+{
+    int exitCode;       // Exit code, -1 if the process was killed by a signal
+    double wallSeconds; // Wall clock run time
+    long maxRssKb;      // Peak resident set size
+};
+
+class ProcessPool {
+    public:
+        explicit ProcessPool(unsigned jobs)
+            : m_jobs(jobs > 0 ? jobs : 1)
+        {
+        }
+
+        // Run every job, onDone is called in the parent as each one exits
+        void Run(const std::vector<ProcessJob>& jobs, const std::function<void(size_t, const ProcessResult&)>& onDone)
+        {
+            std::map<pid_t, std::pair<size_t, std::chrono::steady_clock::time_point>> running;
+            size_t next = 0;
+            while (next < jobs.size() || !running.empty())
+            {
+                while (next < jobs.size() && running.size() < m_jobs)
+                {
+                    pid_t pid = Start(jobs[next]);
+                    if (pid < 0)
+                    {
+                        onDone(next, ProcessResult{-1, 0.0, 0});
+                    }
+                    else
+                    {
+                        running[pid] = {next, std::chrono::steady_clock::now()};
+                    }
+                    next++;
+                }
+                if (running.empty())
+                {
+                    continue;
+                }
+
+                int status = 0;
+                struct rusage usage;
+                pid_t pid = wait4(-1, &status, 0, &usage);
+                if (pid < 0)
+                {
+                    break;
+                }
+                auto it = running.find(pid);
+                if (it == running.end())
+                {
+                    continue;
+                }
+                std::chrono::duration<double> wall = std::chrono::steady_clock::now() - it->second.second;
+                ProcessResult result{WIFEXITED(status) ? WEXITSTATUS(status) : -1, wall.count(), usage.ru_maxrss};
+                size_t index = it->second.first;
+                running.erase(it);
+                onDone(index, result);
+            }
+        }
+
+    private:
+        static pid_t Start(const ProcessJob& job)
+        {
+            ::mkdir(job.dir.c_str(), 0755);
+            pid_t pid = fork();
+            if (pid != 0)
+            {
+                return pid;
+            }
+
+            // Child: run inside the job directory so per run output files do not collide
+            if (chdir(job.dir.c_str()) != 0)
+            {
+                _exit(127);
+            }
+            int fd = open(job.log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd >= 0)
+            {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+            std::vector<char*> argv;
+            for (const std::string& arg : job.args)
+            {
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            }
+            argv.push_back(nullptr);
+            execv(argv[0], argv.data());
+            std::perror("execv");
+            _exit(127);
+        }
+
+        unsigned m_jobs;    // Maximum concurrent processes
+};
+
+// Totals a run wrote with rawudpnet --statsOut, "key value" per line
+inline std::map<std::string, double> ReadStats(const std::string& path)
+{
+    std::map<std::string, double> stats;
+    std::ifstream in(path);
+    std::string key;
+    double value;
+    while (in >> key >> value)
+    {
+        stats[key] = value;
+    }
+    return stats;
+}
+
+#endif
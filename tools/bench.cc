@@ -0,0 +1,428 @@
+/*
+ * Benchmark suite for rawudpnet.
+ *
+ * Runs a fixed set of scenarios under each ns-3 scheduler, a few times each, one run at
+ * a time so runs do not compete for cores and caches. Appends one row per scenario and
+ * scheduler to a CSV keyed by a label (the git commit by default), so the file collects
+ * results across commits. --baseline compares this run against an earlier label.
+ * --ranks adds a scaling run: every scenario also runs distributed over that many MPI
+ * ranks (rawudpnet --distributed under mpirun on this machine), all with fast switches.
+ *
+ * Scenarios:
+ *   cbr       one constant bit rate flow across the classic network, below the bottleneck rate
+ *   saturate  four flows offering 4 Mbps to the 1.5 Mbps n2-n3 bottleneck
+ *   drops     bursty 5 Mbps flows into 10 packet queues, most frames are dropped. A run that
+ *             does not try every packet or loses none counts as failed.
+ *   tree      1024 endpoints under 33 switches, 64 flows between racks
+ *
+ * Example:
+ *   bench --bin ./build/rawudpnet --schedulers map,heap --repeat 5 --baseline 1a2b3c4
+ *   bench --bin ./build/rawudpnet --scenarios cbr,tree --schedulers map --ranks 1,2,4
+ */
+
+#include "external/popl.hpp"
+#include "ProcessPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits.h>
+#include <map>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+struct Scenario
+{
+    std::string name;
+    std::vector<std::string> args;      // rawudpnet options, scaled packet counts are appended
+    std::vector<int> numPkts;           // Packets per flow at --scale 1
+    bool lossy = false;                 // Every packet must be tried and some lost
+};
+
+struct Result
+{
+    std::string scenario;
+    std::string scheduler;
+    int ranks;
+    std::vector<double> wall;           // Simulator::Run wall time of each good run
+    std::vector<double> processWall;    // Whole process wall time of each good run, including setup
+    double events = 0;
+    double sent = 0;
+    double lost = 0;                    // Frames refused, dropped or still in flight at the end
+    double peakRssKb = 0;
+    int failed = 0;
+    bool lossy = false;
+    double numPkts = 0;                 // Packets of all flows after scaling
+};
+
+static std::vector<Scenario> Scenarios()
+{
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({"cbr", {"--initiator=0", "--target=4", "--pktSize=512", "--interval=0.004", "--simEnd=110"}, {25000}});
+    scenarios.push_back({"saturate", {"--initiator=0 1 0 1", "--target=4 5 5 4", "--pktSize=1024 1024 1024 1024",
+                                      "--rate=1Mbps 1Mbps 1Mbps 1Mbps", "--start=1 1 1 1", "--simEnd=90"},
+                         {10000, 10000, 10000, 10000}});
+    scenarios.push_back({"drops", {"--initiator=0 1", "--target=4 5", "--pktSize=1024 1024", "--rate=5Mbps 5Mbps",
+                                   "--burst=32 32", "--start=1 1", "--queueSize=10p", "--simEnd=40"},
+                         {20000, 20000}, true});
+
+    // Flows from the first racks to the last ones, so most cross the root
+    Scenario tree{"tree", {"--topo=tree", "--endpoints=1024", "--fanout=32 32", "--tierRate=1Gbps 10Gbps", "--tierDelay=2us 5us", "--simEnd=8"}, {}};
+    std::string initiators, targets, sizes, rates, starts;
+    for (int i = 0; i < 64; i++)
+    {
+        const char* sep = i ? " " : "";
+        initiators += sep + std::to_string(i);
+        targets += sep + std::to_string(1023 - i);
+        sizes += std::string(sep) + "1024";
+        rates += std::string(sep) + "100Mbps";
+        starts += std::string(sep) + "1";
+        tree.numPkts.push_back(50000);
+    }
+    tree.args.push_back("--initiator=" + initiators);
+    tree.args.push_back("--target=" + targets);
+    tree.args.push_back("--pktSize=" + sizes);
+    tree.args.push_back("--rate=" + rates);
+    tree.args.push_back("--start=" + starts);
+    scenarios.push_back(tree);
+    return scenarios;
+}
+
+static std::vector<std::string> SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static double Median(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+// Commit of the working directory, for labelling results
+static std::string GitLabel()
+{
+    std::string label;
+    FILE* git = popen("git rev-parse --short HEAD 2>/dev/null", "r");
+    if (git)
+    {
+        char buf[64];
+        if (std::fgets(buf, sizeof(buf), git))
+        {
+            label = buf;
+            label.erase(label.find_last_not_of("\r\n") + 1);
+        }
+        pclose(git);
+    }
+    return label.empty() ? "unknown" : label;
+}
+
+// events_per_s of earlier rows with the given label, by scenario, scheduler and ranks (the last row wins)
+static std::map<std::string, double> ReadBaseline(const std::string& path, const std::string& label)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string line;
+    std::vector<std::string> header;
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ','))
+        {
+            fields.push_back(field);
+        }
+        if (header.empty())
+        {
+            header = fields;
+            continue;
+        }
+        auto column = [&](const std::string& name) -> std::string {
+            size_t i = std::find(header.begin(), header.end(), name) - header.begin();
+            return i < fields.size() ? fields[i] : "";
+        };
+        if (column("label") == label)
+        {
+            // Rows written before the ranks column ran on one rank
+            std::string ranks = column("ranks").empty() ? "1" : column("ranks");
+            baseline[column("scenario") + "/" + column("scheduler") + "/" + ranks] = std::atof(column("events_per_s").c_str());
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char *argv[])
+{
+    auto op = popl::OptionParser("Allowed Options");
+    auto binOpt = op.add<popl::Value<std::string>>("b", "bin", "String: rawudpnet executable", "./rawudpnet");
+    auto scenariosOpt = op.add<popl::Value<std::string>>("", "scenarios", "String: comma separated scenarios to run: cbr, saturate, drops, tree", "cbr,saturate,drops,tree");
+    auto schedulersOpt = op.add<popl::Value<std::string>>("", "schedulers", "String: comma separated rawudpnet --scheduler values to run every scenario with", "map,heap,calendar,list");
+    auto repeatOpt = op.add<popl::Value<int>>("r", "repeat", "int: runs per scenario and scheduler, the median wall time is reported", 3);
+    auto scaleOpt = op.add<popl::Value<double>>("", "scale", "double: factor applied to every scenario's packet counts, e.g. 0.1 for a quick check", 1.0);
+    auto ranksOpt = op.add<popl::Value<std::string>>("", "ranks", "String: comma separated MPI rank counts to run every scenario with, e.g. 1,2,4, anything but 1 switches to fast switches", "1");
+    auto mpirunOpt = op.add<popl::Value<std::string>>("", "mpirun", "String: MPI launcher for runs on more than one rank", "/usr/bin/mpirun");
+    auto jobsOpt = op.add<popl::Value<int>>("j", "jobs", "int: concurrent runs, more than 1 skews wall times", 1);
+    auto labelOpt = op.add<popl::Value<std::string>>("l", "label", "String: label of this run's rows, the current git commit by default", "");
+    auto baselineOpt = op.add<popl::Value<std::string>>("", "baseline", "String: label of earlier rows in the results file to compare events/s against", "");
+    auto runDirOpt = op.add<popl::Value<std::string>>("d", "runDir", "String: directory holding one subdirectory per run", "bench-runs");
+    auto resultsOpt = op.add<popl::Value<std::string>>("o", "results", "String: results table (CSV), rows are appended", "bench-results.csv");
+    auto helpOpt = op.add<popl::Switch>("h", "help", "Print this help message");
+
+    try
+    {
+        op.parse(argc, argv);
+        if (helpOpt->is_set())
+        {
+            std::cout << op << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error parsing arguments: " << e.what() << std::endl;
+        std::cout << op << std::endl;
+        return 1;
+    }
+
+    char binPath[PATH_MAX];
+    if (!realpath(binOpt->value().c_str(), binPath))
+    {
+        std::cerr << "ERROR: cannot find " << binOpt->value() << std::endl;
+        return 1;
+    }
+
+    std::vector<Scenario> all = Scenarios();
+    std::vector<Scenario> scenarios;
+    for (const std::string& name : SplitList(scenariosOpt->value()))
+    {
+        auto it = std::find_if(all.begin(), all.end(), [&](const Scenario& s) { return s.name == name; });
+        if (it == all.end())
+        {
+            std::cerr << "ERROR: unknown scenario " << name << std::endl;
+            return 1;
+        }
+        scenarios.push_back(*it);
+    }
+    std::vector<std::string> schedulers = SplitList(schedulersOpt->value());
+    std::vector<int> ranks;
+    for (const std::string& item : SplitList(ranksOpt->value()))
+    {
+        ranks.push_back(std::atoi(item.c_str()));
+    }
+    if (scenarios.empty() || schedulers.empty() || repeatOpt->value() < 1 || ranks.empty() ||
+        std::any_of(ranks.begin(), ranks.end(), [](int n) { return n < 1; }))
+    {
+        std::cerr << "ERROR: need at least one scenario, one scheduler, one run and rank counts of at least 1" << std::endl;
+        return 1;
+    }
+    // Scaling runs compare against one rank with the same switches, the bridge can not be split
+    bool scaling = ranks.size() > 1 || ranks[0] > 1;
+    char mpirunPath[PATH_MAX];
+    if (std::any_of(ranks.begin(), ranks.end(), [](int n) { return n > 1; }) && !realpath(mpirunOpt->value().c_str(), mpirunPath))
+    {
+        std::cerr << "ERROR: cannot find " << mpirunOpt->value() << std::endl;
+        return 1;
+    }
+    std::string label = labelOpt->value().empty() ? GitLabel() : labelOpt->value();
+
+    ::mkdir(runDirOpt->value().c_str(), 0755);
+    char runDir[PATH_MAX];
+    if (!realpath(runDirOpt->value().c_str(), runDir))
+    {
+        std::cerr << "ERROR: cannot create " << runDirOpt->value() << std::endl;
+        return 1;
+    }
+
+    std::vector<ProcessJob> jobs;
+    std::vector<size_t> jobResult;
+    std::vector<Result> results;
+    for (const Scenario& scenario : scenarios)
+    {
+        std::string numPkts;
+        double totalPkts = 0;
+        for (size_t f = 0; f < scenario.numPkts.size(); f++)
+        {
+            int count = std::max(1, static_cast<int>(scenario.numPkts[f] * scaleOpt->value()));
+            numPkts += (f ? " " : "") + std::to_string(count);
+            totalPkts += count;
+        }
+        for (const std::string& scheduler : schedulers)
+        {
+            for (int np : ranks)
+            {
+                results.push_back(Result{scenario.name, scheduler, np, {}, {}});
+                results.back().lossy = scenario.lossy;
+                results.back().numPkts = totalPkts;
+                for (int r = 0; r < repeatOpt->value(); r++)
+                {
+                    ProcessJob job;
+                    job.dir = std::string(runDir) + "/" + scenario.name + "-" + scheduler + (scaling ? "-np" + std::to_string(np) : "")
+                              + "-r" + std::to_string(r);
+                    job.log = "run.log";
+                    if (np > 1)
+                    {
+                        job.args.push_back(mpirunPath);
+                        job.args.push_back("-np");
+                        job.args.push_back(std::to_string(np));
+                    }
+                    job.args.push_back(binPath);
+                    job.args.insert(job.args.end(), scenario.args.begin(), scenario.args.end());
+                    job.args.push_back("--numPkts=" + numPkts);
+                    // Measure the simulator, not output formatting
+                    job.args.push_back("--trace=none");
+                    job.args.push_back("--eventLog=quiet");
+                    job.args.push_back("--printFlows=0");
+                    job.args.push_back("--scheduler=" + scheduler);
+                    job.args.push_back("--statsOut=stats.txt");
+                    if (scaling)
+                    {
+                        job.args.push_back("--switch=fast");
+                    }
+                    if (np > 1)
+                    {
+                        job.args.push_back("--distributed=true");
+                    }
+                    jobs.push_back(job);
+                    jobResult.push_back(results.size() - 1);
+                }
+            }
+        }
+    }
+
+    std::cout << "Running " << jobs.size() << " benchmarks (" << scenarios.size() << " scenarios x " << schedulers.size()
+              << " schedulers x " << ranks.size() << " rank counts x " << repeatOpt->value() << " runs) as " << label << std::endl;
+
+    size_t done = 0;
+    ProcessPool pool(jobsOpt->value() > 0 ? jobsOpt->value() : 1);
+    pool.Run(jobs, [&](size_t i, const ProcessResult& result) {
+        done++;
+        Result& agg = results[jobResult[i]];
+        std::map<std::string, double> stats;
+        if (result.exitCode == 0)
+        {
+            stats = ReadStats(jobs[i].dir + "/stats.txt");
+        }
+        bool ok = stats.count("wall_s") > 0;
+        // Refused frames are not in sent, they still count as tried
+        if (ok && agg.lossy && (stats["flows_sent"] + stats["flows_refused"] != agg.numPkts || stats["flows_lost"] == 0))
+        {
+            std::cout << jobs[i].dir << ": tried " << stats["flows_sent"] + stats["flows_refused"] << " of " << agg.numPkts
+                      << " packets and lost " << stats["flows_lost"] << ", expected all tried and some lost" << std::endl;
+            ok = false;
+        }
+        if (ok)
+        {
+            agg.wall.push_back(stats["wall_s"]);
+            agg.processWall.push_back(result.wallSeconds);
+            agg.events = stats["events"];
+            agg.sent = stats["sent"];
+            agg.lost = stats["flows_lost"];
+            agg.peakRssKb = std::max(agg.peakRssKb, stats["peak_rss_kb"]);
+        }
+        else
+        {
+            agg.failed++;
+        }
+        std::cout << "[" << done << "/" << jobs.size() << "] " << jobs[i].dir << (ok ? " ok " : " FAILED ")
+                  << result.wallSeconds << "s" << std::endl;
+    });
+
+    std::map<std::string, double> baseline;
+    if (!baselineOpt->value().empty())
+    {
+        baseline = ReadBaseline(resultsOpt->value(), baselineOpt->value());
+    }
+
+    std::ifstream existing(resultsOpt->value());
+    bool newFile = existing.peek() == std::ifstream::traits_type::eof();
+    existing.close();
+    std::ofstream out(resultsOpt->value(), std::ios::app);
+    if (newFile)
+    {
+        out << "label,scenario,scheduler,runs,wall_s,wall_s_min,process_wall_s,events,events_per_s,sent,pkts_per_s,peak_rss_kb,ranks,lost\n";
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    int failed = 0;
+    size_t rows = 0;
+    std::map<std::string, std::pair<std::string, double>> fastest;
+    std::map<std::string, double> oneRankWall;    // By scenario/scheduler, for speedups
+    for (const Result& result : results)
+    {
+        failed += result.failed;
+        if (result.wall.empty())
+        {
+            continue;
+        }
+        double wall = Median(result.wall);
+        double eventsPerS = wall > 0 ? result.events / wall : 0.0;
+        double pktsPerS = wall > 0 ? result.sent / wall : 0.0;
+        out << label << "," << result.scenario << "," << result.scheduler << "," << result.wall.size() << "," << wall
+            << "," << *std::min_element(result.wall.begin(), result.wall.end()) << "," << Median(result.processWall)
+            << "," << static_cast<uint64_t>(result.events) << "," << eventsPerS << "," << static_cast<uint64_t>(result.sent)
+            << "," << pktsPerS << "," << static_cast<uint64_t>(result.peakRssKb) << "," << result.ranks << "," << static_cast<uint64_t>(result.lost) << "\n";
+        rows++;
+
+        std::string key = result.scenario + "/" + result.scheduler;
+        std::cout << result.scenario << " " << result.scheduler;
+        if (scaling)
+        {
+            std::cout << " on " << result.ranks << (result.ranks > 1 ? " ranks" : " rank");
+        }
+        std::cout << ": " << wall << "s, " << eventsPerS << " events/s, " << pktsPerS << " pkts/s, "
+                  << static_cast<uint64_t>(result.lost) << " lost, peak RSS " << result.peakRssKb / 1024 << " MB";
+        if (result.ranks == 1)
+        {
+            oneRankWall[key] = wall;
+        }
+        else if (oneRankWall.count(key) && wall > 0)
+        {
+            std::cout << ", " << oneRankWall[key] / wall << "x speedup";
+        }
+        auto base = baseline.find(key + "/" + std::to_string(result.ranks));
+        if (base != baseline.end() && base->second > 0)
+        {
+            std::cout << ", " << std::showpos << 100.0 * (eventsPerS / base->second - 1) << std::noshowpos << "% events/s vs "
+                      << baselineOpt->value();
+        }
+        std::cout << std::endl;
+
+        auto& best = fastest[result.scenario];
+        if (result.ranks == ranks[0] && eventsPerS > best.second)
+        {
+            best = {result.scheduler, eventsPerS};
+        }
+    }
+    for (const auto& kv : fastest)
+    {
+        std::cout << "Fastest scheduler for " << kv.first << ": " << kv.second.first << std::endl;
+    }
+
+    std::cout << "Appended " << rows << " rows to " << resultsOpt->value();
+    if (failed)
+    {
+        std::cout << " (" << failed << " runs failed, see run.log in their directories)";
+    }
+    std::cout << std::endl;
+    return failed ? 1 : 0;
+}
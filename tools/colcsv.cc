@@ -0,0 +1,95 @@
+/*
+ * Converts a columnar result table written by rawudpnet (e.g. hop-stats.col) to CSV,
+ * or lists its columns with --schema.
+ *
+ * Usage: colcsv [hop-stats.col] [hop-stats.csv | --schema]
+ */
+
+#include "ColumnFile.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace ns3;
+
+int main(int argc, char *argv[])
+{
+    const char* inPath = argc > 1 ? argv[1] : "hop-stats.col";
+    const char* outPath = argc > 2 ? argv[2] : "hop-stats.csv";
+    bool schema = std::strcmp(outPath, "--schema") == 0;
+
+    FILE* in = std::fopen(inPath, "rb");
+    if (!in)
+    {
+        std::fprintf(stderr, "ERROR: could not open %s\n", inPath);
+        return 1;
+    }
+    ColumnFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, in) != 1 || std::memcmp(header.magic, COLUMN_FILE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        std::fprintf(stderr, "ERROR: %s is not a column file\n", inPath);
+        std::fclose(in);
+        return 1;
+    }
+    std::vector<ColumnDescriptor> descs(header.columns);
+    std::vector<uint64_t> data(static_cast<size_t>(header.columns) * header.rows);
+    if (std::fread(descs.data(), sizeof(ColumnDescriptor), descs.size(), in) != descs.size() ||
+        std::fread(data.data(), sizeof(uint64_t), data.size(), in) != data.size())
+    {
+        std::fprintf(stderr, "ERROR: %s is truncated\n", inPath);
+        std::fclose(in);
+        return 1;
+    }
+    std::fclose(in);
+
+    if (schema)
+    {
+        static const char* types[] = {"u64", "i64", "f64"};
+        std::printf("%u rows\n", header.rows);
+        for (const ColumnDescriptor& desc : descs)
+        {
+            std::printf("%-23s %s at offset %" PRIu64 "\n", desc.name, desc.type <= COLUMN_F64 ? types[desc.type] : "?", desc.offset);
+        }
+        return 0;
+    }
+
+    FILE* out = std::fopen(outPath, "w");
+    if (!out)
+    {
+        std::fprintf(stderr, "ERROR: could not open %s\n", outPath);
+        return 1;
+    }
+    for (uint32_t c = 0; c < header.columns; c++)
+    {
+        std::fprintf(out, "%s%s", c ? "," : "", descs[c].name);
+    }
+    std::fprintf(out, "\n");
+    for (uint32_t r = 0; r < header.rows; r++)
+    {
+        for (uint32_t c = 0; c < header.columns; c++)
+        {
+            uint64_t bits = data[static_cast<size_t>(c) * header.rows + r];
+            const char* sep = c ? "," : "";
+            if (descs[c].type == COLUMN_F64)
+            {
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                std::fprintf(out, "%s%.3f", sep, value);
+            }
+            else if (descs[c].type == COLUMN_I64)
+            {
+                std::fprintf(out, "%s%" PRId64, sep, static_cast<int64_t>(bits));
+            }
+            else
+            {
+                std::fprintf(out, "%s%" PRIu64, sep, bits);
+            }
+        }
+        std::fprintf(out, "\n");
+    }
+    std::fclose(out);
+    std::printf("Wrote %u rows to %s\n", header.rows, outPath);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Converts the binary drop log written by rawudpnet (node-drops.bin) to CSV.
+ *
+ * Usage: dropcsv [node-drops.bin] [node-drops.csv]
+ */
+
+#include "DropRecord.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace ns3;
+
+int main(int argc, char *argv[])
+{
+    const char* inPath = argc > 1 ? argv[1] : "node-drops.bin";
+    const char* outPath = argc > 2 ? argv[2] : "node-drops.csv";
+
+    FILE* in = std::fopen(inPath, "rb");
+    if (!in)
+    {
+        std::fprintf(stderr, "ERROR: could not open %s\n", inPath);
+        return 1;
+    }
+    char magic[sizeof(DROP_LOG_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) || std::memcmp(magic, DROP_LOG_MAGIC, sizeof(magic)) != 0)
+    {
+        std::fprintf(stderr, "ERROR: %s is not a drop log\n", inPath);
+        std::fclose(in);
+        return 1;
+    }
+    FILE* out = std::fopen(outPath, "w");
+    if (!out)
+    {
+        std::fprintf(stderr, "ERROR: could not open %s\n", outPath);
+        std::fclose(in);
+        return 1;
+    }
+
+    std::fprintf(out, "time_s,node,device,reason,bridge_port\n");
+    std::vector<DropRecord> chunk(65536);
+    size_t n;
+    uint64_t total = 0;
+    while ((n = std::fread(chunk.data(), sizeof(DropRecord), chunk.size(), in)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            const DropRecord& r = chunk[i];
+            std::fprintf(out, "%.9f,%u,%u,%s,%u\n", r.timeNs / 1e9, r.nodeId, r.device, DropReasonName(r.reason),
+                         (r.flags & DROP_FLAG_BRIDGE_PORT) ? 1u : 0u);
+        }
+        total += n;
+    }
+
+    std::fclose(in);
+    std::fclose(out);
+    std::printf("Wrote %llu drop records to %s\n", static_cast<unsigned long long>(total), outPath);
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Prints the binary event log written by rawudpnet --eventLog=binary (events.bin) as text,
+ * one event per line, optionally only the events of one flow.
+ *
+ * Usage: eventdump [events.bin] [flow]
+ */
+
+#include "EventRecord.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace ns3;
+
+int main(int argc, char *argv[])
+{
+    const char* inPath = argc > 1 ? argv[1] : "events.bin";
+    bool filter = argc > 2;
+    uint32_t flow = filter ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 0;
+
+    FILE* in = std::fopen(inPath, "rb");
+    if (!in)
+    {
+        std::fprintf(stderr, "ERROR: could not open %s\n", inPath);
+        return 1;
+    }
+    char magic[sizeof(EVENT_LOG_MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) || std::memcmp(magic, EVENT_LOG_MAGIC, sizeof(magic)) != 0)
+    {
+        std::fprintf(stderr, "ERROR: %s is not an event log\n", inPath);
+        std::fclose(in);
+        return 1;
+    }
+
+    std::printf("time_s node flow seq event size\n");
+    std::vector<EventRecord> chunk(65536);
+    size_t n;
+    while ((n = std::fread(chunk.data(), sizeof(EventRecord), chunk.size(), in)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            const EventRecord& r = chunk[i];
+            if (filter && r.flowId != flow)
+            {
+                continue;
+            }
+            // Frames without a probe belong to no flow
+            if (r.flowId == UINT32_MAX)
+            {
+                std::printf("%.9f %u - %u %s %u\n", r.timeNs / 1e9, r.nodeId, r.seq, EventTypeName(r.type), r.size);
+            }
+            else
+            {
+                std::printf("%.9f %u %u %u %s %u\n", r.timeNs / 1e9, r.nodeId, r.flowId, r.seq, EventTypeName(r.type), r.size);
+            }
+        }
+    }
+
+    std::fclose(in);
+    return 0;
+}
@@ -0,0 +1,436 @@
+/*
+ * Per flow throughput, loss and delay from the endpoint captures of a run, without tshark.
+ *
+ * Each capture is memory-mapped and walked by its own thread (at most --jobs at a time),
+ * decoding the Ethernet/IPv4/UDP headers and the probe header rawudpnet puts at the start
+ * of every payload, with no allocation per frame. Frames are then matched across captures
+ * by (flow, sequence number). A flow seen in two captures was sent where it was captured
+ * first, which also tells each capture's own MAC. A capture whose flows were not seen
+ * anywhere else falls back to the MAC in most of its frames, an endpoint is in every frame
+ * of its capture. A sequence number sent but never received is lost, and the delay is the
+ * receive capture time minus the send capture time. Flows whose sender was not captured
+ * fall back to the send time in the probe. Segmented messages count per message, timed by
+ * their first segment.
+ *
+ * Usage: pcapstat [--jobs N] [--csv pcap-flows.csv] [captures...], endpoint-*.pcap by default
+ */
+
+#include "external/popl.hpp"
+#include "LatencyHistogram.h"
+#include "PcapMap.h"
+#include "ProbeFormat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <glob.h>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+// Capture time of a sequence number
+struct SeqTime
+{
+    uint32_t seq;
+    uint64_t timeNs;
+};
+
+// One direction of a flow as seen in one capture, keyed by flow * 2 + (echo reply)
+struct Side
+{
+    uint64_t srcMac = 0;                // Of the first frame, 0 if the key never appeared
+    uint64_t dstMac = 0;
+    uint32_t srcIp = 0;
+    uint32_t dstIp = 0;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;                 // Frame bytes on the wire
+    uint64_t firstNs = 0;
+    uint64_t lastNs = 0;
+    std::vector<SeqTime> seqs;          // Once analyzed, each sequence number's first frame by sequence number
+    LatencyHistogram probeDelay;        // Capture time minus the probe's send time, in ns
+};
+
+struct Capture
+{
+    std::string path;
+    std::string error;                  // Set if the capture could not be read
+    uint64_t bytes = 0;                 // File size
+    uint64_t frames = 0;
+    uint64_t probes = 0;                // Frames carrying a probe header
+    uint64_t owner = 0;                 // MAC of the capturing endpoint
+    bool ownerKnown = false;            // owner was learned from a flow seen in another capture
+    std::unordered_map<uint64_t, Side> sides;   // By key, only keys seen in this capture
+};
+
+static uint64_t Mac(const uint8_t* p)
+{
+    uint64_t mac = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        mac = (mac << 8) | p[i];
+    }
+    return mac;
+}
+
+static uint32_t Net32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+static std::string MacString(uint64_t mac)
+{
+    char buf[18];
+    std::snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x", unsigned(mac >> 40) & 0xff, unsigned(mac >> 32) & 0xff,
+                  unsigned(mac >> 24) & 0xff, unsigned(mac >> 16) & 0xff, unsigned(mac >> 8) & 0xff, unsigned(mac) & 0xff);
+    return buf;
+}
+
+static std::string IpString(uint32_t ip)
+{
+    return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xff) + "." + std::to_string((ip >> 8) & 0xff) + "." + std::to_string(ip & 0xff);
+}
+
+// Walk one capture, filling in its sides and owner
+static void Analyze(Capture& capture)
+{
+    PcapMap map;
+    if (!map.Open(capture.path, capture.error))
+    {
+        return;
+    }
+    capture.bytes = map.GetFileSize();
+    PcapRecord rec;
+    Side* last = nullptr;
+    uint64_t lastKey = 0;
+    while (map.Next(rec))
+    {
+        capture.frames++;
+        // Ethernet II, IPv4, UDP, probe
+        const uint8_t* d = rec.data;
+        if (rec.linkType != PCAP_LINKTYPE_ETHERNET || rec.capLen < 14 + 20 || d[12] != 0x08 || d[13] != 0x00 || (d[14] >> 4) != 4 || d[23] != 17)
+        {
+            continue;
+        }
+        uint32_t ipLen = (d[14] & 0x0f) * 4;
+        uint32_t probeAt = 14 + ipLen + 8;
+        if (ipLen < 20 || rec.capLen < probeAt + PROBE_SIZE || ((d[probeAt] << 8) | d[probeAt + 1]) != PROBE_MAGIC)
+        {
+            continue;
+        }
+        const uint8_t* probe = d + probeAt;
+        uint32_t flow = Net32(probe + PROBE_FLOW_OFFSET);
+        uint32_t seq = Net32(probe + PROBE_SEQ_OFFSET);
+        uint64_t txNs = (uint64_t(Net32(probe + PROBE_TX_OFFSET)) << 32) | Net32(probe + PROBE_TX_OFFSET + 4);
+        uint64_t key = uint64_t(flow) * 2 + (probe[PROBE_KIND_OFFSET] == PROBE_ECHO_REPLY);
+        capture.probes++;
+
+        // Frames of a flow come in runs, most frames skip the lookup. Containers only grow,
+        // geometrically, so nothing is allocated per frame.
+        if (key != lastKey || !last)
+        {
+            last = &capture.sides[key];
+            lastKey = key;
+        }
+        Side& side = *last;
+        if (side.frames == 0)
+        {
+            side.srcMac = Mac(d + 6);
+            side.dstMac = Mac(d);
+            side.srcIp = Net32(d + 26);
+            side.dstIp = Net32(d + 30);
+            side.firstNs = rec.timeNs;
+        }
+        side.frames++;
+        side.bytes += rec.origLen;
+        side.lastNs = rec.timeNs;
+        side.seqs.push_back(SeqTime{seq, rec.timeNs});
+        side.probeDelay.Record(rec.timeNs > txNs ? rec.timeNs - txNs : 0);
+    }
+
+    // Sorted by sequence number, a sequence number captured more than once keeps its first frame.
+    // Memory follows the frames captured, whatever sequence numbers they carry.
+    std::map<uint64_t, uint64_t> seen;
+    for (auto& entry : capture.sides)
+    {
+        Side& side = entry.second;
+        std::stable_sort(side.seqs.begin(), side.seqs.end(), [](const SeqTime& a, const SeqTime& b) { return a.seq < b.seq; });
+        side.seqs.erase(std::unique(side.seqs.begin(), side.seqs.end(), [](const SeqTime& a, const SeqTime& b) { return a.seq == b.seq; }),
+                        side.seqs.end());
+        side.seqs.shrink_to_fit();
+        // Fallback owner: the endpoint is in every frame of its capture, as the sender or the receiver
+        seen[side.srcMac] += side.frames;
+        seen[side.dstMac] += side.frames;
+    }
+    uint64_t most = 0;
+    for (const auto& kv : seen)
+    {
+        if (kv.second > most)
+        {
+            most = kv.second;
+            capture.owner = kv.first;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    auto op = popl::OptionParser("Allowed Options");
+    auto jobsOpt = op.add<popl::Value<int>>("j", "jobs", "int: captures analyzed at once, one thread each, 0 uses all cores", 0);
+    auto csvOpt = op.add<popl::Value<std::string>>("o", "csv", "String: per flow results table (CSV), empty to skip", "pcap-flows.csv");
+    auto printFlowsOpt = op.add<popl::Value<int>>("", "printFlows", "int: flows listed individually", 100);
+    auto helpOpt = op.add<popl::Switch>("h", "help", "Print this help message");
+
+    try
+    {
+        op.parse(argc, argv);
+        if (helpOpt->is_set())
+        {
+            std::cout << op << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error parsing arguments: " << e.what() << std::endl;
+        std::cout << op << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> paths = op.non_option_args();
+    if (paths.empty())
+    {
+        glob_t found;
+        if (glob("endpoint-*.pcap", 0, nullptr, &found) == 0)
+        {
+            paths.assign(found.gl_pathv, found.gl_pathv + found.gl_pathc);
+        }
+        globfree(&found);
+    }
+    if (paths.empty())
+    {
+        std::cerr << "ERROR: no captures given and no endpoint-*.pcap here, run rawudpnet with --trace=full" << std::endl;
+        return 1;
+    }
+
+    // One thread per capture, at most --jobs at a time
+    std::vector<Capture> captures(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        captures[i].path = paths[i];
+    }
+    unsigned workers = jobsOpt->value() > 0 ? jobsOpt->value() : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<unsigned>(workers, captures.size());
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < workers; w++)
+    {
+        threads.emplace_back([&]() {
+            for (size_t i; (i = next.fetch_add(1)) < captures.size();)
+            {
+                Analyze(captures[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    // Captures holding each key, in key order
+    uint64_t totalBytes = 0;
+    int failed = 0;
+    std::map<uint64_t, std::vector<Capture*>> keys;
+    for (Capture& capture : captures)
+    {
+        if (!capture.error.empty())
+        {
+            std::cerr << "ERROR: " << capture.error << std::endl;
+            failed++;
+            continue;
+        }
+        totalBytes += capture.bytes;
+        for (const auto& entry : capture.sides)
+        {
+            keys[entry.first].push_back(&capture);
+        }
+    }
+
+    // Learn the captures' MACs from flows seen in two of them, the sender captured them first
+    for (const auto& entry : keys)
+    {
+        if (entry.second.size() < 2)
+        {
+            continue;
+        }
+        Capture& first = *entry.second[0];
+        Capture& second = *entry.second[1];
+        const Side& a = first.sides.at(entry.first);
+        const Side& b = second.sides.at(entry.first);
+        // Compare at the first sequence number both captured
+        bool aFirst = a.firstNs <= b.firstNs;
+        for (size_t i = 0, j = 0; i < a.seqs.size() && j < b.seqs.size();)
+        {
+            if (a.seqs[i].seq == b.seqs[j].seq)
+            {
+                aFirst = a.seqs[i].timeNs <= b.seqs[j].timeNs;
+                break;
+            }
+            a.seqs[i].seq < b.seqs[j].seq ? i++ : j++;
+        }
+        Capture& tx = aFirst ? first : second;
+        Capture& rx = aFirst ? second : first;
+        if (!tx.ownerKnown)
+        {
+            tx.owner = a.srcMac;
+            tx.ownerKnown = true;
+        }
+        if (!rx.ownerKnown)
+        {
+            rx.owner = a.dstMac;
+            rx.ownerKnown = true;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Analyzed " << captures.size() - failed << " captures, " << totalBytes / 1e6 << " MB in " << wall.count() << "s ("
+              << (wall.count() > 0 ? totalBytes / 1e6 / wall.count() : 0.0) << " MB/s) on " << workers << " threads" << std::endl;
+    for (const Capture& capture : captures)
+    {
+        if (capture.error.empty())
+        {
+            std::cout << "    " << capture.path << ": " << capture.frames << " frames, " << capture.probes << " probes, endpoint "
+                      << MacString(capture.owner) << (capture.ownerKnown ? "" : " (guessed)") << std::endl;
+        }
+    }
+
+    FILE* csv = nullptr;
+    if (!csvOpt->value().empty())
+    {
+        csv = std::fopen(csvOpt->value().c_str(), "w");
+        if (!csv)
+        {
+            std::cerr << "ERROR: could not open " << csvOpt->value() << std::endl;
+            return 1;
+        }
+        std::fprintf(csv, "flow,direction,src_ip,dst_ip,tx_capture,rx_capture,sent,received,lost,loss_pct,rx_bytes,throughput_bps,"
+                          "delay_mean_ns,delay_p50_ns,delay_p99_ns,delay_max_ns\n");
+    }
+
+    // Match each flow direction's sent frames in one capture with its received frames in another
+    uint64_t totalSent = 0;
+    uint64_t totalReceived = 0;
+    uint64_t totalLost = 0;
+    int printed = 0;
+    for (const auto& entry : keys)
+    {
+        uint64_t key = entry.first;
+        const Side* tx = nullptr;
+        const Side* rx = nullptr;
+        const Capture* txCapture = nullptr;
+        const Capture* rxCapture = nullptr;
+        for (const Capture* capture : entry.second)
+        {
+            const Side& side = capture->sides.at(key);
+            if (side.srcMac == capture->owner && !tx)
+            {
+                tx = &side;
+                txCapture = capture;
+            }
+            else if (side.dstMac == capture->owner && !rx)
+            {
+                rx = &side;
+                rxCapture = capture;
+            }
+        }
+        if (!tx && !rx)
+        {
+            continue;
+        }
+
+        uint64_t sent = 0;
+        uint64_t received = 0;
+        uint64_t lost = 0;
+        LatencyHistogram delay;
+        sent = tx ? tx->seqs.size() : 0;
+        received = rx ? rx->seqs.size() : 0;
+        if (tx && rx)
+        {
+            // Both are sorted by sequence number
+            size_t j = 0;
+            for (const SeqTime& sentAt : tx->seqs)
+            {
+                while (j < rx->seqs.size() && rx->seqs[j].seq < sentAt.seq)
+                {
+                    j++;
+                }
+                if (j == rx->seqs.size() || rx->seqs[j].seq != sentAt.seq)
+                {
+                    lost++;
+                    continue;
+                }
+                uint64_t receivedNs = rx->seqs[j].timeNs;
+                delay.Record(receivedNs > sentAt.timeNs ? receivedNs - sentAt.timeNs : 0);
+            }
+        }
+        else if (rx)
+        {
+            delay = rx->probeDelay;
+        }
+        totalSent += sent;
+        totalReceived += received;
+        totalLost += lost;
+
+        const Side& any = tx ? *tx : *rx;
+        uint64_t rxBytes = rx ? rx->bytes : 0;
+        double span = rx && rx->lastNs > rx->firstNs ? (rx->lastNs - rx->firstNs) / 1e9 : 0.0;
+        double bps = span > 0 ? rxBytes * 8 / span : 0.0;
+        double lossPct = tx && rx && sent ? 100.0 * lost / sent : 0.0;
+        const char* direction = key % 2 ? "reply" : "data";
+        if (printed < printFlowsOpt->value())
+        {
+            printed++;
+            std::cout << "Flow " << key / 2 << (key % 2 ? " replies" : "") << " (" << IpString(any.srcIp) << "->" << IpString(any.dstIp) << "): ";
+            if (tx)
+            {
+                std::cout << sent << " sent, ";
+            }
+            if (rx)
+            {
+                std::cout << received << " received, ";
+            }
+            if (tx && rx)
+            {
+                std::cout << lost << " lost (" << lossPct << "%), ";
+            }
+            std::cout << bps / 1e6 << " Mbps, delay ms mean " << delay.GetMean() / 1e6 << " p50 " << delay.Percentile(0.5) / 1e6
+                      << " p99 " << delay.Percentile(0.99) / 1e6 << " max " << delay.GetMax() / 1e6
+                      << (!tx ? ", sender not captured, delay from the probe" : !rx ? ", receiver not captured" : "") << std::endl;
+        }
+        if (csv)
+        {
+            std::fprintf(csv, "%llu,%s,%s,%s,%s,%s,%llu,%llu,%llu,%.3f,%llu,%.0f,%.0f,%llu,%llu,%llu\n", (unsigned long long)(key / 2), direction,
+                         IpString(any.srcIp).c_str(), IpString(any.dstIp).c_str(), txCapture ? txCapture->path.c_str() : "",
+                         rxCapture ? rxCapture->path.c_str() : "", (unsigned long long)sent, (unsigned long long)received,
+                         (unsigned long long)lost, lossPct, (unsigned long long)rxBytes, bps, delay.GetMean(),
+                         (unsigned long long)delay.Percentile(0.5), (unsigned long long)delay.Percentile(0.99),
+                         (unsigned long long)delay.GetMax());
+        }
+    }
+    std::cout << "Total: " << totalSent << " sent, " << totalReceived << " received, " << totalLost << " lost" << std::endl;
+    if (csv)
+    {
+        std::fclose(csv);
+        std::cout << "Wrote per flow results to " << csvOpt->value() << std::endl;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Writes rawudpnet scenario files (see ScenarioFormat.h).
+ *
+ * Generates random flows between endpoints 0..N-1 with uniformly distributed start times,
+ * or with --pack converts an existing text scenario to the binary form.
+ *
+ * Examples:
+ *   scengen --flows 100000 --endpoints 256 --duration 60 --binary --out flows.bin
+ *   scengen --pack flows.txt --out flows.bin
+ */
+
+#include "external/popl.hpp"
+#include "ScenarioFormat.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+static bool WriteFlow(FILE* out, bool binary, const FlowSpec& spec)
+{
+    if (binary)
+    {
+        return std::fwrite(&spec, sizeof(spec), 1, out) == 1;
+    }
+    std::string rate = spec.rateBps ? std::to_string(spec.rateBps) + "bps" : "-";
+    return std::fprintf(out, "%u %u %.9f %u %u %.9f %u %.9f %s %s\n", spec.src, spec.dst, spec.start, spec.numPkts,
+                        spec.pktSize, spec.interval, spec.burst, spec.burstGap, rate.c_str(),
+                        SCENARIO_ARRIVALS[spec.arrival]) > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    auto op = popl::OptionParser("Allowed Options");
+    auto flowsOpt = op.add<popl::Value<int>>("n", "flows", "int: flows to generate", 1000);
+    auto endpointsOpt = op.add<popl::Value<int>>("e", "endpoints", "int: flows run between random distinct endpoints 0..N-1", 16);
+    auto durationOpt = op.add<popl::Value<double>>("d", "duration", "double: start times are uniform over [0, duration) (s)", 10.0);
+    auto numPktsOpt = op.add<popl::Value<int>>("", "numPkts", "int: packets per flow", 10);
+    auto pktSizeOpt = op.add<popl::Value<int>>("", "pktSize", "int: packet size (bytes)", 1024);
+    auto intervalOpt = op.add<popl::Value<double>>("", "interval", "double: interval between packet sends (s)", 0.01);
+    auto seedOpt = op.add<popl::Value<int>>("s", "seed", "int: random seed", 1);
+    auto packOpt = op.add<popl::Value<std::string>>("p", "pack", "String: convert this text scenario to the binary form instead of generating", "");
+    auto binaryOpt = op.add<popl::Switch>("b", "binary", "Write the binary form");
+    auto outOpt = op.add<popl::Value<std::string>>("o", "out", "String: output file", "scenario.txt");
+    auto helpOpt = op.add<popl::Switch>("h", "help", "Print this help message");
+
+    try
+    {
+        op.parse(argc, argv);
+        if (helpOpt->is_set())
+        {
+            std::cout << op << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error parsing arguments: " << e.what() << std::endl;
+        std::cout << op << std::endl;
+        return 1;
+    }
+
+    bool binary = binaryOpt->is_set() || !packOpt->value().empty();
+    FILE* out = std::fopen(outOpt->value().c_str(), binary ? "wb" : "w");
+    if (!out)
+    {
+        std::cerr << "ERROR: could not open " << outOpt->value() << std::endl;
+        return 1;
+    }
+    if (binary)
+    {
+        std::fwrite(SCENARIO_MAGIC, 1, sizeof(SCENARIO_MAGIC), out);
+    }
+
+    uint64_t written = 0;
+    bool ok = true;
+    if (!packOpt->value().empty())
+    {
+        FILE* in = std::fopen(packOpt->value().c_str(), "r");
+        if (!in)
+        {
+            std::cerr << "ERROR: could not open " << packOpt->value() << std::endl;
+            std::fclose(out);
+            return 1;
+        }
+        char* line = nullptr;
+        size_t cap = 0;
+        uint64_t lineNo = 0;
+        double lastStart = 0;
+        std::string error;
+        FlowSpec spec;
+        while (ok && getline(&line, &cap, in) != -1)
+        {
+            lineNo++;
+            int result = ParseFlowLine(line, spec, error);
+            if (result == 0)
+            {
+                continue;
+            }
+            if (result < 0 || spec.start < lastStart)
+            {
+                std::cerr << "ERROR: " << packOpt->value() << ":" << lineNo << ": "
+                          << (result < 0 ? error : "flows must be sorted by start time") << std::endl;
+                ok = false;
+                break;
+            }
+            lastStart = spec.start;
+            ok = WriteFlow(out, true, spec);
+            written++;
+        }
+        std::free(line);
+        std::fclose(in);
+    }
+    else
+    {
+        if (endpointsOpt->value() < 2)
+        {
+            std::cerr << "ERROR: need at least 2 endpoints" << std::endl;
+            std::fclose(out);
+            return 1;
+        }
+        std::mt19937_64 rng(seedOpt->value());
+        std::uniform_real_distribution<double> startDist(0.0, durationOpt->value());
+        std::uniform_int_distribution<uint32_t> nodeDist(0, endpointsOpt->value() - 1);
+
+        // Starts are drawn first and sorted, the reader requires start time order
+        std::vector<double> starts(std::max(flowsOpt->value(), 0));
+        for (double& start : starts)
+        {
+            start = startDist(rng);
+        }
+        std::sort(starts.begin(), starts.end());
+
+        FlowSpec spec;
+        spec.numPkts = numPktsOpt->value();
+        spec.pktSize = pktSizeOpt->value();
+        spec.interval = intervalOpt->value();
+        for (size_t i = 0; ok && i < starts.size(); i++)
+        {
+            spec.start = starts[i];
+            spec.src = nodeDist(rng);
+            do
+            {
+                spec.dst = nodeDist(rng);
+            } while (spec.dst == spec.src);
+            ok = WriteFlow(out, binary, spec);
+            written++;
+        }
+    }
+
+    if (std::fclose(out) != 0 || !ok)
+    {
+        std::cerr << "ERROR: writing " << outOpt->value() << " failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << written << " flows to " << outOpt->value() << std::endl;
+    return 0;
+}
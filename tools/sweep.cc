@@ -0,0 +1,276 @@
+/*
+ * Parameter sweep and replication driver for rawudpnet.
+ *
+ * Expands a grid of rawudpnet options, runs every grid point once per seed (each with
+ * its own --rngRun) in parallel worker processes, and merges the per run statistics
+ * into one table with means and 95% confidence intervals across seeds.
+ *
+ * Example:
+ *   sweep --bin ./build/rawudpnet --jobs 64 --seeds 10 \
+ *         --grid "rate=1Mbps,1.5Mbps,2Mbps" --grid "pktSize=512,1024" --grid "queueSize=50p,100p" \
+ *         -- --initiator="0 1" --target="4 5" --numPkts="100000 100000" --simEnd=30
+ */
+
+#include "external/popl.hpp"
+#include "ProcessPool.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits.h>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+struct GridAxis
+{
+    std::string option;
+    std::vector<std::string> values;
+};
+
+struct Run
+{
+    size_t point = 0;                   // Grid point index
+    int seed = 0;                       // --rngRun value
+    bool ok = false;                    // Run exited cleanly and wrote its statistics
+    std::map<std::string, double> stats = {};
+};
+
+// Two sided 95% Student t quantiles for 1..30 degrees of freedom, normal beyond
+static double TQuantile95(size_t df)
+{
+    static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0)
+    {
+        return 0.0;
+    }
+    return df <= 30 ? table[df - 1] : 1.960;
+}
+
+static bool ParseAxis(const std::string& spec, GridAxis& axis)
+{
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0)
+    {
+        return false;
+    }
+    axis.option = spec.substr(0, eq);
+    std::istringstream stream(spec.substr(eq + 1));
+    std::string value;
+    while (std::getline(stream, value, ','))
+    {
+        axis.values.push_back(value);
+    }
+    return !axis.values.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    auto op = popl::OptionParser("Allowed Options");
+    auto binOpt = op.add<popl::Value<std::string>>("b", "bin", "String: rawudpnet executable", "./rawudpnet");
+    auto jobsOpt = op.add<popl::Value<int>>("j", "jobs", "int: concurrent runs, 0 uses all cores", 0);
+    auto seedsOpt = op.add<popl::Value<int>>("s", "seeds", "int: replications per grid point, each with its own --rngRun", 5);
+    auto firstSeedOpt = op.add<popl::Value<int>>("", "firstSeed", "int: --rngRun of the first replication", 1);
+    auto gridOpt = op.add<popl::Value<std::string>>("g", "grid", "String: option=value1,value2,... (repeatable), swept as a cartesian product");
+    auto runDirOpt = op.add<popl::Value<std::string>>("d", "runDir", "String: directory holding one subdirectory per run", "sweep-runs");
+    auto resultsOpt = op.add<popl::Value<std::string>>("o", "results", "String: merged results table (CSV)", "sweep-results.csv");
+    auto helpOpt = op.add<popl::Switch>("h", "help", "Print this help message");
+
+    // Everything after "--" is passed to every run unchanged
+    int sweepArgc = argc;
+    std::vector<std::string> fixedArgs;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--")
+        {
+            sweepArgc = i;
+            fixedArgs.assign(argv + i + 1, argv + argc);
+            break;
+        }
+    }
+
+    try
+    {
+        op.parse(sweepArgc, argv);
+        if (helpOpt->is_set())
+        {
+            std::cout << "sweep [options] -- [fixed rawudpnet options]" << std::endl << op << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error parsing arguments: " << e.what() << std::endl;
+        std::cout << op << std::endl;
+        return 1;
+    }
+
+    char binPath[PATH_MAX];
+    if (!realpath(binOpt->value().c_str(), binPath))
+    {
+        std::cerr << "ERROR: cannot find " << binOpt->value() << std::endl;
+        return 1;
+    }
+
+    std::vector<GridAxis> axes;
+    for (size_t i = 0; i < gridOpt->count(); i++)
+    {
+        GridAxis axis;
+        if (!ParseAxis(gridOpt->value(i), axis))
+        {
+            std::cerr << "ERROR: grid axes look like option=value1,value2: " << gridOpt->value(i) << std::endl;
+            return 1;
+        }
+        axes.push_back(axis);
+    }
+
+    // Expand the cartesian product of all axes into grid points
+    std::vector<std::vector<std::string>> points(1);
+    for (const GridAxis& axis : axes)
+    {
+        std::vector<std::vector<std::string>> expanded;
+        for (const auto& point : points)
+        {
+            for (const std::string& value : axis.values)
+            {
+                expanded.push_back(point);
+                expanded.back().push_back(value);
+            }
+        }
+        points.swap(expanded);
+    }
+
+    ::mkdir(runDirOpt->value().c_str(), 0755);
+    char runDir[PATH_MAX];
+    if (!realpath(runDirOpt->value().c_str(), runDir))
+    {
+        std::cerr << "ERROR: cannot create " << runDirOpt->value() << std::endl;
+        return 1;
+    }
+
+    std::vector<ProcessJob> jobs;
+    std::vector<Run> runs;
+    for (size_t p = 0; p < points.size(); p++)
+    {
+        for (int s = 0; s < seedsOpt->value(); s++)
+        {
+            int seed = firstSeedOpt->value() + s;
+            ProcessJob job;
+            job.dir = std::string(runDir) + "/p" + std::to_string(p) + "-s" + std::to_string(seed);
+            job.log = "run.log";
+            job.args.push_back(binPath);
+            for (const std::string& arg : fixedArgs)
+            {
+                job.args.push_back(arg);
+            }
+            for (size_t a = 0; a < axes.size(); a++)
+            {
+                job.args.push_back("--" + axes[a].option + "=" + points[p][a]);
+            }
+            job.args.push_back("--rngRun=" + std::to_string(seed));
+            job.args.push_back("--statsOut=stats.txt");
+            jobs.push_back(job);
+            runs.push_back(Run{p, seed});
+        }
+    }
+
+    unsigned workers = jobsOpt->value() > 0 ? jobsOpt->value() : sysconf(_SC_NPROCESSORS_ONLN);
+    std::cout << "Running " << jobs.size() << " simulations (" << points.size() << " grid points x " << seedsOpt->value()
+              << " seeds) on " << workers << " workers" << std::endl;
+
+    size_t done = 0;
+    ProcessPool pool(workers);
+    pool.Run(jobs, [&](size_t i, const ProcessResult& result) {
+        done++;
+        if (result.exitCode == 0)
+        {
+            runs[i].stats = ReadStats(jobs[i].dir + "/stats.txt");
+            runs[i].ok = !runs[i].stats.empty();
+        }
+        std::cout << "[" << done << "/" << jobs.size() << "] " << jobs[i].dir << (runs[i].ok ? " ok " : " FAILED ")
+                  << result.wallSeconds << "s" << std::endl;
+    });
+
+    // Merge: one row per grid point, mean and 95% CI half width of every metric across seeds
+    std::set<std::string> metrics;
+    for (const Run& run : runs)
+    {
+        for (const auto& kv : run.stats)
+        {
+            metrics.insert(kv.first);
+        }
+    }
+
+    std::ofstream out(resultsOpt->value());
+    for (const GridAxis& axis : axes)
+    {
+        out << axis.option << ",";
+    }
+    out << "runs";
+    for (const std::string& metric : metrics)
+    {
+        out << "," << metric << "_mean," << metric << "_ci95";
+    }
+    out << "\n";
+
+    size_t failed = 0;
+    for (size_t p = 0; p < points.size(); p++)
+    {
+        std::map<std::string, std::vector<double>> samples;
+        size_t okRuns = 0;
+        for (const Run& run : runs)
+        {
+            if (run.point != p)
+            {
+                continue;
+            }
+            if (!run.ok)
+            {
+                failed++;
+                continue;
+            }
+            okRuns++;
+            for (const auto& kv : run.stats)
+            {
+                samples[kv.first].push_back(kv.second);
+            }
+        }
+
+        for (const std::string& value : points[p])
+        {
+            out << value << ",";
+        }
+        out << okRuns;
+        for (const std::string& metric : metrics)
+        {
+            const std::vector<double>& v = samples[metric];
+            double mean = 0;
+            for (double x : v)
+            {
+                mean += x;
+            }
+            mean = v.empty() ? 0 : mean / v.size();
+            double var = 0;
+            for (double x : v)
+            {
+                var += (x - mean) * (x - mean);
+            }
+            double ci = v.size() > 1 ? TQuantile95(v.size() - 1) * std::sqrt(var / (v.size() - 1) / v.size()) : 0.0;
+            out << "," << mean << "," << ci;
+        }
+        out << "\n";
+    }
+
+    std::cout << "Wrote " << points.size() << " grid points to " << resultsOpt->value();
+    if (failed)
+    {
+        std::cout << " (" << failed << " runs failed, see run.log in their directories)";
+    }
+    std::cout << std::endl;
+    return failed ? 1 : 0;
+}